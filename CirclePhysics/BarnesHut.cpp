@@ -0,0 +1,293 @@
+#include "BarnesHut.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+// spreads the low 16 bits of v over the even bits
+static uint32_t spreadBits(uint32_t v) {
+	v &= 0xffff;
+	v = (v | (v << 8)) & 0x00ff00ff;
+	v = (v | (v << 4)) & 0x0f0f0f0f;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+static void forEachChunk(ThreadPool* pool, int count, const std::function<void(int, int)>& body) {
+	if (pool != nullptr) {
+		pool->parallelFor(count, body);
+	}
+	else {
+		body(0, count);
+	}
+}
+
+// force on a body at p with mass m and charge q from a source of mass M at
+// massCenter and charge Q at chargeCenter
+static inline Vector2 pairForce(Vector2 p, float m, float q, Vector2 massCenter, float M,
+	Vector2 chargeCenter, float Q, const ForceSettings& s) {
+	Vector2 force = Vector2();
+	float eps = s.softening * s.softening;
+	if (s.gravity != 0 && M != 0) {
+		Vector2 d = massCenter - p;
+		float r2 = dot(d, d) + eps;
+		force += d * (s.gravity * m * M / (r2 * std::sqrt(r2)));
+	}
+	if (s.coulomb != 0 && Q != 0 && q != 0) {
+		Vector2 d = chargeCenter - p;
+		float r2 = dot(d, d) + eps;
+		force -= d * (s.coulomb * q * Q / (r2 * std::sqrt(r2)));
+	}
+	return force;
+}
+
+void BarnesHutTree::build(const std::vector<Vector2>& positions, const std::vector<float>& masses,
+	const std::vector<float>& charges, ThreadPool* pool) {
+	auto start = std::chrono::steady_clock::now();
+	int n = (int)positions.size();
+	_stats = ForceStats();
+	_stats.bodies = n;
+	_nodes.clear();
+	if (n == 0) {
+		return;
+	}
+
+	float minX = positions[0].X, maxX = minX, minY = positions[0].Y, maxY = minY;
+	for (const Vector2& p : positions) {
+		minX = std::min(minX, p.X);
+		maxX = std::max(maxX, p.X);
+		minY = std::min(minY, p.Y);
+		maxY = std::max(maxY, p.Y);
+	}
+	_originX = minX;
+	_originY = minY;
+	_rootSize = std::max(std::max(maxX - minX, maxY - minY), 1.0f) * 1.0001f;
+
+	// Morton codes, then bodies sorted along the curve
+	_codes.resize(n);
+	_order.resize(n);
+	std::vector<uint32_t> unsorted(n);
+	float scale = 65535.0f / _rootSize;
+	forEachChunk(pool, n, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			uint32_t x = (uint32_t)((positions[i].X - _originX) * scale);
+			uint32_t y = (uint32_t)((positions[i].Y - _originY) * scale);
+			unsorted[i] = (spreadBits(x) << 1) | spreadBits(y);
+		}
+	});
+	std::iota(_order.begin(), _order.end(), 0);
+	std::sort(_order.begin(), _order.end(), [&](int a, int b) { return unsorted[a] < unsorted[b]; });
+	_positions.resize(n);
+	_masses.resize(n);
+	_charges.resize(n);
+	forEachChunk(pool, n, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			int o = _order[i];
+			_codes[i] = unsorted[o];
+			_positions[i] = positions[o];
+			_masses[i] = masses[o];
+			_charges[i] = charges[o];
+		}
+	});
+
+	if (pool == nullptr || n < BARNES_HUT_PARALLEL_BUILD) {
+		buildNode(_nodes, 0, n, 0);
+	}
+	else {
+		// the 16 second-level subtrees are independent, build them in parallel
+		std::vector<std::vector<Node>> parts(16);
+		std::vector<int> bounds(17);
+		for (uint32_t p = 0; p < 16; p++) {
+			bounds[p] = (int)(std::lower_bound(_codes.begin(), _codes.end(), p << 28) - _codes.begin());
+		}
+		bounds[16] = n;
+		pool->parallelFor(16, [&](int begin, int end) {
+			for (int p = begin; p < end; p++) {
+				if (bounds[p] < bounds[p + 1]) {
+					buildNode(parts[p], bounds[p], bounds[p + 1], 2);
+				}
+			}
+		}, 1);
+
+		_nodes.push_back(Node());
+		_nodes[0].size = _rootSize;
+		_nodes[0].begin = 0;
+		_nodes[0].end = n;
+		for (int q = 0; q < 4; q++) {
+			_nodes[0].children[q] = -1;
+			if (bounds[q * 4] == bounds[q * 4 + 4]) {
+				continue;
+			}
+			int quadrant = (int)_nodes.size();
+			_nodes[0].children[q] = quadrant;
+			_nodes.push_back(Node());
+			_nodes[quadrant].size = _rootSize / 2;
+			_nodes[quadrant].begin = bounds[q * 4];
+			_nodes[quadrant].end = bounds[q * 4 + 4];
+			for (int k = 0; k < 4; k++) {
+				std::vector<Node>& part = parts[q * 4 + k];
+				_nodes[quadrant].children[k] = -1;
+				if (part.empty()) {
+					continue;
+				}
+				int offset = (int)_nodes.size();
+				relocate(part, offset);
+				_nodes[quadrant].children[k] = offset;
+				_nodes.insert(_nodes.end(), part.begin(), part.end());
+			}
+			summarize(_nodes, quadrant);
+		}
+		summarize(_nodes, 0);
+	}
+	_stats.nodes = (int)_nodes.size();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	_stats.buildMilliseconds = elapsed.count();
+}
+
+int BarnesHutTree::buildNode(std::vector<Node>& nodes, int begin, int end, int depth) const {
+	int index = (int)nodes.size();
+	nodes.push_back(Node());
+	nodes[index].size = _rootSize / (1 << depth);
+	nodes[index].begin = begin;
+	nodes[index].end = end;
+	for (int q = 0; q < 4; q++) {
+		nodes[index].children[q] = -1;
+	}
+	if (end - begin > BARNES_HUT_LEAF_SIZE && depth < BARNES_HUT_MAX_DEPTH) {
+		int shift = 30 - 2 * depth;
+		int childBegin = begin;
+		for (int q = 0; q < 4; q++) {
+			// codes are sorted, so each quadrant is a contiguous run
+			int childEnd = (int)(std::partition_point(_codes.begin() + childBegin, _codes.begin() + end,
+				[&](uint32_t code) { return (int)((code >> shift) & 3) <= q; }) - _codes.begin());
+			if (childEnd > childBegin) {
+				int child = buildNode(nodes, childBegin, childEnd, depth + 1);
+				nodes[index].children[q] = child;
+			}
+			childBegin = childEnd;
+		}
+	}
+	summarize(nodes, index);
+	return index;
+}
+
+void BarnesHutTree::summarize(std::vector<Node>& nodes, int index) const {
+	Node& node = nodes[index];
+	Vector2 massMoment = Vector2();
+	Vector2 chargeMoment = Vector2();
+	node.mass = 0;
+	node.charge = 0;
+	node.absCharge = 0;
+	bool leaf = true;
+	for (int q = 0; q < 4; q++) {
+		int c = node.children[q];
+		if (c < 0) {
+			continue;
+		}
+		leaf = false;
+		const Node& child = nodes[c];
+		massMoment += child.centerOfMass * child.mass;
+		chargeMoment += child.centerOfCharge * child.absCharge;
+		node.mass += child.mass;
+		node.charge += child.charge;
+		node.absCharge += child.absCharge;
+	}
+	if (leaf) {
+		for (int i = node.begin; i < node.end; i++) {
+			massMoment += _positions[i] * _masses[i];
+			chargeMoment += _positions[i] * std::abs(_charges[i]);
+			node.mass += _masses[i];
+			node.charge += _charges[i];
+			node.absCharge += std::abs(_charges[i]);
+		}
+	}
+	node.centerOfMass = node.mass != 0 ? massMoment / node.mass : _positions[node.begin];
+	node.centerOfCharge = node.absCharge != 0 ? chargeMoment / node.absCharge : node.centerOfMass;
+}
+
+void BarnesHutTree::relocate(std::vector<Node>& nodes, int offset) {
+	for (Node& node : nodes) {
+		for (int q = 0; q < 4; q++) {
+			if (node.children[q] >= 0) {
+				node.children[q] += offset;
+			}
+		}
+	}
+}
+
+void BarnesHutTree::computeForces(const ForceSettings& settings, std::vector<Vector2>& forces, ThreadPool* pool) {
+	auto start = std::chrono::steady_clock::now();
+	int n = (int)_positions.size();
+	forces.assign(n, Vector2());
+	if (n == 0) {
+		return;
+	}
+	float theta2 = settings.theta * settings.theta;
+	std::atomic<long long> interactions(0);
+	forEachChunk(pool, n, [&](int begin, int end) {
+		std::vector<int> stack;
+		long long local = 0;
+		for (int i = begin; i < end; i++) {
+			Vector2 p = _positions[i];
+			float m = _masses[i];
+			float q = _charges[i];
+			Vector2 force = Vector2();
+			stack.clear();
+			stack.push_back(0);
+			while (!stack.empty()) {
+				const Node& node = _nodes[stack.back()];
+				stack.pop_back();
+				Vector2 d = node.centerOfMass - p;
+				float dist2 = dot(d, d);
+				bool leaf = node.children[0] < 0 && node.children[1] < 0 && node.children[2] < 0 && node.children[3] < 0;
+				if (leaf) {
+					for (int j = node.begin; j < node.end; j++) {
+						if (j != i) {
+							force += pairForce(p, m, q, _positions[j], _masses[j], _positions[j], _charges[j], settings);
+						}
+					}
+					local += node.end - node.begin;
+				}
+				else if (node.size * node.size < theta2 * dist2) {
+					force += pairForce(p, m, q, node.centerOfMass, node.mass, node.centerOfCharge, node.charge, settings);
+					local++;
+				}
+				else {
+					for (int c = 0; c < 4; c++) {
+						if (node.children[c] >= 0) {
+							stack.push_back(node.children[c]);
+						}
+					}
+				}
+			}
+			forces[_order[i]] = force;
+		}
+		interactions += local;
+	});
+	_stats.interactions = interactions;
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	_stats.traverseMilliseconds = elapsed.count();
+}
+
+void BarnesHutTree::computeDirect(const std::vector<Vector2>& positions, const std::vector<float>& masses,
+	const std::vector<float>& charges, const ForceSettings& settings, std::vector<Vector2>& forces, ThreadPool* pool) {
+	int n = (int)positions.size();
+	forces.assign(n, Vector2());
+	forEachChunk(pool, n, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			Vector2 force = Vector2();
+			for (int j = 0; j < n; j++) {
+				if (j != i) {
+					force += pairForce(positions[i], masses[i], charges[i], positions[j], masses[j], positions[j], charges[j], settings);
+				}
+			}
+			forces[i] = force;
+		}
+	});
+}
+
+const ForceStats& BarnesHutTree::getStats() const {
+	return _stats;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "ThreadPool.h"
+#include "Vector2.h"
+#include <cstdint>
+#include <vector>
+
+#define BARNES_HUT_LEAF_SIZE 8
+#define BARNES_HUT_MAX_DEPTH 16
+// below this many bodies the tree is built on the calling thread
+#define BARNES_HUT_PARALLEL_BUILD 4096
+
+struct ForceSettings {
+	bool enabled = false;
+	// pull between masses, like gravity
+	float gravity = 0;
+	// push between like charges, pull between opposite ones
+	float coulomb = 0;
+	// added to squared distances so close pairs stay finite
+	float softening = 4;
+	// opening angle, 0 makes the tree walk exact
+	float theta = 0.5f;
+};
+
+struct ForceStats {
+	int bodies = 0;
+	int nodes = 0;
+	long long interactions = 0;
+	double buildMilliseconds = 0;
+	double traverseMilliseconds = 0;
+};
+
+// Quadtree over Morton-sorted bodies for long-range forces. A cell seen from
+// far enough away (size / distance < theta) acts as one body at its center of
+// mass (for gravity) and center of charge (for the charge force). The tree is
+// rebuilt every step; the subtrees below the second level are built in
+// parallel and every body's walk is independent.
+class BarnesHutTree {
+public:
+	void build(const std::vector<Vector2>& positions, const std::vector<float>& masses,
+		const std::vector<float>& charges, ThreadPool* pool);
+	void computeForces(const ForceSettings& settings, std::vector<Vector2>& forces, ThreadPool* pool);
+	// O(n^2) reference for checking the tree against
+	static void computeDirect(const std::vector<Vector2>& positions, const std::vector<float>& masses,
+		const std::vector<float>& charges, const ForceSettings& settings, std::vector<Vector2>& forces, ThreadPool* pool);
+	const ForceStats& getStats() const;
+private:
+	struct Node {
+		Vector2 centerOfMass;
+		float mass;
+		Vector2 centerOfCharge;
+		float charge;
+		float absCharge;
+		float size;
+		int children[4];
+		// range in sorted order, only used by leaves
+		int begin;
+		int end;
+	};
+	int buildNode(std::vector<Node>& nodes, int begin, int end, int depth) const;
+	void summarize(std::vector<Node>& nodes, int index) const;
+	static void relocate(std::vector<Node>& nodes, int offset);
+
+	float _originX = 0;
+	float _originY = 0;
+	float _rootSize = 0;
+	std::vector<Node> _nodes;
+	std::vector<uint32_t> _codes;
+	std::vector<int> _order;
+	std::vector<Vector2> _positions;
+	std::vector<float> _masses;
+	std::vector<float> _charges;
+	ForceStats _stats;
+};
@@ -0,0 +1,143 @@
+#include "BatchRunner.h"
+#include "Enemy.h"
+#include "SceneGenerator.h"
+#include <chrono>
+#include <string>
+
+// One of the eight directions the arrow keys give, or none, for the player's
+// turn-th change of direction
+static Vector2 playerDirection(unsigned int seed, int turn) {
+	uint32_t key[2] = { seed, 0 };
+	// makeBody draws with the last word 0
+	uint32_t counter[4] = { (uint32_t)turn, 0, 0, 1 };
+	uint32_t bits[4];
+	philox(counter, key, bits);
+	return Vector2{ (float)(bits[0] % 3) - 1, (float)(bits[1] % 3) - 1 };
+}
+
+BatchRunner::BatchRunner(ThreadPool& pool) : _pool(pool) {}
+
+void BatchRunner::addWorld(const WorldConfig& config) {
+	_configs.push_back(config);
+}
+
+void BatchRunner::addSweep(const WorldConfig& base, const std::vector<float>& restitutions, const std::vector<float>& frictions, int seeds) {
+	for (float restitution : restitutions) {
+		for (float friction : frictions) {
+			for (int seed = 0; seed < seeds; seed++) {
+				WorldConfig config = base;
+				config.seed = base.seed + seed;
+				config.physics.restitution = restitution;
+				config.physics.frictionEnabled = friction > 0;
+				config.physics.frictionCoefficient = friction;
+				_configs.push_back(config);
+			}
+		}
+	}
+}
+
+void BatchRunner::run() {
+	auto start = std::chrono::steady_clock::now();
+	_results.assign(_configs.size(), WorldResult());
+	_pool.parallelFor((int)_configs.size(), [this](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			_results[i] = runWorld(_configs[i]);
+		}
+	}, 1);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	_wallMilliseconds = elapsed.count();
+}
+
+WorldResult BatchRunner::runWorld(const WorldConfig& config) {
+	auto start = std::chrono::steady_clock::now();
+	BasicModel<RuntimePhysics> m(config.width, config.height, config.physics);
+
+	// the default settings are the random scene in GameLoop
+	SceneSettings scene;
+	scene.seed = config.seed;
+	scene.bodies = config.enemies;
+	scene.width = (float)config.width;
+	scene.height = (float)config.height;
+	std::vector<Entity*> owned;
+	NameId name = NamePool::intern("enemy");
+	for (int i = 0; i < config.enemies; i++) {
+		SceneBody b = SceneGenerator::makeBody(scene, i);
+		Collider c = Collider(b.pos, b.vel, b.size, b.mass);
+		c.setLayer(LAYER_ENEMY);
+		Enemy* e = new Enemy(c, name);
+		m.addEntity(e);
+		owned.push_back(e);
+	}
+	Vector2 startPos{ config.width / 2.0f, config.height / 2.0f };
+	Collider hitbox = Collider(startPos, Vector2(), scene.minSize, 1);
+	hitbox.setLayer(LAYER_PLAYER);
+	Player* p = new Player(hitbox, "Player");
+	p->setLogging(false);
+	m.addEntity(p);
+	m.setPlayer(p);
+	owned.push_back(p);
+
+	if (config.steering) {
+		SteeringSettings& steering = m.getSteering().getSettings();
+		steering.enabled = true;
+		steering.layers = LAYER_ENEMY;
+	}
+
+	WorldResult result;
+	result.seed = config.seed;
+	double time = 0;
+	int turn = -1;
+	Vector2 dir;
+	while (p->getActive() && time < config.maxTime) {
+		if (config.turnInterval > 0 && (int)(time / config.turnInterval) != turn) {
+			turn = (int)(time / config.turnInterval);
+			dir = playerDirection(config.seed, turn);
+		}
+		m.update(config.timestep, dir);
+		time += config.timestep;
+		result.steps++;
+	}
+	result.survived = p->getActive();
+	result.survivalTime = time;
+	result.finalHealth = p->getHealth();
+	for (Entity* e : owned) {
+		delete e;
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	result.wallMilliseconds = elapsed.count();
+	return result;
+}
+
+const std::vector<WorldResult>& BatchRunner::getResults() const {
+	return _results;
+}
+
+double BatchRunner::getWallMilliseconds() const {
+	return _wallMilliseconds;
+}
+
+void BatchRunner::writeCsv(std::ostream& out) const {
+	out << "seed,restitution,friction,survived,survival_time,steps,final_health,wall_ms\n";
+	for (int i = 0; i < _results.size(); i++) {
+		const WorldConfig& c = _configs[i];
+		const WorldResult& r = _results[i];
+		out << r.seed << ',' << c.physics.restitution << ',' << (c.physics.frictionEnabled ? c.physics.frictionCoefficient : 0) << ','
+			<< (r.survived ? 1 : 0) << ',' << r.survivalTime << ',' << r.steps << ',' << r.finalHealth << ','
+			<< r.wallMilliseconds << '\n';
+	}
+}
+
+void BatchRunner::writeJson(std::ostream& out) const {
+	out << "{\n  \"wall_ms\": " << _wallMilliseconds << ",\n  \"threads\": " << _pool.getThreadCount() << ",\n  \"worlds\": [\n";
+	for (int i = 0; i < _results.size(); i++) {
+		const WorldConfig& c = _configs[i];
+		const WorldResult& r = _results[i];
+		out << "    {\"seed\": " << r.seed << ", \"restitution\": " << c.physics.restitution
+			<< ", \"friction\": " << (c.physics.frictionEnabled ? c.physics.frictionCoefficient : 0)
+			<< ", \"survived\": " << (r.survived ? "true" : "false") << ", \"survival_time\": " << r.survivalTime
+			<< ", \"steps\": " << r.steps << ", \"final_health\": " << r.finalHealth
+			<< ", \"wall_ms\": " << r.wallMilliseconds << "}"
+			<< (i + 1 < _results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Model.h"
+#include "ThreadPool.h"
+#include <ostream>
+#include <vector>
+
+struct WorldConfig {
+	unsigned int seed = 0;
+	RuntimePhysics physics;
+	int width = 500;
+	int height = 500;
+	int enemies = 15;
+	// enemies seek the player
+	bool steering = false;
+	// seconds the player holds each direction, drawn from the seed like a key
+	// held down; 0 leaves it standing still, and with steering on every enemy
+	// then reaches it the same way whatever the coefficients
+	double turnInterval = 0.5;
+	// simulated seconds per step and the cut-off for a world that survives
+	double timestep = 0.01;
+	double maxTime = 60;
+};
+
+struct WorldResult {
+	unsigned int seed = 0;
+	bool survived = false;
+	double survivalTime = 0;
+	int steps = 0;
+	int finalHealth = 0;
+	double wallMilliseconds = 0;
+};
+
+// Runs many independent headless worlds in parallel, one Model per world, and
+// collects what each game would have ended with. Every world's scene is drawn
+// by SceneGenerator::makeBody from its seed, so a run is reproducible whatever
+// the thread count.
+class BatchRunner {
+public:
+	BatchRunner(ThreadPool& pool);
+	void addWorld(const WorldConfig& config);
+	// One world per seed for every pair of restitution and friction
+	// coefficient, a friction of 0 turns friction off
+	void addSweep(const WorldConfig& base, const std::vector<float>& restitutions, const std::vector<float>& frictions, int seeds);
+	void run();
+	const std::vector<WorldResult>& getResults() const;
+	double getWallMilliseconds() const;
+	void writeCsv(std::ostream& out) const;
+	void writeJson(std::ostream& out) const;
+	static WorldResult runWorld(const WorldConfig& config);
+private:
+	ThreadPool& _pool;
+	std::vector<WorldConfig> _configs;
+	std::vector<WorldResult> _results;
+	double _wallMilliseconds = 0;
+};
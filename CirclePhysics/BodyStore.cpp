@@ -0,0 +1,105 @@
+#include "BodyStore.h"
+#include "Entity.h"
+
+BodyStore::~BodyStore() {
+	for (int slot = 0; slot < _entities.size(); slot++) {
+		Entity* e = _entities[slot];
+		if (e != nullptr) {
+			e->_detached = new Collider(_colliders[slot]);
+			e->_slot = ENTITY_NONE;
+		}
+	}
+}
+
+int BodyStore::add(Entity* e) {
+	if (e->_slot != ENTITY_NONE) {
+		throw "The entity is in a model already.";
+	}
+	int slot = (int)_colliders.size();
+	_colliders.push_back(*e->_detached);
+	_entities.push_back(e);
+	delete e->_detached;
+	e->_store = this;
+	e->_slot = (uint32_t)slot;
+	_changes++;
+	if (_logging) {
+		clearWritten();
+		_written.push_back(0);
+	}
+	return slot;
+}
+
+void BodyStore::remove(int slot) {
+	Entity* e = _entities[slot];
+	if (e != nullptr) {
+		e->_detached = new Collider(_colliders[slot]);
+		e->_slot = ENTITY_NONE;
+	}
+	int last = (int)_colliders.size() - 1;
+	if (slot != last) {
+		_colliders[slot] = _colliders[last];
+		_entities[slot] = _entities[last];
+		if (_entities[slot] != nullptr) {
+			_entities[slot]->_slot = (uint32_t)slot;
+		}
+	}
+	_colliders.pop_back();
+	_entities.pop_back();
+	_changes++;
+	if (_logging) {
+		clearWritten();
+		_written.pop_back();
+	}
+}
+
+int BodyStore::size() const {
+	return (int)_colliders.size();
+}
+
+Entity* BodyStore::getEntity(int slot) const {
+	return _entities[slot];
+}
+
+const std::vector<Entity*>& BodyStore::getEntities() const {
+	return _entities;
+}
+
+const Collider& BodyStore::get(int slot) const {
+	return _colliders[slot];
+}
+
+Collider& BodyStore::edit(int slot) {
+	touch(slot);
+	return _colliders[slot];
+}
+
+void BodyStore::touch(int slot) {
+	if (_logging && _written[slot] == 0) {
+		_written[slot] = 1;
+		_writeLog.push_back(slot);
+	}
+}
+
+int BodyStore::getChanges() const {
+	return _changes;
+}
+
+void BodyStore::setLogging(bool logging) {
+	_logging = logging;
+	_writeLog.clear();
+	_written.assign(logging ? _colliders.size() : 0, 0);
+	if (!logging) {
+		_written.shrink_to_fit();
+	}
+}
+
+const std::vector<int>& BodyStore::getWritten() const {
+	return _writeLog;
+}
+
+void BodyStore::clearWritten() {
+	for (int slot : _writeLog) {
+		_written[slot] = 0;
+	}
+	_writeLog.clear();
+}
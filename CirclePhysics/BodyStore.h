@@ -0,0 +1,53 @@
+#pragma once
+#include "Collider.h"
+#include <cstdint>
+#include <vector>
+
+class Entity;
+
+// The colliders of a model's bodies in one array, in entity index order, so
+// the passes over every body read them front to back without going through
+// the entities. An entity in a store reaches its collider through the store
+// and its slot, one that is in none owns it on the heap; add() and remove()
+// move the collider between the two.
+//
+// With logging on, the first write to a body after clearWritten() (edit() or
+// touch(), which Entity calls for its collider, health and active flag) adds
+// its slot to getWritten().
+class BodyStore {
+public:
+	BodyStore() = default;
+	BodyStore(const BodyStore&) = delete;
+	BodyStore& operator=(const BodyStore&) = delete;
+	// Entities still in the store get their colliders back
+	~BodyStore();
+	// Takes the entity's collider into the last slot. Throws if the entity is
+	// in a store already
+	int add(Entity* e);
+	// The last body moves into the freed slot and the entity gets its
+	// collider back
+	void remove(int slot);
+	int size() const;
+	Entity* getEntity(int slot) const;
+	const std::vector<Entity*>& getEntities() const;
+	const Collider& get(int slot) const;
+	Collider& edit(int slot);
+	// A write to the body that does not go through the collider
+	void touch(int slot);
+	// add() and remove() calls so far: the entity in a slot is the same as
+	// before only while this has not moved
+	int getChanges() const;
+	void setLogging(bool logging);
+	const std::vector<int>& getWritten() const;
+	void clearWritten();
+private:
+	friend class Entity;
+
+	std::vector<Collider> _colliders;
+	std::vector<Entity*> _entities;
+	int _changes = 0;
+	bool _logging = false;
+	// one flag per slot while logging
+	std::vector<uint8_t> _written;
+	std::vector<int> _writeLog;
+};
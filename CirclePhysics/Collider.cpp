@@ -1,46 +1,79 @@
 #include "Collider.h"
 
-Collider::Collider(Vector2 position, Vector2 velocity, float width, float height, float mass, simplegui::Color color, int type) :
-	_position(position), _velocity(velocity), _width(width), _height(height), _mass(mass), _color(color), _type(type) {}
+Collider::Collider(Vector2 position, Vector2 velocity, float size, float mass, int type) :
+	_core{ position, velocity, size / 2, mass }, _type((uint8_t)type) {}
 
 const Vector2& Collider::getPos() const {
-	return _position;
+	return _core.position;
 }
 const Vector2& Collider::getVelocity() const {
-	return _velocity;
+	return _core.velocity;
 }
 float Collider::getWidth() const {
-	return _width;
+	return _core.radius * 2;
 }
 float Collider::getHeight() const {
-	return _height;
+	return _core.radius * 2;
+}
+float Collider::getRadius() const {
+	return _core.radius;
 }
 float Collider::getMass() const {
-	return _mass;
+	return _core.mass;
 }
-simplegui::Color Collider::getColor() const {
-	return _color;
+float Collider::getInverseMass() const {
+	if (_bodyType != BODY_DYNAMIC) {
+		return 0;
+	}
+	return 1 / _core.mass;
 }
 int Collider::getType() const {
 	return _type;
 }
+int Collider::getBodyType() const {
+	return _bodyType;
+}
+void Collider::setBodyType(int bodyType) {
+	_bodyType = (uint8_t)bodyType;
+}
+uint32_t Collider::getLayer() const {
+	return _layer;
+}
+void Collider::setLayer(uint32_t layer) {
+	_layer = layer;
+}
+uint32_t Collider::getMask() const {
+	return _mask;
+}
+void Collider::setMask(uint32_t mask) {
+	_mask = mask;
+}
+float Collider::getCharge() const {
+	return _charge;
+}
+void Collider::setCharge(float charge) {
+	_charge = charge;
+}
+bool Collider::canCollideWith(const Collider& other) const {
+	// at least one of the pair has to be able to take an impulse
+	if (_bodyType != BODY_DYNAMIC && other._bodyType != BODY_DYNAMIC) {
+		return false;
+	}
+	return (_layer & other._mask) != 0 && (other._layer & _mask) != 0;
+}
 void Collider::addPos(const Vector2& toAdd) {
-	_position = _position + toAdd;
+	_core.position = _core.position + toAdd;
 }
 void Collider::addVel(const Vector2& toAdd) {
-	_velocity = _velocity + toAdd;
+	_core.velocity = _core.velocity + toAdd;
 }
 void Collider::setVelocity(const Vector2& vel) {
-	_velocity.X = vel.X;
-	_velocity.Y = vel.Y;
-	float length = getLength(_velocity);
-	if (length >= 200) {
-		_velocity *= (200 / length);
-	}
+	_core.velocity.X = vel.X;
+	_core.velocity.Y = vel.Y;
 }
 void Collider::setPosition(const Vector2& pos) {
-	_position.X = pos.X;
-	_position.Y = pos.Y;
+	_core.position.X = pos.X;
+	_core.position.Y = pos.Y;
 }
 
 
@@ -1,32 +1,66 @@
 #pragma once
 #include "Vector2.h"
-#include "simplegui.h"
+#include <cstdint>
 
+#define LAYER_DEFAULT 0x1u
+#define LAYER_PLAYER 0x2u
+#define LAYER_ENEMY 0x4u
+#define MASK_ALL 0xffffffffu
 
 enum shape {
 	TYPE_CIRCLE = 0,
 	TYPE_BOX = 1
 };
+
+// Dynamic bodies integrate and take impulses. Kinematic bodies move with their
+// own velocity but take no impulses, static bodies never move.
+enum bodyType {
+	BODY_DYNAMIC = 0,
+	BODY_STATIC = 1,
+	BODY_KINEMATIC = 2
+};
+
+// What integration and the contact passes read for every body, kept together
+// at the front of the collider. A model keeps its bodies' colliders in one
+// array (see BodyStore), so a pass over every core walks memory in order
+struct ColliderCore {
+	Vector2 position;
+	Vector2 velocity;
+	float radius;
+	float mass;
+};
+
 class Collider {
 public:
-	Collider(Vector2 position, Vector2 velocity, float height, float width, float mass, simplegui::Color color = simplegui::Color(0xff, 0xff, 0xff), int type = 0);
+	// size is the diameter for circles and the side for boxes
+	Collider(Vector2 position, Vector2 velocity, float size, float mass, int type = TYPE_CIRCLE);
 	const Vector2& getPos() const;
 	const Vector2& getVelocity() const;
 	float getWidth() const;
 	float getHeight() const;
+	float getRadius() const;
 	float getMass() const;
-	simplegui::Color getColor() const;
+	float getInverseMass() const;
 	int getType() const;
+	int getBodyType() const;
+	void setBodyType(int bodyType);
+	uint32_t getLayer() const;
+	void setLayer(uint32_t layer);
+	uint32_t getMask() const;
+	void setMask(uint32_t mask);
+	// source strength for the charge force, 0 leaves the body out of it
+	float getCharge() const;
+	void setCharge(float charge);
+	bool canCollideWith(const Collider& other) const;
 	void addPos(const Vector2& toAdd);
 	void addVel(const Vector2& toAdd);
 	void setVelocity(const Vector2& vel);
 	void setPosition(const Vector2& vel);
 private:
-	Vector2 _position;
-	Vector2 _velocity;
-	float _height;
-	float _width;
-	float _mass;
-	simplegui::Color _color;
-	int _type;
+	ColliderCore _core;
+	float _charge = 0;
+	uint32_t _layer = LAYER_DEFAULT;
+	uint32_t _mask = MASK_ALL;
+	uint8_t _type;
+	uint8_t _bodyType = BODY_DYNAMIC;
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "ContactCache.h"
+
+float ContactCacheStats::getHitRate() const {
+	if (lookups == 0) {
+		return 0;
+	}
+	return (float)hits / lookups;
+}
+
+ContactCache::ContactCache(unsigned int maxAge) : _maxAge(maxAge) {}
+
+uint64_t ContactCache::getKey(uint32_t id1, uint32_t id2) {
+	if (id1 > id2) {
+		std::swap(id1, id2);
+	}
+	return ((uint64_t)id1 << 32) | id2;
+}
+
+void ContactCache::beginFrame() {
+	_frame++;
+	_stats.lookups = 0;
+	_stats.hits = 0;
+	_stats.evicted = 0;
+}
+
+CachedContact& ContactCache::touch(uint32_t id1, uint32_t id2) {
+	_stats.lookups++;
+	auto result = _contacts.try_emplace(getKey(id1, id2));
+	CachedContact& contact = result.first->second;
+	if (!result.second) {
+		_stats.hits++;
+	}
+	contact.lastFrame = _frame;
+	return contact;
+}
+
+void ContactCache::endFrame() {
+	for (auto it = _contacts.begin(); it != _contacts.end();) {
+		if (_frame - it->second.lastFrame >= _maxAge) {
+			it = _contacts.erase(it);
+			_stats.evicted++;
+		}
+		else {
+			++it;
+		}
+	}
+	_stats.size = (int)_contacts.size();
+}
+
+void ContactCache::remove(uint32_t id) {
+	for (auto it = _contacts.begin(); it != _contacts.end();) {
+		if ((uint32_t)(it->first >> 32) == id || (uint32_t)it->first == id) {
+			it = _contacts.erase(it);
+			_stats.evicted++;
+		}
+		else {
+			++it;
+		}
+	}
+	_stats.size = (int)_contacts.size();
+}
+
+void ContactCache::clear() {
+	_contacts.clear();
+	_stats = ContactCacheStats();
+}
+
+const ContactCacheStats& ContactCache::getStats() const {
+	return _stats;
+}
+
+unsigned int ContactCache::getMaxAge() const {
+	return _maxAge;
+}
+
+void ContactCache::setMaxAge(unsigned int frames) {
+	_maxAge = frames;
+}
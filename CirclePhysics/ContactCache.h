@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+// Frames a contact may go unseen before it is dropped from the cache
+#define CONTACT_CACHE_MAX_AGE 3
+
+struct CachedContact {
+	float normalImpulse = 0;
+	unsigned int lastFrame = 0;
+};
+
+struct ContactCacheStats {
+	int lookups = 0;
+	int hits = 0;
+	int evicted = 0;
+	int size = 0;
+	float getHitRate() const;
+};
+
+// Contacts that persist across frames, keyed by the ids of the two bodies.
+// The impulse a pair ended the last frame with is kept so the solver can start
+// from it (warm start) instead of from zero. The model uses Entity::getId(),
+// which does not change when entities are removed and others move into their
+// slots, so a removal only evicts the removed body's contacts.
+class ContactCache {
+public:
+	ContactCache(unsigned int maxAge = CONTACT_CACHE_MAX_AGE);
+	static uint64_t getKey(uint32_t id1, uint32_t id2);
+	void beginFrame();
+	CachedContact& touch(uint32_t id1, uint32_t id2);
+	void endFrame();
+	// Drops every contact of the body
+	void remove(uint32_t id);
+	void clear();
+	const ContactCacheStats& getStats() const;
+	unsigned int getMaxAge() const;
+	void setMaxAge(unsigned int frames);
+private:
+	std::unordered_map<uint64_t, CachedContact> _contacts;
+	unsigned int _frame = 0;
+	unsigned int _maxAge;
+	ContactCacheStats _stats;
+};
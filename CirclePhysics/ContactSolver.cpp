@@ -0,0 +1,107 @@
+#include "ContactSolver.h"
+#include <algorithm>
+
+void ContactSolver::clear() {
+	_contacts.clear();
+	_stats = SolverStats();
+}
+
+Contact& ContactSolver::addContact(Collider& a, Collider& b, float restitution) {
+	Contact c;
+	c.a = &a;
+	c.b = &b;
+	Vector2 delta = a.getPos() - b.getPos();
+	float d = getLength(delta);
+	c.normal = d > 0 ? delta / d : Vector2{ 1, 0 };
+	c.radiusSum = a.getHeight() / 2 + b.getHeight() / 2;
+	c.invMassA = a.getInverseMass();
+	c.invMassB = b.getInverseMass();
+	c.normalMass = 1 / (c.invMassA + c.invMassB);
+	float vn = dot(a.getVelocity() - b.getVelocity(), c.normal);
+	c.targetVelocity = vn < 0 ? -restitution * vn : 0;
+	c.impulse = 0;
+	_contacts.push_back(c);
+	return _contacts.back();
+}
+
+void ContactSolver::solve(int iterations, float tolerance) {
+	_stats.contacts = (int)_contacts.size();
+	if (_contacts.empty()) {
+		return;
+	}
+	warmStart();
+	_stats.velocityIterations = solveVelocities(iterations, tolerance);
+	_stats.positionIterations = solvePositions(iterations, SOLVER_POSITION_TOLERANCE);
+	_stats.residualOverlap = computeResidualOverlap();
+}
+
+void ContactSolver::warmStart() {
+	for (Contact& c : _contacts) {
+		if (c.impulse > 0) {
+			c.a->addVel(c.normal * (c.impulse * c.invMassA));
+			c.b->addVel(c.normal * (-c.impulse * c.invMassB));
+		}
+	}
+}
+
+int ContactSolver::solveVelocities(int iterations, float tolerance) {
+	int i = 0;
+	while (i < iterations) {
+		i++;
+		float maxDelta = 0;
+		for (Contact& c : _contacts) {
+			float vn = dot(c.a->getVelocity() - c.b->getVelocity(), c.normal);
+			float total = std::max(c.impulse + (c.targetVelocity - vn) * c.normalMass, 0.0f);
+			float delta = total - c.impulse;
+			c.impulse = total;
+			c.a->addVel(c.normal * (delta * c.invMassA));
+			c.b->addVel(c.normal * (-delta * c.invMassB));
+			maxDelta = std::max(maxDelta, std::abs(delta));
+		}
+		_stats.maxImpulseDelta = maxDelta;
+		if (maxDelta < tolerance) {
+			break;
+		}
+	}
+	return i;
+}
+
+int ContactSolver::solvePositions(int iterations, float tolerance) {
+	int i = 0;
+	while (i < iterations) {
+		i++;
+		float maxCorrection = 0;
+		for (Contact& c : _contacts) {
+			// separation measured along the stored normal
+			float overlap = c.radiusSum - dot(c.a->getPos() - c.b->getPos(), c.normal);
+			if (overlap <= 0) {
+				continue;
+			}
+			float share = overlap / (c.invMassA + c.invMassB);
+			c.a->addPos(c.normal * (share * c.invMassA));
+			c.b->addPos(c.normal * (-share * c.invMassB));
+			maxCorrection = std::max(maxCorrection, overlap);
+		}
+		if (maxCorrection < tolerance) {
+			break;
+		}
+	}
+	return i;
+}
+
+float ContactSolver::computeResidualOverlap() const {
+	float residual = 0;
+	for (const Contact& c : _contacts) {
+		float overlap = c.radiusSum - getLength(c.a->getPos() - c.b->getPos());
+		residual = std::max(residual, overlap);
+	}
+	return residual;
+}
+
+std::vector<Contact>& ContactSolver::getContacts() {
+	return _contacts;
+}
+
+const SolverStats& ContactSolver::getStats() const {
+	return _stats;
+}
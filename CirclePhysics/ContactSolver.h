@@ -0,0 +1,51 @@
+#pragma once
+#include "Collider.h"
+#include <vector>
+
+// Overlap below which the position pass stops iterating
+#define SOLVER_POSITION_TOLERANCE 0.01f
+
+struct Contact {
+	Collider* a;
+	Collider* b;
+	// unit normal pointing from b towards a
+	Vector2 normal;
+	float radiusSum;
+	float invMassA;
+	float invMassB;
+	// 1 / (invMassA + invMassB), the mass seen along the normal
+	float normalMass;
+	// normal velocity the pair should leave with, from restitution
+	float targetVelocity;
+	// accumulated normal impulse, may be preset as a warm start
+	float impulse;
+};
+
+struct SolverStats {
+	int contacts = 0;
+	int velocityIterations = 0;
+	int positionIterations = 0;
+	float maxImpulseDelta = 0;
+	float residualOverlap = 0;
+};
+
+// Sequential-impulse solver over all of a frame's contacts. Normals and
+// effective masses are computed once when a contact is added, then every
+// contact is relaxed in turn until the largest impulse change drops below the
+// tolerance or the iteration budget runs out.
+class ContactSolver {
+public:
+	void clear();
+	Contact& addContact(Collider& a, Collider& b, float restitution);
+	void solve(int iterations, float tolerance);
+	std::vector<Contact>& getContacts();
+	const SolverStats& getStats() const;
+private:
+	void warmStart();
+	int solveVelocities(int iterations, float tolerance);
+	int solvePositions(int iterations, float tolerance);
+	float computeResidualOverlap() const;
+
+	std::vector<Contact> _contacts;
+	SolverStats _stats;
+};
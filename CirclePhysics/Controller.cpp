@@ -7,6 +7,7 @@ public:
 };
 
 void Controller::KeyDown(Window* win, int vk) {
+	auto time = std::chrono::steady_clock::now();
 	if (vk == simplegui::KEY_W) {
 		_direction.X = 0;
 		_direction.Y = -1;
@@ -25,10 +26,19 @@ void Controller::KeyDown(Window* win, int vk) {
 	}
 	else if (vk == simplegui::KEY_I) {
 		std::cout << "i key";
+		return;
 	}
+	else {
+		return;
+	}
+	_queue.push(InputEvent{ _direction, time });
 };
 
 const Vector2 Controller::getDirection() const {
 	return _direction;
 }
 
+InputQueue& Controller::getQueue() {
+	return _queue;
+}
+
@@ -1,13 +1,17 @@
 #pragma once
 #include "simplegui.h"
 #include "Player.h"
+#include "InputQueue.h"
 #include <iostream>
 using namespace simplegui;
 class Controller : public KeyListener {
 public:
 	virtual void KeyDown(Window* win, int vk);
 	const Vector2 getDirection() const;
+	// Every direction change with the time it was pressed
+	InputQueue& getQueue();
 
 private:
 	Vector2 _direction;
+	InputQueue _queue;
 };
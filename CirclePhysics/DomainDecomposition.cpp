@@ -0,0 +1,428 @@
+#include "DomainDecomposition.h"
+#ifndef _WIN32
+#include "Enemy.h"
+#include "Model.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// a dead peer makes the write fail instead of raising SIGPIPE
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+enum domainCommand {
+	COMMAND_LOAD = 0,
+	COMMAND_STEP = 1,
+	COMMAND_GATHER = 2,
+	COMMAND_QUIT = 3
+};
+
+struct CommandHeader {
+	int32_t command;
+	uint32_t count;
+	double time;
+};
+
+struct StepReply {
+	uint32_t ghosts;
+	uint32_t migrated;
+};
+
+static bool writeAll(int fd, const void* data, size_t size) {
+	const char* p = (const char*)data;
+	while (size > 0) {
+		ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool readAll(int fd, void* data, size_t size) {
+	char* p = (char*)data;
+	while (size > 0) {
+		ssize_t n = read(fd, p, size);
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool sendBodies(int fd, const std::vector<BodyState>& bodies) {
+	uint32_t count = (uint32_t)bodies.size();
+	return writeAll(fd, &count, sizeof(count)) && writeAll(fd, bodies.data(), count * sizeof(BodyState));
+}
+
+static bool receiveBodies(int fd, std::vector<BodyState>& bodies) {
+	uint32_t count;
+	if (!readAll(fd, &count, sizeof(count))) {
+		return false;
+	}
+	size_t first = bodies.size();
+	bodies.resize(first + count);
+	return readAll(fd, bodies.data() + first, count * sizeof(BodyState));
+}
+
+// Sends to and receives from both neighbours at once. Both sides send before
+// reading, so blocking writes could fill the socket buffers and deadlock; poll
+// interleaves the two directions instead.
+struct Channel {
+	int fd;
+	std::vector<char> out;
+	size_t written;
+	std::vector<char> in;
+	size_t expected;
+};
+
+static bool exchange(std::vector<Channel>& channels) {
+	for (Channel& c : channels) {
+		c.written = 0;
+		c.in.clear();
+		c.expected = sizeof(uint32_t);
+	}
+	while (true) {
+		std::vector<pollfd> fds;
+		for (Channel& c : channels) {
+			short events = 0;
+			if (c.written < c.out.size()) {
+				events |= POLLOUT;
+			}
+			if (c.in.size() < c.expected) {
+				events |= POLLIN;
+			}
+			fds.push_back(pollfd{ c.fd, events, 0 });
+		}
+		bool busy = false;
+		for (pollfd& p : fds) {
+			busy = busy || p.events != 0;
+		}
+		if (!busy) {
+			return true;
+		}
+		if (poll(fds.data(), fds.size(), -1) < 0) {
+			return false;
+		}
+		for (int i = 0; i < channels.size(); i++) {
+			Channel& c = channels[i];
+			if (fds[i].revents & POLLOUT) {
+				ssize_t n = send(c.fd, c.out.data() + c.written, c.out.size() - c.written, MSG_NOSIGNAL);
+				if (n <= 0) {
+					return false;
+				}
+				c.written += n;
+			}
+			if (fds[i].revents & (POLLIN | POLLHUP)) {
+				char buffer[65536];
+				ssize_t n = read(c.fd, buffer, std::min(sizeof(buffer), c.expected - c.in.size()));
+				if (n <= 0) {
+					return false;
+				}
+				c.in.insert(c.in.end(), buffer, buffer + n);
+				// the count prefix tells how much body data follows
+				if (c.in.size() == sizeof(uint32_t) && c.expected == sizeof(uint32_t)) {
+					uint32_t count;
+					memcpy(&count, c.in.data(), sizeof(count));
+					c.expected += count * sizeof(BodyState);
+				}
+			}
+		}
+	}
+}
+
+static void pack(std::vector<char>& out, const std::vector<BodyState>& bodies) {
+	uint32_t count = (uint32_t)bodies.size();
+	out.resize(sizeof(count) + count * sizeof(BodyState));
+	memcpy(out.data(), &count, sizeof(count));
+	memcpy(out.data() + sizeof(count), bodies.data(), count * sizeof(BodyState));
+}
+
+static void unpack(const std::vector<char>& in, std::vector<BodyState>& bodies) {
+	size_t count = (in.size() - sizeof(uint32_t)) / sizeof(BodyState);
+	size_t first = bodies.size();
+	bodies.resize(first + count);
+	memcpy(bodies.data() + first, in.data() + sizeof(uint32_t), count * sizeof(BodyState));
+}
+
+DomainRunner::DomainRunner(int width, int height, int workers, float ghostWidth, RuntimePhysics physics) :
+	_width(width), _height(height), _workers(workers), _ghostWidth(ghostWidth), _physics(physics) {}
+
+DomainRunner::~DomainRunner() {
+	stop();
+}
+
+void DomainRunner::addBody(const BodyState& body) {
+	_initial.push_back(body);
+}
+
+int DomainRunner::getRegion(float x) const {
+	int region = (int)(x * _workers / _width);
+	return std::min(std::max(region, 0), _workers - 1);
+}
+
+int DomainRunner::getWorkerPid(int region) const {
+	return _pids[region];
+}
+
+const DomainStats& DomainRunner::getStats() const {
+	return _stats;
+}
+
+bool DomainRunner::start() {
+	float maxRadius = 0;
+	for (const BodyState& b : _initial) {
+		maxRadius = std::max(maxRadius, b.radius);
+	}
+	if (_ghostWidth < maxRadius || (float)_width / _workers < 2 * maxRadius || _physics.warmStarting || _physics.eventDriven) {
+		return false;
+	}
+	// neighbours[r] links region r with region r + 1
+	std::vector<int> neighbours(2 * _workers, -1);
+	for (int r = 0; r + 1 < _workers; r++) {
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, &neighbours[2 * r]) != 0) {
+			return false;
+		}
+	}
+	for (int r = 0; r < _workers; r++) {
+		int pair[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+			return false;
+		}
+		int pid = fork();
+		if (pid < 0) {
+			return false;
+		}
+		if (pid == 0) {
+			close(pair[0]);
+			for (int s : _sockets) {
+				close(s);
+			}
+			int left = r > 0 ? neighbours[2 * (r - 1) + 1] : -1;
+			int right = r + 1 < _workers ? neighbours[2 * r] : -1;
+			for (int i = 0; i < neighbours.size(); i++) {
+				if (neighbours[i] >= 0 && neighbours[i] != left && neighbours[i] != right) {
+					close(neighbours[i]);
+				}
+			}
+			workerMain(r, pair[1], left, right);
+			_exit(0);
+		}
+		close(pair[1]);
+		_pids.push_back(pid);
+		_sockets.push_back(pair[0]);
+	}
+	for (int s : neighbours) {
+		if (s >= 0) {
+			close(s);
+		}
+	}
+
+	std::vector<std::vector<BodyState>> regions(_workers);
+	for (const BodyState& b : _initial) {
+		regions[getRegion(b.x)].push_back(b);
+	}
+	for (int r = 0; r < _workers; r++) {
+		CommandHeader header{ COMMAND_LOAD, (uint32_t)regions[r].size(), 0 };
+		if (!writeAll(_sockets[r], &header, sizeof(header)) || !sendBodies(_sockets[r], regions[r])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DomainRunner::step(double time) {
+	auto start = std::chrono::steady_clock::now();
+	CommandHeader header{ COMMAND_STEP, 0, time };
+	bool ok = true;
+	for (int s : _sockets) {
+		ok = writeAll(s, &header, sizeof(header)) && ok;
+	}
+	_stats.ghosts = 0;
+	_stats.migrated = 0;
+	for (int s : _sockets) {
+		StepReply reply;
+		if (!readAll(s, &reply, sizeof(reply))) {
+			ok = false;
+			continue;
+		}
+		_stats.ghosts += reply.ghosts;
+		_stats.migrated += reply.migrated;
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	_stats.stepMilliseconds = elapsed.count();
+	return ok;
+}
+
+bool DomainRunner::gather(std::vector<BodyState>& bodies) {
+	bodies.clear();
+	CommandHeader header{ COMMAND_GATHER, 0, 0 };
+	for (int s : _sockets) {
+		if (!writeAll(s, &header, sizeof(header)) || !receiveBodies(s, bodies)) {
+			return false;
+		}
+	}
+	std::sort(bodies.begin(), bodies.end(), [](const BodyState& a, const BodyState& b) { return a.id < b.id; });
+	return true;
+}
+
+void DomainRunner::stop() {
+	CommandHeader header{ COMMAND_QUIT, 0, 0 };
+	for (int s : _sockets) {
+		writeAll(s, &header, sizeof(header));
+		close(s);
+	}
+	for (int pid : _pids) {
+		waitpid(pid, nullptr, 0);
+	}
+	_sockets.clear();
+	_pids.clear();
+}
+
+void DomainRunner::workerMain(int region, int coordinator, int left, int right) {
+	float minX = (float)_width * region / _workers;
+	float maxX = (float)_width * (region + 1) / _workers;
+	std::vector<BodyState> owned;
+	std::vector<Channel> channels;
+	if (left >= 0) {
+		channels.push_back(Channel{});
+		channels.back().fd = left;
+	}
+	if (right >= 0) {
+		channels.push_back(Channel{});
+		channels.back().fd = right;
+	}
+	Channel* toLeft = left >= 0 ? &channels[0] : nullptr;
+	Channel* toRight = right >= 0 ? &channels.back() : nullptr;
+
+	CommandHeader header;
+	while (readAll(coordinator, &header, sizeof(header))) {
+		if (header.command == COMMAND_LOAD) {
+			owned.clear();
+			if (!receiveBodies(coordinator, owned)) {
+				break;
+			}
+		}
+		else if (header.command == COMMAND_GATHER) {
+			if (!sendBodies(coordinator, owned)) {
+				break;
+			}
+		}
+		else if (header.command == COMMAND_STEP) {
+			// ghosts: copies of our bodies close enough to touch a neighbour's
+			std::vector<BodyState> leftGhosts, rightGhosts;
+			for (const BodyState& b : owned) {
+				if (toLeft != nullptr && b.x - b.radius < minX + _ghostWidth) {
+					leftGhosts.push_back(b);
+				}
+				if (toRight != nullptr && b.x + b.radius > maxX - _ghostWidth) {
+					rightGhosts.push_back(b);
+				}
+			}
+			if (toLeft != nullptr) {
+				pack(toLeft->out, leftGhosts);
+			}
+			if (toRight != nullptr) {
+				pack(toRight->out, rightGhosts);
+			}
+			if (!exchange(channels)) {
+				break;
+			}
+			std::vector<BodyState> local = owned;
+			size_t ownedCount = owned.size();
+			for (Channel& c : channels) {
+				unpack(c.in, local);
+			}
+			uint32_t ghosts = (uint32_t)(local.size() - ownedCount);
+
+			// step owned and ghosts together, then keep only ours, which are
+			// the first ownedCount
+			stepBodies(local, _width, _height, _physics, header.time);
+			local.resize(ownedCount);
+
+			owned.clear();
+			std::vector<BodyState> leftMigrants, rightMigrants;
+			for (const BodyState& b : local) {
+				int target = getRegion(b.x);
+				if (target < region && toLeft != nullptr) {
+					leftMigrants.push_back(b);
+				}
+				else if (target > region && toRight != nullptr) {
+					rightMigrants.push_back(b);
+				}
+				else {
+					owned.push_back(b);
+				}
+			}
+			if (toLeft != nullptr) {
+				pack(toLeft->out, leftMigrants);
+			}
+			if (toRight != nullptr) {
+				pack(toRight->out, rightMigrants);
+			}
+			if (!exchange(channels)) {
+				break;
+			}
+			for (Channel& c : channels) {
+				unpack(c.in, owned);
+			}
+			StepReply reply{ ghosts, (uint32_t)(leftMigrants.size() + rightMigrants.size()) };
+			if (!writeAll(coordinator, &reply, sizeof(reply))) {
+				break;
+			}
+		}
+		else {
+			break;
+		}
+	}
+	close(coordinator);
+	for (Channel& c : channels) {
+		close(c.fd);
+	}
+}
+
+void DomainRunner::stepBodies(std::vector<BodyState>& bodies, int width, int height, const RuntimePhysics& physics, double time) {
+	// the model resolves pairs in the order the bodies were added, so adding
+	// them by id gives every split of the world the whole world's order
+	std::vector<int> order(bodies.size());
+	for (int i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return bodies[a].id < bodies[b].id; });
+	BasicModel<RuntimePhysics> model(width, height, physics);
+	NameId name = NamePool::intern("body");
+	std::vector<Entity*> entities;
+	for (int i : order) {
+		const BodyState& b = bodies[i];
+		Collider c = Collider(Vector2{ b.x, b.y }, Vector2{ b.vx, b.vy }, 2 * b.radius, b.mass);
+		c.setBodyType(b.bodyType);
+		c.setLayer(b.layer);
+		c.setMask(b.mask);
+		Enemy* e = new Enemy(c, name);
+		model.addEntity(e);
+		entities.push_back(e);
+	}
+	model.update(time, Vector2());
+	for (int k = 0; k < order.size(); k++) {
+		const Collider& c = *entities[k]->getCollider();
+		BodyState& b = bodies[order[k]];
+		b.x = c.getPos().X;
+		b.y = c.getPos().Y;
+		b.vx = c.getVelocity().X;
+		b.vy = c.getVelocity().Y;
+	}
+	for (Entity* e : entities) {
+		delete e;
+	}
+}
+#endif
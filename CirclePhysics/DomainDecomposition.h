@@ -0,0 +1,72 @@
+#pragma once
+// Multi-process domain decomposition, POSIX only (fork and Unix sockets)
+#include "Physics.h"
+#include <cstdint>
+#include <vector>
+
+// Plain body record sent between processes
+struct BodyState {
+	uint32_t id;
+	float x;
+	float y;
+	float vx;
+	float vy;
+	float radius;
+	float mass;
+	int32_t bodyType;
+	uint32_t layer;
+	uint32_t mask;
+};
+
+struct DomainStats {
+	int ghosts = 0;
+	int migrated = 0;
+	double stepMilliseconds = 0;
+};
+
+// Splits the world into vertical strips, one per worker process. Each step
+// every worker sends its neighbours copies of the bodies within ghostWidth of
+// the shared edge, steps its own bodies together with those ghosts, throws the
+// ghosts away and hands over bodies that left its strip.
+//
+// Workers step their bodies and the ghosts with one Model::update through
+// stepBodies(). The Model resolves pairs one after another in body order, so
+// an impulse can run down a chain of touching bodies within a step: the split
+// run matches Model::update over the whole world bit for bit while every chain
+// that reaches an owned body stays inside the ghost band. That holds for
+// sparse scenes; in a dense pack the chains outrun any band and the strips
+// drift apart from the single process run.
+//
+// start(), step() and gather() return false once a worker has died or a
+// socket failed; the runner is then of no further use except for stop().
+class DomainRunner {
+public:
+	DomainRunner(int width, int height, int workers, float ghostWidth, RuntimePhysics physics = RuntimePhysics());
+	~DomainRunner();
+	void addBody(const BodyState& body);
+	// Also false if the ghost band is narrower than the largest radius, a strip
+	// narrower than the largest body, or the physics keeps state between steps
+	// (warm starting, event-driven), which the workers do not carry over
+	bool start();
+	bool step(double time);
+	bool gather(std::vector<BodyState>& bodies);
+	void stop();
+	int getRegion(float x) const;
+	int getWorkerPid(int region) const;
+	const DomainStats& getStats() const;
+	// One Model::update of the bodies in a model built for the step, the pairs
+	// taken in id order whatever order the bodies come in
+	static void stepBodies(std::vector<BodyState>& bodies, int width, int height, const RuntimePhysics& physics, double time);
+private:
+	void workerMain(int region, int coordinator, int left, int right);
+
+	int _width;
+	int _height;
+	int _workers;
+	float _ghostWidth;
+	RuntimePhysics _physics;
+	std::vector<BodyState> _initial;
+	std::vector<int> _pids;
+	std::vector<int> _sockets;
+	DomainStats _stats;
+};
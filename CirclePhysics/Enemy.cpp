@@ -3,7 +3,7 @@
 
 void Enemy::onDeath() {
 	std::cout << "enemy died";
-	_active = false;
+	setActive(false);
 }
 
 void Enemy::onCollide() {
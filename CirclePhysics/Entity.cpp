@@ -1,38 +1,95 @@
 #include "Entity.h"
 
 
-Entity::Entity(Collider c, std::string name, int health, bool active) : _collider(c), _name(name), _maxHealth(health), _health(health), _active(active){}
+Entity::Entity(Collider c, const std::string& name, int health, bool active) : Entity(c, NamePool::intern(name), health, active) {
+}
+
+Entity::Entity(Collider c, NameId name, int health, bool active) : _detached(new Collider(c)), _slot(ENTITY_NONE), _id(EntityTable::allocate()) {
+	EntityColdData& cold = EntityTable::get(_id);
+	cold.name = name;
+	cold.color = 0xffffff;
+	cold.health = health;
+	cold.maxHealth = health;
+	cold.active = active;
+}
+
+Entity::Entity(Entity&& other) : _detached(other._detached), _slot(other._slot), _id(other._id) {
+	if (_slot != ENTITY_NONE) {
+		_store->_entities[_slot] = this;
+	}
+	other._detached = nullptr;
+	other._slot = ENTITY_NONE;
+	other._id = ENTITY_NONE;
+}
+
+Entity::~Entity() {
+	if (_slot != ENTITY_NONE) {
+		_store->_entities[_slot] = nullptr;
+	}
+	else {
+		delete _detached;
+	}
+	if (_id != ENTITY_NONE) {
+		EntityTable::release(_id);
+	}
+}
+
+void Entity::touch() {
+	if (_slot != ENTITY_NONE) {
+		_store->touch((int)_slot);
+	}
+}
 
 void Entity::setHealth(int h) {
-	_health = h;
+	touch();
+	EntityTable::get(_id).health = h;
 }
 void Entity::subtractHealth(int h) {
-	_health -= h;
-	if (_health <= 0) {
+	touch();
+	int& health = EntityTable::get(_id).health;
+	health -= h;
+	if (health <= 0) {
 		onDeath();
 	}
 }
 int Entity::getHealth() const {
-	return _health;
+	return EntityTable::get(_id).health;
 }
 int Entity::getMaxHealth() const {
-	return _maxHealth;
+	return EntityTable::get(_id).maxHealth;
 }
 void Entity::setActive(bool b) {
-	_active = b;
+	touch();
+	EntityTable::get(_id).active = b;
 }
 bool Entity::getActive() const {
-	return _active;
+	return EntityTable::get(_id).active;
 }
 
-std::string Entity::getName() const {
-	return _name;
+const std::string& Entity::getName() const {
+	return NamePool::lookup(EntityTable::get(_id).name);
 }
 
-Collider* Entity::getCollider() {
-	return &_collider;
+uint32_t Entity::getId() const {
+	return _id;
+}
+
+std::string Entity::getDisplayName() const {
+	return getName() + std::to_string(_id);
+}
+
+uint32_t Entity::getColor() const {
+	return EntityTable::get(_id).color;
+}
+
+void Entity::setColor(uint32_t color) {
+	EntityTable::get(_id).color = color;
 }
 
 const Collider* Entity::getCollider() const {
-	return &_collider;
+	return _slot != ENTITY_NONE ? &_store->get((int)_slot) : _detached;
+}
+
+Collider* Entity::editCollider() {
+	return _slot != ENTITY_NONE ? &_store->edit((int)_slot) : _detached;
 }
@@ -1,26 +1,53 @@
 #pragma once
+#include "BodyStore.h"
 #include "Collider.h"
+#include "EntityTable.h"
 #include <string>
+// The collider is all the simulation reads. While the entity is in a model it
+// lives in the model's BodyStore, otherwise the entity owns it. Name, color,
+// health and the active flag live in EntityTable under _id.
 class Entity {
 public:
-	Entity(Collider c, std::string name, int health = 10, bool active = true);
+	Entity(Collider c, const std::string& name, int health = 10, bool active = true);
+	// For many entities of one kind, the name interned once
+	Entity(Collider c, NameId name, int health = 10, bool active = true);
+	Entity(const Entity&) = delete;
+	Entity(Entity&& other);
+	Entity& operator=(const Entity&) = delete;
+	// Deleting an entity that is still in a model leaves an empty slot, which
+	// only the model's destructor copes with
+	virtual ~Entity();
 	void setHealth(int h);
 	int getHealth() const;
 	int getMaxHealth() const;
 	void subtractHealth(int h);
 	void setActive(bool b);
 	bool getActive() const;
-	std::string getName() const;
-	Collider* getCollider();
+	// The name shared by every entity of the kind
+	const std::string& getName() const;
+	// The name and the entity's table index, made on every call
+	std::string getDisplayName() const;
+	// The entity's row in EntityTable, the same for its whole life
+	uint32_t getId() const;
+	// 0xRRGGBB, as taken by simplegui::Color
+	uint32_t getColor() const;
+	void setColor(uint32_t color);
 	const Collider* getCollider() const;
+	// For writing to the collider, counts as a write for BodyStore's log
+	Collider* editCollider();
 	virtual void onCollide() = 0;
 	virtual void onCollideWall() = 0;
 	virtual void onDeath() = 0;
 
-protected:
-	int _maxHealth;
-	int _health;
-	bool _active;
-	Collider _collider;
-	std::string _name;
-};
\ No newline at end of file
+private:
+	friend class BodyStore;
+	void touch();
+
+	union {
+		// while _slot is ENTITY_NONE
+		Collider* _detached;
+		BodyStore* _store;
+	};
+	uint32_t _slot;
+	uint32_t _id;
+};
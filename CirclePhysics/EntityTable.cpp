@@ -0,0 +1,47 @@
+#include "EntityTable.h"
+
+std::mutex EntityTable::_mutex;
+std::atomic<EntityColdData*> EntityTable::_chunks[ENTITY_TABLE_MAX_CHUNKS];
+std::vector<uint32_t> EntityTable::_free;
+uint32_t EntityTable::_next = 0;
+int EntityTable::_live = 0;
+
+uint32_t EntityTable::allocate() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_live++;
+	if (!_free.empty()) {
+		uint32_t id = _free.back();
+		_free.pop_back();
+		return id;
+	}
+	uint32_t id = _next++;
+	uint32_t chunk = id / ENTITY_TABLE_CHUNK;
+	if (chunk >= ENTITY_TABLE_MAX_CHUNKS) {
+		throw "Entity table is full.";
+	}
+	if (id % ENTITY_TABLE_CHUNK == 0) {
+		_chunks[chunk].store(new EntityColdData[ENTITY_TABLE_CHUNK], std::memory_order_release);
+	}
+	return id;
+}
+
+void EntityTable::release(uint32_t id) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_free.push_back(id);
+	_live--;
+}
+
+EntityColdData& EntityTable::get(uint32_t id) {
+	return _chunks[id / ENTITY_TABLE_CHUNK].load(std::memory_order_acquire)[id % ENTITY_TABLE_CHUNK];
+}
+
+int EntityTable::getLiveCount() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _live;
+}
+
+size_t EntityTable::getReservedBytes() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t chunks = (_next + ENTITY_TABLE_CHUNK - 1) / ENTITY_TABLE_CHUNK;
+	return chunks * ENTITY_TABLE_CHUNK * sizeof(EntityColdData) + _free.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "NamePool.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#define ENTITY_TABLE_CHUNK 4096
+#define ENTITY_TABLE_MAX_CHUNKS 16384
+#define ENTITY_NONE 0xffffffffu
+
+// Entity data the simulation never reads while stepping
+struct EntityColdData {
+	NameId name;
+	uint32_t color;
+	int health;
+	int maxHealth;
+	bool active;
+};
+
+// Process-wide side table for EntityColdData, indexed by the id every entity
+// holds. Storage grows in fixed chunks that never move, so entities owned by
+// different threads (one world per thread in BatchRunner) can use their rows
+// without locking; only allocate() and release() take the lock.
+class EntityTable {
+public:
+	static uint32_t allocate();
+	static void release(uint32_t id);
+	static EntityColdData& get(uint32_t id);
+	static int getLiveCount();
+	static size_t getReservedBytes();
+private:
+	static std::mutex _mutex;
+	static std::atomic<EntityColdData*> _chunks[ENTITY_TABLE_MAX_CHUNKS];
+	static std::vector<uint32_t> _free;
+	static uint32_t _next;
+	static int _live;
+};
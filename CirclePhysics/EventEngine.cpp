@@ -0,0 +1,371 @@
+#include "EventEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void EventEngine::reset() {
+	_bodies.clear();
+	_queue.clear();
+	_cells.clear();
+	_now = 0;
+	_clock = 0;
+	_clockError = 0;
+	_stats = EventStats();
+}
+
+void EventEngine::removeBody(int index, int last) {
+	if (last + 1 != _bodies.size()) {
+		// not built for these bodies, advance() rebuilds
+		_bodies.clear();
+		_queue.clear();
+		_cells.clear();
+		return;
+	}
+	unplace(index);
+	if (index != last) {
+		std::vector<int>& cell = _cells[cellKey(_bodies[last].cellX, _bodies[last].cellY)];
+		*std::find(cell.begin(), cell.end(), last) = index;
+	}
+	_bodies[index] = _bodies[last];
+	_bodies.pop_back();
+	_queue.erase(std::remove_if(_queue.begin(), _queue.end(), [index](const Event& e) { return e.a == index || e.b == index; }), _queue.end());
+	for (Event& e : _queue) {
+		if (e.a == last) {
+			e.a = index;
+		}
+		if (e.b == last) {
+			e.b = index;
+		}
+	}
+	std::make_heap(_queue.begin(), _queue.end());
+}
+
+double EventEngine::getTime() const {
+	return _now;
+}
+
+const EventStats& EventEngine::getStats() const {
+	return _stats;
+}
+
+void EventEngine::load(Body& b, const Collider& c) {
+	b.x = c.getPos().X;
+	b.y = c.getPos().Y;
+	b.vx = c.getVelocity().X;
+	b.vy = c.getVelocity().Y;
+	b.time = _now;
+	b.radius = c.getRadius();
+	b.inverseMass = c.getInverseMass();
+	b.moves = c.getBodyType() != BODY_STATIC;
+	if (!b.moves) {
+		b.vx = 0;
+		b.vy = 0;
+	}
+	b.writtenPos = c.getPos();
+	b.writtenVel = c.getVelocity();
+}
+
+int64_t EventEngine::cellKey(int x, int y) {
+	return ((int64_t)x << 32) | (uint32_t)y;
+}
+
+void EventEngine::place(int i) {
+	Body& b = _bodies[i];
+	b.cellX = (int)std::floor((b.x + b.vx * (_now - b.time)) / _cellSize);
+	b.cellY = (int)std::floor((b.y + b.vy * (_now - b.time)) / _cellSize);
+	_cells[cellKey(b.cellX, b.cellY)].push_back(i);
+}
+
+void EventEngine::unplace(int i) {
+	auto found = _cells.find(cellKey(_bodies[i].cellX, _bodies[i].cellY));
+	std::vector<int>& cell = found->second;
+	*std::find(cell.begin(), cell.end(), i) = cell.back();
+	cell.pop_back();
+	if (cell.empty()) {
+		_cells.erase(found);
+	}
+}
+
+void EventEngine::moveTo(Body& b, double time) {
+	b.x += b.vx * (time - b.time);
+	b.y += b.vy * (time - b.time);
+	b.time = time;
+}
+
+void EventEngine::push(const Event& e) {
+	_queue.push_back(e);
+	std::push_heap(_queue.begin(), _queue.end());
+}
+
+bool EventEngine::isStale(const Event& e) const {
+	return e.countA != _bodies[e.a].count || (e.b >= 0 && e.countB != _bodies[e.b].count);
+}
+
+void EventEngine::purge() {
+	_queue.erase(std::remove_if(_queue.begin(), _queue.end(), [this](const Event& e) { return isStale(e); }), _queue.end());
+	std::make_heap(_queue.begin(), _queue.end());
+}
+
+void EventEngine::rebuild(const std::vector<Entity*>& entities) {
+	_queue.clear();
+	_cells.clear();
+	_bodies.resize(entities.size());
+	double largest = 0;
+	for (int i = 0; i < _bodies.size(); i++) {
+		load(_bodies[i], *entities[i]->getCollider());
+		_bodies[i].count = 0;
+		largest = std::max(largest, 2 * _bodies[i].radius);
+	}
+	_cellSize = std::max(largest * EVENT_ENGINE_CELL_MARGIN, 1.0);
+	for (int i = 0; i < _bodies.size(); i++) {
+		place(i);
+	}
+	for (int i = 0; i < _bodies.size(); i++) {
+		const Body& b = _bodies[i];
+		predictWalls(i);
+		predictCell(i);
+		for (int y = b.cellY - 1; y <= b.cellY + 1; y++) {
+			for (int x = b.cellX - 1; x <= b.cellX + 1; x++) {
+				auto found = _cells.find(cellKey(x, y));
+				if (found == _cells.end()) {
+					continue;
+				}
+				for (int j : found->second) {
+					if (j > i) {
+						predictPair(i, j, entities);
+					}
+				}
+			}
+		}
+	}
+}
+
+void EventEngine::predictPair(int i, int j, const std::vector<Entity*>& entities) {
+	const Collider& ci = *entities[i]->getCollider();
+	const Collider& cj = *entities[j]->getCollider();
+	if (ci.getType() != TYPE_CIRCLE || cj.getType() != TYPE_CIRCLE || !ci.canCollideWith(cj)) {
+		return;
+	}
+	_stats.predictions++;
+	const Body& a = _bodies[i];
+	const Body& b = _bodies[j];
+	// relative motion from now on
+	double dx = (b.x + b.vx * (_now - b.time)) - (a.x + a.vx * (_now - a.time));
+	double dy = (b.y + b.vy * (_now - b.time)) - (a.y + a.vy * (_now - a.time));
+	double dvx = b.vx - a.vx;
+	double dvy = b.vy - a.vy;
+	double approach = dx * dvx + dy * dvy;
+	if (approach >= 0) {
+		return;
+	}
+	double speed2 = dvx * dvx + dvy * dvy;
+	double reach = a.radius + b.radius;
+	double gap = dx * dx + dy * dy - reach * reach;
+	double disc = approach * approach - speed2 * gap;
+	if (disc < 0) {
+		return;
+	}
+	// already overlapping and closing in: collide right away
+	double t = gap <= 0 ? 0 : -(approach + std::sqrt(disc)) / speed2;
+	push(Event{ _now + std::max(t, 0.0), i, j, a.count, b.count });
+}
+
+void EventEngine::predictWalls(int i) {
+	const Body& b = _bodies[i];
+	if (!b.moves) {
+		return;
+	}
+	double x = b.x + b.vx * (_now - b.time);
+	double y = b.y + b.vy * (_now - b.time);
+	_stats.predictions++;
+	if (b.vx != 0) {
+		double t = b.vx < 0 ? (b.radius - x) / b.vx : (_width - b.radius - x) / b.vx;
+		push(Event{ _now + std::max(t, 0.0), i, WALL_X, b.count, 0 });
+	}
+	if (b.vy != 0) {
+		double t = b.vy < 0 ? (b.radius - y) / b.vy : (_height - b.radius - y) / b.vy;
+		push(Event{ _now + std::max(t, 0.0), i, WALL_Y, b.count, 0 });
+	}
+}
+
+void EventEngine::predictCell(int i) {
+	const Body& b = _bodies[i];
+	if (!b.moves) {
+		return;
+	}
+	double x = b.x + b.vx * (_now - b.time);
+	double y = b.y + b.vy * (_now - b.time);
+	double tx = -1;
+	double ty = -1;
+	if (b.vx != 0) {
+		tx = ((b.vx > 0 ? b.cellX + 1 : b.cellX) * _cellSize - x) / b.vx;
+	}
+	if (b.vy != 0) {
+		ty = ((b.vy > 0 ? b.cellY + 1 : b.cellY) * _cellSize - y) / b.vy;
+	}
+	if (b.vx != 0 && (b.vy == 0 || tx <= ty)) {
+		push(Event{ _now + std::max(tx, 0.0), i, CELL_X, b.count, 0 });
+	}
+	else if (b.vy != 0) {
+		push(Event{ _now + std::max(ty, 0.0), i, CELL_Y, b.count, 0 });
+	}
+}
+
+void EventEngine::predictCells(int i, int x0, int x1, int y0, int y1, const std::vector<Entity*>& entities) {
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			auto found = _cells.find(cellKey(x, y));
+			if (found == _cells.end()) {
+				continue;
+			}
+			for (int j : found->second) {
+				if (j != i) {
+					predictPair(std::min(i, j), std::max(i, j), entities);
+				}
+			}
+		}
+	}
+}
+
+void EventEngine::predict(int i, const std::vector<Entity*>& entities) {
+	const Body& b = _bodies[i];
+	predictWalls(i);
+	predictCell(i);
+	predictCells(i, b.cellX - 1, b.cellX + 1, b.cellY - 1, b.cellY + 1, entities);
+}
+
+void EventEngine::advance(const std::vector<Entity*>& entities, double time, float width, float height, float restitution) {
+	_stats.frameEvents = 0;
+	bool build = entities.size() != _bodies.size() || width != _width || height != _height;
+	if (!build) {
+		// anything moved or pushed by someone else since the last frame
+		std::vector<int> changed;
+		for (int i = 0; i < _bodies.size() && !build; i++) {
+			const Collider& c = *entities[i]->getCollider();
+			Body& b = _bodies[i];
+			if (c.getPos().X != b.writtenPos.X || c.getPos().Y != b.writtenPos.Y
+				|| c.getVelocity().X != b.writtenVel.X || c.getVelocity().Y != b.writtenVel.Y) {
+				unplace(i);
+				load(b, c);
+				b.count++;
+				place(i);
+				changed.push_back(i);
+				// a body grown past the cells needs them rebuilt
+				build = 2 * b.radius * EVENT_ENGINE_CELL_MARGIN > _cellSize;
+			}
+		}
+		if (!build) {
+			for (int i : changed) {
+				predict(i, entities);
+			}
+		}
+	}
+	if (build) {
+		_width = width;
+		_height = height;
+		rebuild(entities);
+	}
+
+	// Neumaier summation: every frame ends on the correctly rounded total of
+	// the steps, not on a sum that depends on how the time was cut up
+	double sum = _clock + time;
+	_clockError += std::abs(_clock) >= std::abs(time) ? (_clock - sum) + time : (time - sum) + _clock;
+	_clock = sum;
+	double end = _clock + _clockError;
+	long long budget = (long long)EVENT_ENGINE_MAX_EVENTS_PER_BODY * std::max<size_t>(_bodies.size(), 1);
+	while (!_queue.empty() && _queue.front().time <= end) {
+		std::pop_heap(_queue.begin(), _queue.end());
+		Event e = _queue.back();
+		_queue.pop_back();
+		if (isStale(e)) {
+			_stats.staleEvents++;
+			continue;
+		}
+		if (e.b == CELL_X || e.b == CELL_Y) {
+			// predicted against the row or column of cells that came into reach
+			_now = e.time;
+			_stats.cellEvents++;
+			Body& a = _bodies[e.a];
+			unplace(e.a);
+			if (e.b == CELL_X) {
+				int step = a.vx > 0 ? 1 : -1;
+				a.cellX += step;
+				predictCells(e.a, a.cellX + step, a.cellX + step, a.cellY - 1, a.cellY + 1, entities);
+			}
+			else {
+				int step = a.vy > 0 ? 1 : -1;
+				a.cellY += step;
+				predictCells(e.a, a.cellX - 1, a.cellX + 1, a.cellY + step, a.cellY + step, entities);
+			}
+			_cells[cellKey(a.cellX, a.cellY)].push_back(e.a);
+			predictCell(e.a);
+			continue;
+		}
+		if (_stats.frameEvents >= budget) {
+			// the event stays queued for the next frame
+			push(e);
+			_stats.truncatedFrames++;
+			break;
+		}
+		_now = e.time;
+		_stats.frameEvents++;
+		Body& a = _bodies[e.a];
+		moveTo(a, _now);
+		a.count++;
+		if (e.b < 0) {
+			// walls reflect without loss, like Model::resolveOutOfBoundsCollision
+			if (e.b == WALL_X) {
+				a.vx = -a.vx;
+			}
+			else {
+				a.vy = -a.vy;
+			}
+			_stats.wallEvents++;
+			entities[e.a]->onCollideWall();
+			predict(e.a, entities);
+		}
+		else {
+			Body& b = _bodies[e.b];
+			moveTo(b, _now);
+			b.count++;
+			double nx = b.x - a.x;
+			double ny = b.y - a.y;
+			double length = std::sqrt(nx * nx + ny * ny);
+			if (length > 0) {
+				nx /= length;
+				ny /= length;
+				double closing = (b.vx - a.vx) * nx + (b.vy - a.vy) * ny;
+				double impulse = -(1 + restitution) * closing / (a.inverseMass + b.inverseMass);
+				a.vx -= nx * impulse * a.inverseMass;
+				a.vy -= ny * impulse * a.inverseMass;
+				b.vx += nx * impulse * b.inverseMass;
+				b.vy += ny * impulse * b.inverseMass;
+			}
+			_stats.pairEvents++;
+			entities[e.a]->onCollide();
+			entities[e.b]->onCollide();
+			predict(e.a, entities);
+			predict(e.b, entities);
+		}
+		if (_queue.size() > EVENT_ENGINE_QUEUE_FACTOR * (_bodies.size() + 1)) {
+			purge();
+		}
+	}
+	_now = end;
+
+	for (int i = 0; i < _bodies.size(); i++) {
+		Body& b = _bodies[i];
+		Vector2 pos{ (float)(b.x + b.vx * (_now - b.time)), (float)(b.y + b.vy * (_now - b.time)) };
+		Vector2 vel{ (float)b.vx, (float)b.vy };
+		// bodies at rest are left alone, see Entity::editCollider
+		const Collider& old = *entities[i]->getCollider();
+		if (memcmp(&old.getPos(), &pos, sizeof(Vector2)) != 0 || memcmp(&old.getVelocity(), &vel, sizeof(Vector2)) != 0) {
+			Collider& c = *entities[i]->editCollider();
+			c.setPosition(pos);
+			c.setVelocity(vel);
+		}
+		b.writtenPos = pos;
+		b.writtenVel = vel;
+	}
+	_stats.queued = (int)_queue.size();
+}
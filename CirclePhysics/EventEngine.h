@@ -0,0 +1,121 @@
+#pragma once
+#include "Entity.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// a frame that needs more events than this per body is cut short, which only
+// happens when inelastic bodies collapse into each other
+#define EVENT_ENGINE_MAX_EVENTS_PER_BODY 1000
+// stale events are purged from the queue once it is this many times the body count
+#define EVENT_ENGINE_QUEUE_FACTOR 16
+// cells are this much wider than the largest body, so a body whose cell is
+// off by rounding at a crossing still finds everything it can touch
+#define EVENT_ENGINE_CELL_MARGIN 1.01
+
+struct EventStats {
+	long long pairEvents = 0;
+	long long wallEvents = 0;
+	// events popped after one of their bodies had already collided
+	long long staleEvents = 0;
+	// bodies moving into a new cell, not counted in frameEvents
+	long long cellEvents = 0;
+	long long predictions = 0;
+	int frameEvents = 0;
+	int truncatedFrames = 0;
+	int queued = 0;
+};
+
+// Event-driven hard disk simulation. Bodies fly in straight lines between
+// collisions, so instead of stepping every body the engine predicts when each
+// pair and each body and wall will next touch, keeps those times in a priority
+// queue, and jumps from one event to the next. Every body carries a collision
+// counter; an event remembers the counters it was predicted with and is
+// dropped when popped if either changed (lazy invalidation).
+//
+// Pairs are only predicted between bodies in neighboring cells of a grid at
+// least as wide as the largest body, so a prediction costs the bodies around
+// one body rather than all of them. A body crossing into another cell is an
+// event too, which predicts it against the bodies it has come near.
+//
+// State is kept in double precision between frames and only written back to
+// the colliders at the end of advance(). Nothing is predicted at frame
+// boundaries and the frame clock is kept as a compensated sum, so the end of
+// a frame is the same double whatever steps led up to it, and without outside
+// changes the positions written back do not depend on how often advance() is
+// called. Velocities or positions changed from outside (player input,
+// steering) are picked up at the start of the next advance(). Exact for
+// restitution 1 with friction and the speed cap off.
+class EventEngine {
+public:
+	void reset();
+	// Body last moves into index, as in BasicModel::removeEntity; the events
+	// of the others are kept
+	void removeBody(int index, int last);
+	void advance(const std::vector<Entity*>& entities, double time, float width, float height, float restitution);
+	double getTime() const;
+	const EventStats& getStats() const;
+private:
+	struct Body {
+		// position at time `time`
+		double x, y;
+		double vx, vy;
+		double time;
+		double radius;
+		double inverseMass;
+		uint32_t count;
+		bool moves;
+		// the cell the body is filed under
+		int cellX, cellY;
+		// what was last written to the collider, to notice outside changes
+		Vector2 writtenPos;
+		Vector2 writtenVel;
+	};
+	struct Event {
+		double time;
+		int a;
+		// other body, or a WALL_ value
+		int b;
+		uint32_t countA;
+		uint32_t countB;
+		// for a min-heap on time
+		bool operator<(const Event& other) const {
+			return time > other.time;
+		}
+	};
+	enum {
+		WALL_X = -1,
+		WALL_Y = -2,
+		CELL_X = -3,
+		CELL_Y = -4
+	};
+	void rebuild(const std::vector<Entity*>& entities);
+	void load(Body& b, const Collider& c);
+	void predict(int i, const std::vector<Entity*>& entities);
+	void predictPair(int i, int j, const std::vector<Entity*>& entities);
+	void predictWalls(int i);
+	// the next time the body moves into another cell
+	void predictCell(int i);
+	// against every other body filed in the cells x0..x1, y0..y1
+	void predictCells(int i, int x0, int x1, int y0, int y1, const std::vector<Entity*>& entities);
+	static int64_t cellKey(int x, int y);
+	void place(int i);
+	void unplace(int i);
+	void push(const Event& e);
+	bool isStale(const Event& e) const;
+	void purge();
+	void moveTo(Body& b, double time);
+
+	std::vector<Body> _bodies;
+	// binary heap ordered by Event::operator<
+	std::vector<Event> _queue;
+	double _now = 0;
+	// the end of the last frame as a sum and its rounding error
+	double _clock = 0;
+	double _clockError = 0;
+	double _cellSize = 1;
+	std::unordered_map<int64_t, std::vector<int>> _cells;
+	float _width = 0;
+	float _height = 0;
+	EventStats _stats;
+};
@@ -0,0 +1,85 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+FramePacer::FramePacer(double framesPerSecond) {
+	setRate(framesPerSecond);
+	start();
+}
+
+void FramePacer::setRate(double framesPerSecond) {
+	_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+}
+
+double FramePacer::getRate() const {
+	return 1.0 / std::chrono::duration<double>(_period).count();
+}
+
+void FramePacer::start() {
+	_previous = Clock::now();
+	_deadline = _previous + _period;
+}
+
+double FramePacer::wait() {
+	Clock::time_point now = Clock::now();
+	if (now <= _deadline) {
+		Clock::time_point wake = _deadline - _sleepError - std::chrono::microseconds(FRAME_PACER_SPIN_MICROSECONDS);
+		if (wake > now) {
+			std::this_thread::sleep_until(wake);
+			Clock::duration oversleep = Clock::now() - wake;
+			Clock::duration cap = std::chrono::duration_cast<Clock::duration>(_period * FRAME_PACER_MAX_SPIN_FRACTION);
+			_sleepError = std::min(std::max(oversleep, _sleepError - _sleepError / 16), cap);
+		}
+		while ((now = Clock::now()) < _deadline) {
+		}
+	}
+	if (now > _deadline + std::chrono::microseconds(FRAME_PACER_MISS_MICROSECONDS)) {
+		_missed++;
+		_deadline = now;
+	}
+	_deadline += _period;
+
+	double elapsed = std::chrono::duration<double>(now - _previous).count();
+	_previous = now;
+	if (_frameTimes.size() < FRAME_PACER_HISTORY) {
+		_frameTimes.push_back(elapsed * 1000);
+	}
+	else {
+		_frameTimes[_next] = elapsed * 1000;
+		_next = (_next + 1) % FRAME_PACER_HISTORY;
+	}
+	_frames++;
+	return elapsed;
+}
+
+PacingStats FramePacer::getStats() const {
+	PacingStats stats;
+	stats.frames = _frames;
+	stats.missed = _missed;
+	if (_frameTimes.empty()) {
+		return stats;
+	}
+	std::vector<double> sorted = _frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+	int n = (int)sorted.size();
+	for (double t : sorted) {
+		stats.mean += t / n;
+	}
+	stats.p50 = sorted[(n - 1) / 2];
+	stats.p99 = sorted[(n - 1) * 99 / 100];
+	stats.max = sorted[n - 1];
+	return stats;
+}
+
+int FramePacer::getMissed() const {
+	return _missed;
+}
+
+void FramePacer::resetStats() {
+	_frameTimes.clear();
+	_next = 0;
+	_frames = 0;
+	_missed = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <vector>
+
+// how long before a deadline the pacer stops sleeping and spins, on top of
+// the worst oversleep it has seen recently
+#define FRAME_PACER_SPIN_MICROSECONDS 200
+// the oversleep allowance never grows past this fraction of the period, a
+// long spin loses the CPU to other runnable threads
+#define FRAME_PACER_MAX_SPIN_FRACTION 0.25
+// a frame that ends this long after its deadline counts as missed
+#define FRAME_PACER_MISS_MICROSECONDS 500
+// frame times kept for the percentiles
+#define FRAME_PACER_HISTORY 4096
+
+// Frame times in milliseconds
+struct PacingStats {
+	int frames = 0;
+	int missed = 0;
+	double mean = 0;
+	double p50 = 0;
+	double p99 = 0;
+	double max = 0;
+};
+
+// Holds a fixed frame rate on the steady clock. wait() sleeps coarsely until
+// shortly before the next deadline and spins the rest, so the frame rate does
+// not depend on the scheduler's sleep granularity. Deadlines advance by exactly
+// one period. A frame that ends more than FRAME_PACER_MISS_MICROSECONDS after
+// its deadline, because the work ran long or the wake came late, counts as
+// missed and the schedule restarts from now rather than trying to catch up.
+class FramePacer {
+public:
+	FramePacer(double framesPerSecond = 100);
+	void setRate(double framesPerSecond);
+	double getRate() const;
+	// Starts the schedule, the first deadline is one period from now
+	void start();
+	// Blocks until the next deadline, returns the seconds since the last one
+	double wait();
+	PacingStats getStats() const;
+	// Cheap to call every frame, getStats() sorts the history
+	int getMissed() const;
+	void resetStats();
+private:
+	std::chrono::steady_clock::duration _period;
+	std::chrono::steady_clock::time_point _deadline;
+	std::chrono::steady_clock::time_point _previous;
+	// worst recent oversleep, decays so one bad wake does not spin forever
+	std::chrono::steady_clock::duration _sleepError{};
+	std::vector<double> _frameTimes;
+	int _next = 0;
+	int _frames = 0;
+	int _missed = 0;
+};
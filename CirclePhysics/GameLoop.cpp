@@ -11,16 +11,23 @@
 #include "Controller.h"
 #include "Player.h"
 #include "Enemy.h"
+#include "BatchRunner.h"
+#include "JobGraph.h"
+#include "FramePacer.h"
+#include "StatsSegment.h"
+#include "SceneGenerator.h"
 
 #define WINDOW_HEIGHT 750
 #define WINDOW_WIDTH 750
-#define MS_PER_FRAME 10
+#define FRAMES_PER_SECOND 100
 #define COLLIDER_MASS_DEFAULT 1
 #define COLLIDER_WIDTH_DEFAULT 5
 #define COLLIDER_HEIGHT_DEFAULT 5
 
 #define RAND_COLLIDERS_INITIALIZED 15
+#define RAND_SCENE_SEED 1
 #define INIT_FROM_FILE false
+#define INIT_GEOMETRY_FROM_FILE false
 #define MAX_WIDTH_HEIGHT 40
 #define MIN_WIDTH_HEIGHT 8
 #define MAX_AXIS_VELOCITY 60
@@ -61,13 +68,18 @@ Collider createColliderFromLine(std::vector<std::string> values) {
 	float width_height = stof(values.at(4));
 	float mass = stof(values.at(5));
 	int type = stoi(values.at(6));
-	return Collider(pos, vel, width_height, width_height, mass, Color(0xff, 0xff, 0xff), type);
+	Collider c = Collider(pos, vel, width_height, mass, type);
+	// optional eighth column: body type (0 dynamic, 1 static, 2 kinematic)
+	if (values.size() > 7) {
+		c.setBodyType(stoi(values.at(7)));
+	}
+	return c;
 }
 
 void instantiateCollidersFromFile(Model& m) {
 	std::fstream in_file{ "./colliders.txt", std::ios::in };
 	std::string line;
-	int lineNum = 0;
+	NameId name = NamePool::intern("enemy");
 	if (in_file.is_open()) {
 		while (!in_file.eof()) {
 			getline(in_file, line);
@@ -76,10 +88,9 @@ void instantiateCollidersFromFile(Model& m) {
 			}
 			std::vector<std::string> values = split(line);
 			Collider c = createColliderFromLine(values);
-			std::string name = "enemy" + std::to_string(lineNum);
+			c.setLayer(LAYER_ENEMY);
 			Enemy* e = new Enemy(c, name);
 			m.addEntity(e);
-			lineNum++;
 		}
 
 	}
@@ -88,9 +99,85 @@ void instantiateCollidersFromFile(Model& m) {
 	}
 }
 
-int main() {
+int runBatch(int worlds, std::string path) {
+	ThreadPool pool;
+	BatchRunner runner(pool);
+	WorldConfig config;
+	config.width = WIDTH;
+	config.height = HEIGHT;
+	config.enemies = RAND_COLLIDERS_INITIALIZED;
+	// the worlds are split evenly over every pair of parameters
+	std::vector<float> restitutions = { 0.6f, 0.8f, 1.0f };
+	std::vector<float> frictions = { 0.0f, 0.4f, 0.8f };
+	int seeds = std::max(1, worlds / (int)(restitutions.size() * frictions.size()));
+	runner.addSweep(config, restitutions, frictions, seeds);
+	runner.run();
+
+	std::ofstream out{ path, std::ios::out };
+	if (!out.is_open()) {
+		std::cout << "Could not write " << path << "\n";
+		return EXIT_FAILURE;
+	}
+	if (path.size() >= 5 && path.substr(path.size() - 5) == ".json") {
+		runner.writeJson(out);
+	}
+	else {
+		runner.writeCsv(out);
+	}
+	std::cout << "Ran " << runner.getResults().size() << " worlds on " << pool.getThreadCount() << " threads in " << runner.getWallMilliseconds() << " ms\n";
+	return 0;
+}
+
+SceneSettings sceneSettings(uint64_t seed, int bodies) {
+	SceneSettings settings;
+	settings.seed = seed;
+	settings.bodies = bodies;
+	settings.width = WIDTH;
+	settings.height = HEIGHT;
+	settings.minSize = MIN_WIDTH_HEIGHT;
+	settings.maxSize = MAX_WIDTH_HEIGHT;
+	settings.maxAxisVelocity = MAX_AXIS_VELOCITY;
+	settings.massSizeRatio = MASS_WIDTH_HEIGHT_RATIO;
+	return settings;
+}
+
+int writeScene(int bodies, uint64_t seed, std::string path) {
+	ThreadPool pool;
+	SceneGenerator generator(pool);
+	SceneSettings settings = sceneSettings(seed, bodies);
+	settings.rejectOverlaps = true;
+	generator.generate(settings);
+	try {
+		generator.writeFile(path);
+	}
+	catch (...) {
+		std::cout << "Could not write " << path << "\n";
+		return EXIT_FAILURE;
+	}
+	const SceneStats& stats = generator.getStats();
+	std::cout << "Generated " << stats.bodies << " bodies (" << stats.dropped << " left out) in " << stats.milliseconds << " ms, "
+		<< stats.getBodiesPerSecond() << " bodies/s\n";
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	// CirclePhysics --batch <worlds> <results.csv|results.json>
+	if (argc > 1 && std::string(argv[1]) == "--batch") {
+		int worlds = argc > 2 ? std::stoi(argv[2]) : 1000;
+		std::string path = argc > 3 ? argv[3] : "batch.csv";
+		return runBatch(worlds, path);
+	}
+	// CirclePhysics --scene <bodies> <seed> <colliders.txt>
+	if (argc > 1 && std::string(argv[1]) == "--scene") {
+		int bodies = argc > 2 ? std::stoi(argv[2]) : RAND_COLLIDERS_INITIALIZED;
+		uint64_t seed = argc > 3 ? std::stoull(argv[3]) : RAND_SCENE_SEED;
+		std::string path = argc > 4 ? argv[4] : "colliders.txt";
+		return writeScene(bodies, seed, path);
+	}
 
 	Model m = Model(WIDTH, HEIGHT);
+	ThreadPool pool;
+	m.setThreadPool(&pool);
 
 
 	if (INIT_FROM_FILE) {
@@ -103,20 +190,22 @@ int main() {
 		}
 	}
 	else {
-		for (int i = 0; i < RAND_COLLIDERS_INITIALIZED; i++) {
-			Vector2 pos;
-			float width_height = rand() % (MAX_WIDTH_HEIGHT - MIN_WIDTH_HEIGHT) + MIN_WIDTH_HEIGHT;
-			float mass = width_height * MASS_WIDTH_HEIGHT_RATIO;
+		SceneGenerator generator(pool);
+		generator.generate(sceneSettings(RAND_SCENE_SEED, RAND_COLLIDERS_INITIALIZED));
+		for (Entity* e : generator.addTo(m)) {
+			float mass = e->getCollider()->getMass();
 			int color = MAX_RGB - ((mass - (MAX_WIDTH_HEIGHT * MASS_WIDTH_HEIGHT_RATIO)) / ((MAX_WIDTH_HEIGHT - MIN_WIDTH_HEIGHT) * MASS_WIDTH_HEIGHT_RATIO) * MAX_RGB);
-			pos.X = fmod(rand(), (m.getWidth() - width_height)) + width_height/2;
-			pos.Y = fmod(rand(), (m.getHeight() - width_height)) + width_height/2;
-			Vector2 vel;
-			vel.X = rand() % (MAX_AXIS_VELOCITY);
-			vel.Y = rand() % (MAX_AXIS_VELOCITY);
-			Collider c = Collider(pos, vel, width_height, width_height, mass, Color(color, color, color), 0);
-			std::string name = "enemy" + std::to_string(i);
-			Enemy* e = new Enemy(c, name);
-			m.addEntity(e);
+			e->setColor(Color(color, color, color).ToARGB());
+		}
+	}
+
+	if (INIT_GEOMETRY_FROM_FILE) {
+		try {
+			m.setGeometry(StaticGeometry::fromFile("./geometry.txt"));
+		}
+		catch (...) {
+			std::cout << "Loading geometry has failed\n";
+			return EXIT_FAILURE;
 		}
 	}
 
@@ -125,11 +214,17 @@ int main() {
 	startPos.Y = m.getHeight()/2;
 	Vector2 startVel = Vector2();
 	Color c = Color(c.MAGENTA);
-	Collider hitbox = Collider(startPos, startVel, MIN_WIDTH_HEIGHT, MIN_WIDTH_HEIGHT, 1, c, 0);
+	Collider hitbox = Collider(startPos, startVel, MIN_WIDTH_HEIGHT, 1);
+	hitbox.setLayer(LAYER_PLAYER);
 	Player* p =  new Player(hitbox, "Player");
+	p->setColor(c.ToARGB());
 	m.addEntity(p);
 	m.setPlayer(p);
 
+	SteeringSettings& steering = m.getSteering().getSettings();
+	steering.enabled = true;
+	steering.layers = LAYER_ENEMY;
+
 
 	Renderer r = Renderer(&m);
 	Controller controller = Controller();
@@ -140,28 +235,73 @@ int main() {
 
 	
 
-	auto start = std::chrono::system_clock::now();
-	auto previous = std::chrono::system_clock::now();
-	while (p->getActive() && !window->IsDisposed()) {
-		for (int i = 0; i < m.getEntities().size(); i++) {
-			/*Entity* e = m.getEntities().at(i);*/
-			/*std::string debug = "Player is at " + std::to_string(p->getCollider()->getPos().X) + "," + std::to_string(p->getCollider()->getPos().Y) + "\n\n";
-			std::cout << debug;*/
+	auto start = std::chrono::steady_clock::now();
+	FramePacer pacer(FRAMES_PER_SECOND);
+	double elapsed = 0;
+	Vector2 v;
+
+	// the frame as dependent jobs, HUD prep overlaps with the physics chain
+	JobGraph frame;
+	std::vector<DirectionChange> changes;
+	InputLatency latency;
+	r.setLatency(&latency);
+	int input = frame.addJob("input", [&] {
+		auto frameEnd = std::chrono::steady_clock::now();
+		auto frameStart = frameEnd - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(elapsed));
+		controller.getQueue().collect(frameStart, frameEnd, changes, &latency);
+	});
+	int broadphase = frame.addJob("broadphase", [&] { m.broadphase(); }, { input });
+	int steer = frame.addJob("steering", [&] { m.beginFrame(elapsed); }, { broadphase });
+	int narrow = frame.addJob("narrow phase", [&] { m.narrowPhase(); }, { steer });
+	int solve = frame.addJob("solve", [&] { m.solve(); }, { narrow });
+	int integrate = frame.addJob("integrate", [&] {
+		m.integrateFrame(elapsed, v, changes);
+		if (!changes.empty()) {
+			v = changes.back().direction;
 		}
-		auto current = std::chrono::system_clock::now();
-		std::chrono::duration<double> elapsed_seconds = current - previous;
-		previous = current;
-		Vector2 v = controller.getDirection();
-		m.update(elapsed_seconds.count(), v);
-		std::chrono::duration<double> timer = current - start;
+		latency.simulated(std::chrono::steady_clock::now());
+	}, { solve });
+	int events = frame.addJob("gameplay events", [&] { m.dispatchEvents(); }, { integrate });
+	frame.addJob("snapshot", [&] { r.capture(); }, { events });
+	frame.addJob("hud", [&] {
+		std::chrono::duration<double> timer = std::chrono::steady_clock::now() - start;
 		r.setCurrTime(timer.count());
+	}, { input });
+
+	// live counters for StatsTail, the game runs without them if the segment cannot be made
+	StatsSegment stats;
+	if (!stats.create()) {
+		std::cout << "Could not create the stats segment\n";
+	}
+
+	int frames = 0;
+	double wallTotal = 0;
+	double criticalTotal = 0;
+	pacer.start();
+	while (p->getActive() && !window->IsDisposed()) {
+		elapsed = pacer.wait();
+		frame.run(&pool);
+		const FrameTiming& timing = frame.getTiming();
+		frames++;
+		wallTotal += timing.wallMilliseconds;
+		criticalTotal += timing.criticalPathMilliseconds;
+		stats.recordModel(m, elapsed);
+		stats.recordFrame(elapsed * 1000, timing.wallMilliseconds, pacer.getMissed());
+		stats.publish();
 		window->Invalidate();
-		if (elapsed_seconds.count() * 1000 < MS_PER_FRAME) {
-			Sleep(MS_PER_FRAME - (elapsed_seconds.count() * 1000));
-		}
+	}
+	if (frames > 0) {
+		PacingStats pacing = pacer.getStats();
+		std::cout << "Average frame " << wallTotal / frames << " ms, critical path " << criticalTotal / frames << " ms\n";
+		std::cout << "Frame time p50 " << pacing.p50 << " ms, p99 " << pacing.p99 << " ms, max " << pacing.max << " ms, "
+			<< pacing.missed << " of " << pacing.frames << " deadlines missed\n";
+		LatencyStats simulation = latency.getSimulationStats();
+		LatencyStats present = latency.getPresentStats();
+		std::cout << "Input to simulation p50 " << simulation.p50 << " ms, p99 " << simulation.p99
+			<< " ms, input to present p50 " << present.p50 << " ms, p99 " << present.p99 << " ms\n";
 	}
 	if (!p->getActive()) {
-		auto end = std::chrono::system_clock::now();
+		auto end = std::chrono::steady_clock::now();
 		std::chrono::duration<double> time_alive = end - start;
 		std::string s = "You are dead. You survived " + std::to_string(time_alive.count()) + " seconds.";
 		r.setDefault(s);
@@ -0,0 +1,116 @@
+#include "InputQueue.h"
+#include <algorithm>
+
+bool InputQueue::push(const InputEvent& e) {
+	unsigned int tail = _tail.load(std::memory_order_relaxed);
+	if (tail - _head.load(std::memory_order_acquire) == INPUT_QUEUE_CAPACITY) {
+		return false;
+	}
+	_events[tail & (INPUT_QUEUE_CAPACITY - 1)] = e;
+	_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::pop(InputEvent& e) {
+	unsigned int head = _head.load(std::memory_order_relaxed);
+	if (head == _tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+	e = _events[head & (INPUT_QUEUE_CAPACITY - 1)];
+	_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+void InputQueue::collect(std::chrono::steady_clock::time_point frameStart, std::chrono::steady_clock::time_point frameEnd,
+	std::vector<DirectionChange>& changes, InputLatency* latency) {
+	changes.clear();
+	unsigned int head = _head.load(std::memory_order_relaxed);
+	unsigned int tail = _tail.load(std::memory_order_acquire);
+	for (; head != tail; head++) {
+		const InputEvent& e = _events[head & (INPUT_QUEUE_CAPACITY - 1)];
+		if (e.time > frameEnd) {
+			break;
+		}
+		// a press from before the step, e.g. while the loop was stalled, lands at its start
+		double offset = std::max(0.0, std::chrono::duration<double>(e.time - frameStart).count());
+		changes.push_back(DirectionChange{ offset, e.direction });
+		if (latency != nullptr) {
+			latency->add(e.time);
+		}
+	}
+	_head.store(head, std::memory_order_release);
+}
+
+void InputLatency::add(std::chrono::steady_clock::time_point input) {
+	_awaitingSimulation.push_back(input);
+}
+
+void InputLatency::simulated(std::chrono::steady_clock::time_point now) {
+	for (std::chrono::steady_clock::time_point input : _awaitingSimulation) {
+		record(_simulation, _nextSimulation, std::chrono::duration<double, std::milli>(now - input).count());
+		_awaitingCapture.push_back(input);
+	}
+	_awaitingSimulation.clear();
+}
+
+void InputLatency::captured() {
+	std::lock_guard<std::mutex> lock(_presentMutex);
+	_awaitingPresent.insert(_awaitingPresent.end(), _awaitingCapture.begin(), _awaitingCapture.end());
+	_awaitingCapture.clear();
+}
+
+void InputLatency::presented(std::chrono::steady_clock::time_point now) {
+	std::lock_guard<std::mutex> lock(_presentMutex);
+	for (std::chrono::steady_clock::time_point input : _awaitingPresent) {
+		record(_present, _nextPresent, std::chrono::duration<double, std::milli>(now - input).count());
+	}
+	_awaitingPresent.clear();
+}
+
+LatencyStats InputLatency::getSimulationStats() const {
+	return summarize(_simulation);
+}
+
+LatencyStats InputLatency::getPresentStats() const {
+	std::lock_guard<std::mutex> lock(_presentMutex);
+	return summarize(_present);
+}
+
+void InputLatency::reset() {
+	std::lock_guard<std::mutex> lock(_presentMutex);
+	_awaitingSimulation.clear();
+	_awaitingCapture.clear();
+	_awaitingPresent.clear();
+	_simulation.clear();
+	_present.clear();
+	_nextSimulation = 0;
+	_nextPresent = 0;
+}
+
+void InputLatency::record(std::vector<double>& samples, int& next, double value) {
+	if (samples.size() < INPUT_LATENCY_HISTORY) {
+		samples.push_back(value);
+	}
+	else {
+		samples[next] = value;
+		next = (next + 1) % INPUT_LATENCY_HISTORY;
+	}
+}
+
+LatencyStats InputLatency::summarize(const std::vector<double>& samples) {
+	LatencyStats stats;
+	if (samples.empty()) {
+		return stats;
+	}
+	std::vector<double> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+	int n = (int)sorted.size();
+	stats.samples = n;
+	for (double t : sorted) {
+		stats.mean += t / n;
+	}
+	stats.p50 = sorted[(n - 1) / 2];
+	stats.p99 = sorted[(n - 1) * 99 / 100];
+	stats.max = sorted[n - 1];
+	return stats;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Vector2.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// must be a power of two
+#define INPUT_QUEUE_CAPACITY 256
+// latencies kept for the percentiles
+#define INPUT_LATENCY_HISTORY 4096
+
+struct InputEvent {
+	Vector2 direction;
+	std::chrono::steady_clock::time_point time;
+};
+
+// A direction the player switched to part way through a step, offset is in
+// seconds from the start of the step
+struct DirectionChange {
+	double offset;
+	Vector2 direction;
+};
+
+// Milliseconds
+struct LatencyStats {
+	int samples = 0;
+	double mean = 0;
+	double p50 = 0;
+	double p99 = 0;
+	double max = 0;
+};
+
+// Input-to-simulation is from the key press to the end of the step that
+// applied it, input-to-present to when the window drew a snapshot of that
+// step. presented() and the present stats may be called from the window
+// thread, the rest belongs to the frame.
+class InputLatency {
+public:
+	void add(std::chrono::steady_clock::time_point input);
+	// Everything added since the last call has now been simulated
+	void simulated(std::chrono::steady_clock::time_point now);
+	// Everything simulated since the last call is in the snapshot just taken
+	void captured();
+	// Everything captured since the last call has now been drawn
+	void presented(std::chrono::steady_clock::time_point now);
+	LatencyStats getSimulationStats() const;
+	LatencyStats getPresentStats() const;
+	void reset();
+private:
+	static void record(std::vector<double>& samples, int& next, double value);
+	static LatencyStats summarize(const std::vector<double>& samples);
+
+	std::vector<std::chrono::steady_clock::time_point> _awaitingSimulation;
+	std::vector<std::chrono::steady_clock::time_point> _awaitingCapture;
+	// guards the present side
+	mutable std::mutex _presentMutex;
+	std::vector<std::chrono::steady_clock::time_point> _awaitingPresent;
+	std::vector<double> _simulation;
+	std::vector<double> _present;
+	int _nextSimulation = 0;
+	int _nextPresent = 0;
+};
+
+// Single producer, single consumer ring of timestamped direction changes. The
+// window thread pushes from its key handler and the frame drains it, neither
+// side ever takes a lock. A push into a full queue is dropped.
+class InputQueue {
+public:
+	bool push(const InputEvent& e);
+	bool pop(InputEvent& e);
+	// Takes every event stamped before frameEnd and turns it into a change at
+	// its offset into the step that started at frameStart. Later events stay
+	// queued for the next frame
+	void collect(std::chrono::steady_clock::time_point frameStart, std::chrono::steady_clock::time_point frameEnd,
+		std::vector<DirectionChange>& changes, InputLatency* latency = nullptr);
+private:
+	InputEvent _events[INPUT_QUEUE_CAPACITY];
+	// written by the consumer
+	alignas(64) std::atomic<unsigned int> _head{ 0 };
+	// written by the producer
+	alignas(64) std::atomic<unsigned int> _tail{ 0 };
+};
@@ -0,0 +1,97 @@
+#include "JobGraph.h"
+
+int JobGraph::addJob(const std::string& name, std::function<void()> body, const std::vector<int>& dependencies) {
+	int id = (int)_jobs.size();
+	for (int d : dependencies) {
+		if (d < 0 || d >= id) {
+			throw "Job depends on a job that was not added before it.";
+		}
+		_jobs[d].dependents.push_back(id);
+	}
+	_jobs.push_back(Job{ name, std::move(body), dependencies, {} });
+	return id;
+}
+
+void JobGraph::run(ThreadPool* pool) {
+	int n = (int)_jobs.size();
+	_timing.jobs.assign(n, JobTiming());
+	_start = std::chrono::steady_clock::now();
+	if (pool == nullptr) {
+		for (int i = 0; i < n; i++) {
+			execute(i, nullptr);
+		}
+	}
+	else {
+		if (_remainingSize != n) {
+			_remaining.reset(new std::atomic<int>[n]);
+			_remainingSize = n;
+		}
+		for (int i = 0; i < n; i++) {
+			_remaining[i] = (int)_jobs[i].dependencies.size();
+		}
+		for (int i = 0; i < n; i++) {
+			if (_jobs[i].dependencies.empty()) {
+				pool->submit([this, i, pool] { execute(i, pool); });
+			}
+		}
+		pool->wait();
+	}
+	_timing.wallMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+	measure();
+}
+
+void JobGraph::execute(int job, ThreadPool* pool) {
+	JobTiming& timing = _timing.jobs[job];
+	timing.start = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+	_jobs[job].body();
+	timing.end = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+	if (pool == nullptr) {
+		return;
+	}
+	for (int d : _jobs[job].dependents) {
+		if (--_remaining[d] == 0) {
+			pool->submit([this, d, pool] { execute(d, pool); });
+		}
+	}
+}
+
+void JobGraph::measure() {
+	// longest path by duration, jobs are already in topological order
+	int n = (int)_jobs.size();
+	std::vector<double> finish(n);
+	std::vector<int> previous(n, -1);
+	_timing.workMilliseconds = 0;
+	int last = -1;
+	for (int i = 0; i < n; i++) {
+		double duration = _timing.jobs[i].end - _timing.jobs[i].start;
+		_timing.workMilliseconds += duration;
+		double ready = 0;
+		for (int d : _jobs[i].dependencies) {
+			if (finish[d] > ready) {
+				ready = finish[d];
+				previous[i] = d;
+			}
+		}
+		finish[i] = ready + duration;
+		if (last < 0 || finish[i] > finish[last]) {
+			last = i;
+		}
+	}
+	_timing.criticalPath.clear();
+	_timing.criticalPathMilliseconds = last < 0 ? 0 : finish[last];
+	for (int i = last; i >= 0; i = previous[i]) {
+		_timing.criticalPath.insert(_timing.criticalPath.begin(), i);
+	}
+}
+
+int JobGraph::getJobCount() const {
+	return (int)_jobs.size();
+}
+
+const std::string& JobGraph::getName(int job) const {
+	return _jobs[job].name;
+}
+
+const FrameTiming& JobGraph::getTiming() const {
+	return _timing;
+}
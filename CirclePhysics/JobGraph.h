@@ -0,0 +1,54 @@
+#pragma once
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Milliseconds from the start of run()
+struct JobTiming {
+	double start = 0;
+	double end = 0;
+};
+
+struct FrameTiming {
+	double wallMilliseconds = 0;
+	// sum of all job durations, what a serial frame would have cost
+	double workMilliseconds = 0;
+	// longest chain of dependent jobs by measured duration
+	double criticalPathMilliseconds = 0;
+	std::vector<int> criticalPath;
+	std::vector<JobTiming> jobs;
+};
+
+// A frame declared as jobs with dependencies, built once and run every frame.
+// A job is submitted to the pool as soon as everything it depends on has
+// finished, so independent jobs overlap. Dependencies have to be jobs that
+// were added earlier, which keeps the graph acyclic and makes the order jobs
+// were added in a valid serial order.
+class JobGraph {
+public:
+	int addJob(const std::string& name, std::function<void()> body, const std::vector<int>& dependencies = {});
+	// Runs every job once, serially in the order they were added when pool is null
+	void run(ThreadPool* pool);
+	int getJobCount() const;
+	const std::string& getName(int job) const;
+	const FrameTiming& getTiming() const;
+private:
+	struct Job {
+		std::string name;
+		std::function<void()> body;
+		std::vector<int> dependencies;
+		std::vector<int> dependents;
+	};
+	void execute(int job, ThreadPool* pool);
+	void measure();
+
+	std::vector<Job> _jobs;
+	std::unique_ptr<std::atomic<int>[]> _remaining;
+	int _remainingSize = 0;
+	std::chrono::steady_clock::time_point _start;
+	FrameTiming _timing;
+};
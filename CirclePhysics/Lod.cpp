@@ -0,0 +1,117 @@
+#include "Lod.h"
+#include <algorithm>
+#include <cfloat>
+
+double LodStats::getFraction(int level) const {
+	int total = 0;
+	for (int b : bodies) {
+		total += b;
+	}
+	return total == 0 ? 0 : (double)bodies[level] / total;
+}
+
+LodSettings& LodSystem::getSettings() {
+	return _settings;
+}
+
+const LodSettings& LodSystem::getSettings() const {
+	return _settings;
+}
+
+LodStats& LodSystem::getStats() {
+	return _stats;
+}
+
+const LodStats& LodSystem::getStats() const {
+	return _stats;
+}
+
+int LodSystem::levelFor(float distance, int current) const {
+	int count = (int)_settings.levels.size();
+	int level = count - 1;
+	for (int l = 0; l < count; l++) {
+		if (distance <= _settings.levels[l].radius) {
+			level = l;
+			break;
+		}
+	}
+	// coarser only once clearly past the edge of the current level
+	if (level > current && distance <= _settings.levels[current].radius * (1 + _settings.hysteresis)) {
+		return current;
+	}
+	return level;
+}
+
+void LodSystem::assign(const std::vector<Vector2>& positions, const std::vector<char>& movable,
+	const std::vector<Vector2>& points, int pinned) {
+	int n = (int)positions.size();
+	int count = (int)_settings.levels.size();
+	_levels.resize(n, 0);
+	_previousLevels.resize(n, 0);
+	_changedAt.resize(n, -LOD_REVERSAL_FRAMES);
+	_active.assign(n, 1);
+	_stats.bodies.assign(count, 0);
+	_stats.stepped = 0;
+	_stats.skippedSteps = 0;
+	_stats.skippedPairs = 0;
+	_stats.changes = 0;
+	_stats.reversals = 0;
+	for (int i = 0; i < n; i++) {
+		float nearest = FLT_MAX;
+		for (const Vector2& p : points) {
+			nearest = std::min(nearest, getLength(positions[i] - p));
+		}
+		int level = i == pinned ? 0 : levelFor(nearest, std::min(_levels[i], count - 1));
+		if (level != _levels[i]) {
+			_stats.changes++;
+			if (level == _previousLevels[i] && _frame - _changedAt[i] < LOD_REVERSAL_FRAMES) {
+				_stats.reversals++;
+			}
+			_previousLevels[i] = _levels[i];
+			_changedAt[i] = _frame;
+		}
+		_levels[i] = level;
+		_stats.bodies[level]++;
+		// static bodies never step, a pair with one only needs testing when the other moved
+		if (!movable[i]) {
+			_active[i] = 0;
+			continue;
+		}
+		int interval = std::max(1, _settings.levels[level].interval);
+		_active[i] = (_frame + i) % interval == 0;
+		if (_active[i]) {
+			_stats.stepped++;
+		}
+		else {
+			_stats.skippedSteps++;
+		}
+	}
+	_frame++;
+}
+
+bool LodSystem::isActive(int body) const {
+	return _active[body] != 0;
+}
+
+bool LodSystem::isCoarse(int body) const {
+	return _settings.levels[_levels[body]].coarse;
+}
+
+int LodSystem::getLevel(int body) const {
+	return _levels[body];
+}
+
+void LodSystem::removeBody(int body, int last) {
+	if (last < _levels.size()) {
+		_levels[body] = _levels[last];
+		_levels.resize(last);
+		_previousLevels[body] = _previousLevels[last];
+		_previousLevels.resize(last);
+		_changedAt[body] = _changedAt[last];
+		_changedAt.resize(last);
+	}
+	if (last < _active.size()) {
+		_active[body] = _active[last];
+		_active.resize(last);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Vector2.h"
+#include <vector>
+
+// a body going back to the level it left less than this many frames ago
+// counts as a reversal
+#define LOD_REVERSAL_FRAMES 10
+
+struct LodLevel {
+	// bodies within this distance of a point of interest
+	float radius;
+	// stepped once every this many frames
+	int interval;
+	// coarse bodies do not collide with each other, only with finer bodies and walls
+	bool coarse;
+};
+
+// Used by the plain integrator and both contact paths; substepping and the
+// event-driven mode step every body at full rate
+struct LodSettings {
+	bool enabled = false;
+	// points of interest, empty follows the player
+	std::vector<Vector2> points;
+	// innermost first, a body beyond every radius takes the last level
+	std::vector<LodLevel> levels = { LodLevel{ 200, 1, false }, LodLevel{ 400, 2, false }, LodLevel{ 600, 4, true } };
+	// a body only drops to a coarser level once it is this fraction past the radius
+	float hysteresis = 0.1f;
+};
+
+struct LodStats {
+	// bodies on each level this frame
+	std::vector<int> bodies;
+	int stepped = 0;
+	int skippedSteps = 0;
+	// of all n(n-1)/2 pairs, the ones never visited
+	long long skippedPairs = 0;
+	// bodies that moved to another level this frame, and the reversals among them
+	int changes = 0;
+	int reversals = 0;
+	double getFraction(int level) const;
+};
+
+// Places bodies on levels of detail by their distance to the nearest point of
+// interest. Bodies on a level with interval k step on one frame in k, staggered
+// by index so the saved work is spread evenly over frames. Moving to a finer
+// level happens at once, moving to a coarser one only past the hysteresis band,
+// so a body near a ring edge does not flip back and forth.
+class LodSystem {
+public:
+	LodSettings& getSettings();
+	const LodSettings& getSettings() const;
+	LodStats& getStats();
+	const LodStats& getStats() const;
+	// movable is 0 for static bodies, pinned bodies always take the finest level
+	void assign(const std::vector<Vector2>& positions, const std::vector<char>& movable,
+		const std::vector<Vector2>& points, int pinned);
+	bool isActive(int body) const;
+	bool isCoarse(int body) const;
+	int getLevel(int body) const;
+	// Body last moves into the freed index, as in the model
+	void removeBody(int body, int last);
+private:
+	int levelFor(float distance, int current) const;
+
+	LodSettings _settings;
+	LodStats _stats;
+	std::vector<int> _levels;
+	// the level each body was on before its last change, and the frame of it
+	std::vector<int> _previousLevels;
+	std::vector<long long> _changedAt;
+	std::vector<char> _active;
+	long long _frame = 0;
+};
@@ -1,12 +1,16 @@
 #include "Model.h"
+#include <algorithm>
 #include <iostream>
 
-Model::Model(int width, int height) {
+template <typename Physics>
+BasicModel<Physics>::BasicModel(int width, int height, Physics physics) {
 	_width = width;
 	_height = height;
+	_physics = physics;
 }
 
-bool Model::resolveOutOfBoundsCollision(Collider& c) {
+template <typename Physics>
+bool BasicModel<Physics>::resolveOutOfBoundsCollision(Collider& c) {
 	bool val = false;
 	if ((c.getPos().X - c.getWidth()/2) < 0 && c.getVelocity().X < 0) {
 		Vector2 posNew;
@@ -16,7 +20,7 @@ bool Model::resolveOutOfBoundsCollision(Collider& c) {
 
 		Vector2 copy = c.getVelocity();
 		copy.X *= -1;
-		c.setVelocity(copy);
+		setVelocity(c, copy);
 		val = true;
 	}
 	else if ((c.getPos().X + c.getWidth()/2) > _width && c.getVelocity().X > 0) {
@@ -27,7 +31,7 @@ bool Model::resolveOutOfBoundsCollision(Collider& c) {
 
 		Vector2 copy = c.getVelocity();
 		copy.X *= -1;
-		c.setVelocity(copy);
+		setVelocity(c, copy);
 		val = true;
 	}
 
@@ -40,7 +44,7 @@ bool Model::resolveOutOfBoundsCollision(Collider& c) {
 
 		Vector2 copy = c.getVelocity();
 		copy.Y *= -1;
-		c.setVelocity(copy);
+		setVelocity(c, copy);
 		val = true;
 	}
 	else if ((c.getPos().Y + c.getHeight()/2) > _height && c.getVelocity().Y > 0) {
@@ -51,78 +55,605 @@ bool Model::resolveOutOfBoundsCollision(Collider& c) {
 
 		Vector2 copy = c.getVelocity();
 		copy.Y *= -1;
-		c.setVelocity(copy);
+		setVelocity(c, copy);
 		val = true;
 	}
 	return val;
 };
 
-void Model::update(double time, Vector2 dir) {
-	for (int i = 0; i < _entities.size(); i++) {
-		for (int j = i + 1; j < _entities.size(); j++) {
-			if (checkCollision(*_entities.at(i)->getCollider(), *_entities.at(j)->getCollider())) {
-				_entities.at(i)->onCollide();
-				_entities.at(j)->onCollide();
-				Collider& c1 = *_entities.at(i)->getCollider();
-				Collider& c2 = *_entities.at(j)->getCollider();
-				resolveCollision(c1, c2);
+template <typename Physics>
+bool BasicModel<Physics>::resolveStaticCollision(Collider& c, Vector2 from) {
+	bool hit = resolveOutOfBoundsCollision(c);
+	if (_geometry.empty()) {
+		return hit;
+	}
+	Vector2 pos = c.getPos();
+	Vector2 vel = c.getVelocity();
+	if (_geometry.collide(from, pos, vel, c.getRadius())) {
+		c.setPosition(pos);
+		setVelocity(c, vel);
+		return true;
+	}
+	c.setPosition(pos);
+	return hit;
+}
+
+template <typename Physics>
+void BasicModel<Physics>::update(double time, Vector2 dir) {
+	update(time, dir, std::vector<DirectionChange>());
+}
+
+template <typename Physics>
+void BasicModel<Physics>::update(double time, Vector2 dir, const std::vector<DirectionChange>& changes) {
+	if (_physics.eventDriven) {
+		_pairStats = PairStats();
+		if (_steering.getSettings().enabled) {
+			steer(time);
+		}
+		if (_forceSettings.enabled) {
+			accumulateForces(time);
+		}
+		long long wallEvents = _events.getStats().wallEvents;
+		_events.advance(_bodies.getEntities(), time, (float)_width, (float)_height, _physics.restitution);
+		_pairStats.contacts = _events.getStats().frameEvents;
+		_pairStats.wallHits = (int)(_events.getStats().wallEvents - wallEvents);
+		playerControl(heldDirection(time, dir, changes)*_physics.playerSpeed);
+		updateGrid();
+		return;
+	}
+	beginFrame(time);
+	narrowPhase();
+	solve();
+	integrateFrame(time, dir, changes);
+	dispatchEvents();
+	broadphase();
+}
+
+template <typename Physics>
+void BasicModel<Physics>::beginFrame(double time) {
+	_pairStats = PairStats();
+	_contactPairs.clear();
+	if (_steering.getSettings().enabled) {
+		steer(time);
+	}
+	if (_lod.getSettings().enabled) {
+		assignLod();
+	}
+	if (_physics.warmStarting) {
+		_contacts.beginFrame();
+	}
+	if (_physics.substepping) {
+		classifySubsteps(time);
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::narrowPhase() {
+	if (_physics.iterativeSolver) {
+		findContacts();
+	}
+	else {
+		resolveCollisions();
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::solve() {
+	if (_physics.iterativeSolver) {
+		solveContacts();
+	}
+	if (_physics.warmStarting) {
+		_contacts.endFrame();
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::integrateFrame(double time, Vector2 dir) {
+	if (_forceSettings.enabled) {
+		accumulateForces(time);
+	}
+	if (_physics.substepping) {
+		integrateSubstepped(time);
+	}
+	else {
+		integrate(time);
+	}
+	playerControl(dir*_physics.playerSpeed);
+}
+
+template <typename Physics>
+void BasicModel<Physics>::integrateFrame(double time, Vector2 dir, const std::vector<DirectionChange>& changes) {
+	if (changes.empty() || _p == nullptr || time <= 0) {
+		integrateFrame(time, heldDirection(time, dir, changes));
+		return;
+	}
+	if (_forceSettings.enabled) {
+		accumulateForces(time);
+	}
+	_steppedApart = _p;
+	if (_physics.substepping) {
+		integrateSubstepped(time);
+	}
+	else {
+		integrate(time);
+	}
+	_steppedApart = nullptr;
+	integratePlayer(time, dir, changes);
+}
+
+template <typename Physics>
+void BasicModel<Physics>::integratePlayer(double time, Vector2 dir, const std::vector<DirectionChange>& changes) {
+	// a player the model does not hold only takes the control impulses
+	int index = -1;
+	for (int i = 0; i < _bodies.size() && index < 0; i++) {
+		index = _bodies.getEntity(i) == _p ? i : -1;
+	}
+	Collider& c = *_p->editCollider();
+	double from = 0;
+	for (int k = 0; k <= changes.size(); k++) {
+		double to = k < changes.size() ? std::min(std::max(changes[k].offset, from), time) : time;
+		if (to > from && index >= 0 && c.getBodyType() != BODY_STATIC) {
+			Vector2 before = c.getPos();
+			physicsStep(c, to - from);
+			if (resolveStaticCollision(c, before)) {
+				_gameplayEvents.push_back(GameplayEvent{ index, true });
+			}
+		}
+		playerControl(dir * (float)(_physics.playerSpeed * (to - from) / time));
+		if (k < changes.size()) {
+			dir = changes[k].direction;
+		}
+		from = to;
+	}
+}
+
+template <typename Physics>
+Vector2 BasicModel<Physics>::heldDirection(double time, Vector2 dir, const std::vector<DirectionChange>& changes) {
+	if (changes.empty() || time <= 0) {
+		return changes.empty() ? dir : changes.back().direction;
+	}
+	Vector2 held;
+	double from = 0;
+	for (const DirectionChange& c : changes) {
+		double to = std::min(std::max(c.offset, from), time);
+		held += dir * (float)((to - from) / time);
+		dir = c.direction;
+		from = to;
+	}
+	held += dir * (float)((time - from) / time);
+	return held;
+}
+
+template <typename Physics>
+void BasicModel<Physics>::dispatchEvents() {
+	for (const GameplayEvent& e : _gameplayEvents) {
+		if (e.wall) {
+			_pairStats.wallHits++;
+			_bodies.getEntity(e.entity)->onCollideWall();
+		}
+		else {
+			_bodies.getEntity(e.entity)->onCollide();
+		}
+	}
+	_gameplayEvents.clear();
+}
+
+template <typename Physics>
+void BasicModel<Physics>::broadphase() {
+	updateGrid();
+}
+
+template <typename Physics>
+void BasicModel<Physics>::integrate(double time) {
+	bool lod = _lod.getSettings().enabled;
+	if (lod) {
+		_lodPending.resize(_bodies.size(), 0);
+	}
+	for (int i = 0; i < _bodies.size(); i++) {
+		if (_bodies.get(i).getBodyType() == BODY_STATIC || _bodies.getEntity(i) == _steppedApart) {
+			continue;
+		}
+		double step = time;
+		int steps = 1;
+		if (lod) {
+			// a body off its frame banks the time and catches up on the next
+			// one it steps, a frame's worth at a time so walls, geometry and
+			// friction see the same steps as at full rate
+			_lodPending[i] += time;
+			if (!_lod.isActive(i)) {
+				continue;
+			}
+			steps = std::max(1, (int)std::lround(_lodPending[i] / time));
+			step = _lodPending[i] / steps;
+			_lodPending[i] = 0;
+		}
+		Collider& c = _bodies.edit(i);
+		for (int s = 0; s < steps; s++) {
+			Vector2 before = c.getPos();
+			physicsStep(c, step);
+			if (resolveStaticCollision(c, before)) {
+				_gameplayEvents.push_back(GameplayEvent{ i, true });
+			}
+		}
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::classifySubsteps(double time) {
+	int bins = 1;
+	while ((1 << (bins - 1)) < _physics.maxSubsteps) {
+		bins++;
+	}
+	_substepStats.histogram.assign(bins, 0);
+	_substepStats.fastBodies = 0;
+	_substepStats.contacts = 0;
+
+	// bodies that would move further than a fraction of their radius get a
+	// power of two number of substeps, everything else takes the base step
+	_fast.clear();
+	_substeps.assign(_bodies.size(), 1);
+	_maxDisplacement = 0;
+	for (int i = 0; i < _bodies.size(); i++) {
+		const Collider& c = _bodies.get(i);
+		if (c.getBodyType() == BODY_STATIC) {
+			continue;
+		}
+		float displacement = getLength(c.getVelocity()) * (float)time;
+		_maxDisplacement = std::max(_maxDisplacement, displacement);
+		float limit = _physics.substepFraction * c.getHeight() / 2;
+		int bin = 0;
+		while ((1 << bin) < _physics.maxSubsteps && displacement > limit * (1 << bin)) {
+			bin++;
+		}
+		_substepStats.histogram[bin]++;
+		if (bin > 0) {
+			_substeps[i] = 1 << bin;
+			_fast.push_back(i);
+		}
+	}
+	_substepStats.fastBodies = (int)_fast.size();
+}
+
+template <typename Physics>
+void BasicModel<Physics>::integrateSubstepped(double time) {
+	// everything a fast body can reach this frame, found once per body; the
+	// slow bodies among them step with the fast ones so every test sees both
+	// at the same time
+	_fastCandidates.clear();
+	_clocked.clear();
+	_isClocked.assign(_bodies.size(), 0);
+	for (int i : _fast) {
+		const Collider& c = _bodies.get(i);
+		float reach = c.getHeight() + getLength(c.getVelocity()) * (float)time + _maxDisplacement;
+		size_t first = _fastCandidates.indices.size();
+		_grid.queryCircle(c.getPos(), reach, _fastCandidates.indices);
+		_fastCandidates.offsets.push_back((int)_fastCandidates.indices.size());
+		for (size_t k = first; k < _fastCandidates.indices.size(); k++) {
+			int j = _fastCandidates.indices[k];
+			if (_substeps[j] == 1 && !_isClocked[j] && _bodies.get(j).getBodyType() != BODY_STATIC) {
+				_isClocked[j] = 1;
+				_clocked.push_back(j);
 			}
 		}
 	}
 
-	for (Entity* e : _entities) {
-		Collider& c = *e->getCollider();
+	// the rest of the slow bodies take the base step
+	for (int i = 0; i < _bodies.size(); i++) {
+		if (_substeps[i] > 1 || _isClocked[i] || _bodies.get(i).getBodyType() == BODY_STATIC || _bodies.getEntity(i) == _steppedApart) {
+			continue;
+		}
+		Collider& c = _bodies.edit(i);
+		Vector2 before = c.getPos();
 		physicsStep(c, time);
-		if (resolveOutOfBoundsCollision(c)) {
-			e->onCollideWall();
+		if (resolveStaticCollision(c, before)) {
+			_gameplayEvents.push_back(GameplayEvent{ i, true });
+		}
+	}
+	if (_fast.empty()) {
+		return;
+	}
+
+	// step all fast bodies on the finest grid, a body with fewer substeps
+	// only advances every stride substeps
+	int finest = 1;
+	for (int i : _fast) {
+		finest = std::max(finest, _substeps[i]);
+	}
+	for (int s = 0; s < finest; s++) {
+		for (int f = 0; f < _fast.size(); f++) {
+			int i = _fast[f];
+			if (s % (finest / _substeps[i]) != 0 || _bodies.getEntity(i) == _steppedApart) {
+				continue;
+			}
+			Collider& c = _bodies.edit(i);
+			Vector2 before = c.getPos();
+			physicsStep(c, time / _substeps[i]);
+			if (resolveStaticCollision(c, before)) {
+				_gameplayEvents.push_back(GameplayEvent{ i, true });
+			}
+		}
+		for (int i : _clocked) {
+			if (_bodies.getEntity(i) == _steppedApart) {
+				continue;
+			}
+			Collider& c = _bodies.edit(i);
+			Vector2 before = c.getPos();
+			physicsStep(c, time / finest);
+			if (resolveStaticCollision(c, before)) {
+				_gameplayEvents.push_back(GameplayEvent{ i, true });
+			}
+		}
+		for (int f = 0; f < _fast.size(); f++) {
+			int i = _fast[f];
+			if (s % (finest / _substeps[i]) != 0) {
+				continue;
+			}
+			Collider& c1 = _bodies.edit(i);
+			for (const int* it = _fastCandidates.begin(f); it != _fastCandidates.end(f); it++) {
+				int j = *it;
+				if (j == i) {
+					continue;
+				}
+				// a pair of fast bodies that both moved is handled from the lower index
+				if (j < i && _substeps[j] > 1 && s % (finest / _substeps[j]) == 0) {
+					continue;
+				}
+				if (testPair(c1, _bodies.get(j))) {
+					Collider& c2 = _bodies.edit(j);
+					_gameplayEvents.push_back(GameplayEvent{ i, false });
+					_gameplayEvents.push_back(GameplayEvent{ j, false });
+					_contactPairs.push_back(std::make_pair(std::min(i, j), std::max(i, j)));
+					resolveCollision(c1, c2);
+					_substepStats.contacts++;
+				}
+			}
 		}
 	}
-	playerControl(dir*PLAYER_SPEED);
 }
 
-void Model::playerControl(const Vector2 v) {
-	_p->getCollider()->addVel(v);
+template <typename Physics>
+template <typename Visit>
+void BasicModel<Physics>::forEachPair(Visit visit) {
+	// integrateSubstepped() tests the fast bodies against everything they reach
+	bool skipFast = _physics.substepping && !_fast.empty();
+	if (_lod.getSettings().enabled) {
+		visitLodPairs(visit, skipFast);
+		return;
+	}
+	for (int i = 0; i < _bodies.size(); i++) {
+		if (skipFast && _substeps[i] > 1) {
+			continue;
+		}
+		for (int j = i + 1; j < _bodies.size(); j++) {
+			if (!skipFast || _substeps[j] == 1) {
+				visit(i, j);
+			}
+		}
+	}
 }
 
-void Model::resolveCollision(Collider& c1, Collider& c2)
+template <typename Physics>
+template <typename Visit>
+void BasicModel<Physics>::visitLodPairs(Visit visit, bool skipFast) {
+	// neither body moved since the pair was last tested, or both are too far
+	// out to matter: such pairs are never visited at all. The rest are taken
+	// in the all-pairs order, one body at a time with the grid following every
+	// push apart, so a body moved by an earlier pair is found where the
+	// all-pairs loop finds it
+	long long visited = 0;
+	int n = (int)_bodies.size();
+	_lodRows.assign(n, 0);
+	for (int i = 0; i < n; i++) {
+		if (_lod.isActive(i)) {
+			markLodRows(i);
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		if (!_lod.isActive(i) && !_lodRows[i]) {
+			continue;
+		}
+		// candidates up to done were visited before body i last moved
+		int done = i;
+		bool moved = true;
+		while (moved) {
+			moved = false;
+			const Collider& c = _bodies.get(i);
+			_lodCandidates.clear();
+			_grid.queryCircle(c.getPos(), c.getHeight() / 2, _lodCandidates);
+			std::sort(_lodCandidates.begin(), _lodCandidates.end());
+			for (int j : _lodCandidates) {
+				if (j <= done || (!_lod.isActive(i) && !_lod.isActive(j)) || (_lod.isCoarse(i) && _lod.isCoarse(j))) {
+					continue;
+				}
+				done = j;
+				visited++;
+				if (skipFast && (_substeps[i] > 1 || _substeps[j] > 1)) {
+					continue;
+				}
+				Vector2 before = _bodies.get(i).getPos();
+				Vector2 beforeOther = _bodies.get(j).getPos();
+				visit(i, j);
+				followGrid(j, beforeOther);
+				if (followGrid(i, before)) {
+					moved = true;
+					break;
+				}
+			}
+		}
+	}
+	_lod.getStats().skippedPairs = (long long)n * (n - 1) / 2 - visited;
+}
+
+template <typename Physics>
+void BasicModel<Physics>::markLodRows(int index) {
+	// a body off its frame only has pairs left in its own row while an active
+	// body further on touches it, or once a pair has pushed it
+	if (!_lod.isActive(index)) {
+		_lodRows[index] = 1;
+		return;
+	}
+	const Collider& c = _bodies.get(index);
+	_lodNeighbours.clear();
+	_grid.queryCircle(c.getPos(), c.getHeight() / 2, _lodNeighbours);
+	for (int k : _lodNeighbours) {
+		if (k < index && !_lod.isActive(k)) {
+			_lodRows[k] = 1;
+		}
+	}
+}
+
+template <typename Physics>
+bool BasicModel<Physics>::followGrid(int index, Vector2 before) {
+	const Collider& c = _bodies.get(index);
+	if (c.getPos().X == before.X && c.getPos().Y == before.Y) {
+		return false;
+	}
+	_grid.move(index, c.getPos(), c.getHeight() / 2);
+	markLodRows(index);
+	return true;
+}
+
+template <typename Physics>
+void BasicModel<Physics>::resolveCollisions() {
+	forEachPair([this](int i, int j) {
+		if (testPair(_bodies.get(i), _bodies.get(j))) {
+			Collider& c1 = _bodies.edit(i);
+			Collider& c2 = _bodies.edit(j);
+			_gameplayEvents.push_back(GameplayEvent{ i, false });
+			_gameplayEvents.push_back(GameplayEvent{ j, false });
+			_contactPairs.push_back(std::make_pair(i, j));
+			if (_physics.warmStarting) {
+				resolveCollision(c1, c2, _contacts.touch(_bodies.getEntity(i)->getId(), _bodies.getEntity(j)->getId()).normalImpulse);
+			}
+			else {
+				resolveCollision(c1, c2);
+			}
+		}
+	});
+}
+
+template <typename Physics>
+void BasicModel<Physics>::findContacts() {
+	_solver.clear();
+	_warmImpulses.clear();
+	forEachPair([this](int i, int j) {
+		if (testPair(_bodies.get(i), _bodies.get(j))) {
+			Collider& c1 = _bodies.edit(i);
+			Collider& c2 = _bodies.edit(j);
+			_gameplayEvents.push_back(GameplayEvent{ i, false });
+			_gameplayEvents.push_back(GameplayEvent{ j, false });
+			_contactPairs.push_back(std::make_pair(i, j));
+			Contact& contact = _solver.addContact(c1, c2, _physics.restitution);
+			if (_physics.warmStarting) {
+				float& cached = _contacts.touch(_bodies.getEntity(i)->getId(), _bodies.getEntity(j)->getId()).normalImpulse;
+				contact.impulse = cached * _physics.warmStartFactor;
+				_warmImpulses.push_back(&cached);
+			}
+		}
+	});
+}
+
+template <typename Physics>
+void BasicModel<Physics>::solveContacts() {
+	_solver.solve(_physics.solverIterations, _physics.solverTolerance);
+
+	std::vector<Contact>& contacts = _solver.getContacts();
+	for (int i = 0; i < contacts.size(); i++) {
+		if (_physics.warmStarting) {
+			*_warmImpulses[i] = contacts[i].impulse;
+		}
+		// the solver works on raw velocities, apply the speed cap once at the end
+		setVelocity(*contacts[i].a, contacts[i].a->getVelocity());
+		setVelocity(*contacts[i].b, contacts[i].b->getVelocity());
+	}
+}
+
+template <typename Physics>
+bool BasicModel<Physics>::testPair(const Collider& c1, const Collider& c2) {
+	_pairStats.candidates++;
+	// layer, mask and body type filtering before any narrow phase work
+	if (!c1.canCollideWith(c2)) {
+		_pairStats.filtered++;
+		return false;
+	}
+	_pairStats.tested++;
+	if (!checkCollision(c1, c2)) {
+		return false;
+	}
+	_pairStats.contacts++;
+	return true;
+}
+
+template <typename Physics>
+void BasicModel<Physics>::playerControl(const Vector2 v) {
+	if (_p != nullptr) {
+		_p->editCollider()->addVel(v);
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::resolveCollision(Collider& c1, Collider& c2)
+{
+	float accumulated = 0;
+	resolveCollision(c1, c2, accumulated);
+}
+
+template <typename Physics>
+void BasicModel<Physics>::resolveCollision(Collider& c1, Collider& c2, float& accumulated)
 {
 	// get the mtd
 	Vector2 delta = (c1.getPos() - c2.getPos());
 	float d = getLength(delta);
 	// minimum translation distance to push balls apart after intersecting
 	Vector2 mtd = delta * (((c1.getHeight()/2 + c2.getHeight()/2) - d) / d);
+	// concentric, or touching exactly after rounding: no direction to push along
+	if (d == 0.0f || (mtd.X == 0.0f && mtd.Y == 0.0f)) {
+		return;
+	}
 
 	// resolve intersection --
 	// inverse mass quantities
-	float im1 = 1 / c1.getMass();
-	float im2 = 1 / c2.getMass();
+	float im1 = c1.getInverseMass();
+	float im2 = c2.getInverseMass();
 
 	// push-pull them apart based off their mass
 	c1.addPos(mtd * (im1 / (im1 + im2)));
 	c2.addPos((mtd * (im2 / (im1 + im2))) * -1);
+	Vector2 normal = mtd / getLength(mtd);
+
+	// warm start from the impulse this pair ended the last frame with
+	float warm = accumulated * _physics.warmStartFactor;
+	if (warm > 0.0f) {
+		setVelocity(c1, c1.getVelocity() + (normal * (warm * im1)));
+		setVelocity(c2, c2.getVelocity() - (normal * (warm * im2)));
+	}
 
 	// impact speed
 	Vector2 v = c1.getVelocity() - c2.getVelocity();
 	float y = (c1.getVelocity().X * c2.getVelocity().Y) - (c2.getVelocity().X * c1.getVelocity().Y);
 	float x = (c1.getVelocity().X * c2.getVelocity().X) + (c2.getVelocity().Y * c1.getVelocity().Y);
 	float angle = atan2(y, x);
-	float vn = angle * getLength(v) * getLength((mtd / getLength(mtd)));
+	float vn = angle * getLength(v) * getLength(normal);
 
-	// sphere intersecting but moving away from each other already
-	if (vn > 0.0f) {
+	// collision impulse, clamped so the total over the frame never pulls the
+	// bodies together. Without a warm start this is the old early out for
+	// spheres intersecting but moving away from each other already
+	float i = (-(1.0f + _physics.restitution) * vn) / (im1 + im2);
+	i = std::max(i, -warm);
+	accumulated = warm + i;
+	if (i == 0.0f) {
 		return;
 	}
-	// collision impulse
-	float i = (-(1.0f + RESTITUTION) * vn) / (im1 + im2);
-	Vector2 impulse = mtd / getLength(mtd) * i;
+	Vector2 impulse = normal * i;
 
 	// change in momentum
-	c1.setVelocity(c1.getVelocity() + (impulse * im1));
-	c2.setVelocity(c2.getVelocity() - (impulse * im2));
+	setVelocity(c1, c1.getVelocity() + (impulse * im1));
+	setVelocity(c2, c2.getVelocity() - (impulse * im2));
 
 }
 
-bool Model::checkCollision(Collider c1, Collider c2) {
+template <typename Physics>
+bool BasicModel<Physics>::checkCollision(const Collider& c1, const Collider& c2) {
 	if (c1.getType() == 0 && c2.getType() == 0) {
 		return checkCircleCollision(c1.getPos(), c1.getHeight()/2, c2.getPos(), c2.getHeight()/2);
 	}
@@ -132,39 +663,318 @@ bool Model::checkCollision(Collider c1, Collider c2) {
 	}
 }
 
-bool Model::checkCircleCollision(Vector2 c1pos, float c1rad, Vector2 c2pos, float c2rad) {
+template <typename Physics>
+bool BasicModel<Physics>::checkCircleCollision(Vector2 c1pos, float c1rad, Vector2 c2pos, float c2rad) {
 	return ((c1pos.X - c2pos.X) * (c1pos.X - c2pos.X) + (c1pos.Y - c2pos.Y) * (c1pos.Y - c2pos.Y)) < (c1rad + c2rad) * (c1rad + c2rad);
 }
 
-void Model::physicsStep(Collider& c, double time){
-	if (FRICTION_ENABLED) {
-		Vector2 F = c.getVelocity() * -FRICTION_COEFFICIENT;
+template <typename Physics>
+void BasicModel<Physics>::physicsStep(Collider& c, double time){
+	if (_physics.frictionEnabled && c.getBodyType() == BODY_DYNAMIC) {
+		Vector2 F = c.getVelocity() * -_physics.frictionCoefficient;
 		Vector2 a = F / c.getMass();
 		c.addVel(a * time);
 	}
 	c.addPos(c.getVelocity() * time);
 }
 
-void Model::addEntity(Entity* c) {
-	_entities.push_back(c);
+template <typename Physics>
+void BasicModel<Physics>::addEntity(Entity* c) {
+	int index = _bodies.add(c);
+	const Collider& collider = _bodies.get(index);
+	_grid.insert(index, collider.getPos(), collider.getHeight() / 2);
 }
 
-int Model::getHeight() {
+template <typename Physics>
+void BasicModel<Physics>::assignLod() {
+	int n = (int)_bodies.size();
+	_positions.resize(n);
+	_movable.resize(n);
+	int pinned = -1;
+	for (int i = 0; i < n; i++) {
+		const Collider& c = _bodies.get(i);
+		_positions[i] = c.getPos();
+		_movable[i] = c.getBodyType() != BODY_STATIC;
+		if (_bodies.getEntity(i) == _p) {
+			pinned = i;
+		}
+	}
+	_lodPoints = _lod.getSettings().points;
+	if (_lodPoints.empty()) {
+		_lodPoints.push_back(_p != nullptr ? _p->getCollider()->getPos() : Vector2{ _width / 2.0f, _height / 2.0f });
+	}
+	_lod.assign(_positions, _movable, _lodPoints, pinned);
+}
+
+template <typename Physics>
+void BasicModel<Physics>::setGeometry(StaticGeometry geometry) {
+	_geometry = std::move(geometry);
+}
+
+template <typename Physics>
+const StaticGeometry& BasicModel<Physics>::getGeometry() const {
+	return _geometry;
+}
+
+template <typename Physics>
+LodSettings& BasicModel<Physics>::getLodSettings() {
+	return _lod.getSettings();
+}
+
+template <typename Physics>
+const LodStats& BasicModel<Physics>::getLodStats() const {
+	return _lod.getStats();
+}
+
+template <typename Physics>
+Vector2 BasicModel<Physics>::getDisplayPosition(int index) const {
+	const Collider& c = _bodies.get(index);
+	if (!_lod.getSettings().enabled || index >= (int)_lodPending.size()) {
+		return c.getPos();
+	}
+	return c.getPos() + c.getVelocity() * (float)_lodPending[index];
+}
+
+template <typename Physics>
+void BasicModel<Physics>::removeEntity(int index) {
+	int last = (int)_bodies.size() - 1;
+	if (_bodies.getEntity(index) == _p) {
+		_p = nullptr;
+	}
+	_grid.remove(index);
+	_contacts.remove(_bodies.getEntity(index)->getId());
+	// the last entity takes over the slot
+	_bodies.remove(index);
+	if (index != last) {
+		_grid.remove(last);
+		const Collider& c = _bodies.get(index);
+		_grid.insert(index, c.getPos(), c.getHeight() / 2);
+		if (last < _lodPending.size()) {
+			_lodPending[index] = _lodPending[last];
+		}
+	}
+	_lod.removeBody(index, last);
+	if (_lodPending.size() > _bodies.size()) {
+		_lodPending.resize(_bodies.size());
+	}
+	_events.removeBody(index, last);
+}
+
+template <typename Physics>
+void BasicModel<Physics>::resync() {
+	updateGrid();
+	_contacts.clear();
+	_events.reset();
+}
+
+template <typename Physics>
+void BasicModel<Physics>::updateGrid() {
+	for (int i = 0; i < _bodies.size(); i++) {
+		const Collider& c = _bodies.get(i);
+		if (c.getBodyType() != BODY_STATIC) {
+			_grid.move(i, c.getPos(), c.getHeight() / 2);
+		}
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::steer(double time) {
+	const SteeringSettings& settings = _steering.getSettings();
+	int n = (int)_bodies.size();
+	_positions.resize(n);
+	_velocities.resize(n);
+	_isAgent.resize(n);
+	_agents.clear();
+	for (int i = 0; i < n; i++) {
+		const Collider& c = _bodies.get(i);
+		_positions[i] = c.getPos();
+		_velocities[i] = c.getVelocity();
+		_isAgent[i] = (c.getLayer() & settings.layers) != 0 && c.getBodyType() == BODY_DYNAMIC;
+		if (_isAgent[i]) {
+			_agents.push_back(i);
+		}
+	}
+	Vector2 target = _p != nullptr ? _p->getCollider()->getPos() : Vector2{ _width / 2.0f, _height / 2.0f };
+	_steering.compute(_agents, _isAgent, _positions, _velocities, _grid, target, _accelerations, _pool);
+	for (int a = 0; a < _agents.size(); a++) {
+		_bodies.edit(_agents[a]).addVel(_accelerations[a] * time);
+	}
+}
+
+template <typename Physics>
+SteeringSystem& BasicModel<Physics>::getSteering() {
+	return _steering;
+}
+
+template <typename Physics>
+void BasicModel<Physics>::accumulateForces(double time) {
+	// every body is a source, only dynamic bodies are pushed around
+	int n = (int)_bodies.size();
+	_positions.resize(n);
+	_masses.resize(n);
+	_charges.resize(n);
+	for (int i = 0; i < n; i++) {
+		const Collider& c = _bodies.get(i);
+		_positions[i] = c.getPos();
+		_masses[i] = c.getMass();
+		_charges[i] = c.getCharge();
+	}
+	_forceTree.build(_positions, _masses, _charges, _pool);
+	_forceTree.computeForces(_forceSettings, _forces, _pool);
+	for (int i = 0; i < n; i++) {
+		if (_bodies.get(i).getBodyType() == BODY_DYNAMIC) {
+			Collider& c = _bodies.edit(i);
+			c.addVel(_forces[i] * (c.getInverseMass() * (float)time));
+		}
+	}
+}
+
+template <typename Physics>
+const EventStats& BasicModel<Physics>::getEventStats() const {
+	return _events.getStats();
+}
+
+template <typename Physics>
+ForceSettings& BasicModel<Physics>::getForceSettings() {
+	return _forceSettings;
+}
+
+template <typename Physics>
+const ForceStats& BasicModel<Physics>::getForceStats() const {
+	return _forceTree.getStats();
+}
+
+template <typename Physics>
+void BasicModel<Physics>::setThreadPool(ThreadPool* pool) {
+	_pool = pool;
+}
+
+template <typename Physics>
+void BasicModel<Physics>::queryCircles(const std::vector<CircleQuery>& queries, QueryResults& results) const {
+	results.clear();
+	for (const CircleQuery& q : queries) {
+		_grid.queryCircle(q.center, q.radius, results.indices);
+		results.offsets.push_back((int)results.indices.size());
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::queryAabbs(const std::vector<AabbQuery>& queries, QueryResults& results) const {
+	results.clear();
+	for (const AabbQuery& q : queries) {
+		_grid.queryAabb(q.min, q.max, results.indices);
+		results.offsets.push_back((int)results.indices.size());
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::queryNearest(const std::vector<Vector2>& points, int k, QueryResults& results) const {
+	results.clear();
+	for (const Vector2& p : points) {
+		_grid.queryNearest(p, k, results.indices);
+		results.offsets.push_back((int)results.indices.size());
+	}
+}
+
+template <typename Physics>
+void BasicModel<Physics>::raycast(const std::vector<Ray>& rays, std::vector<RayHit>& hits) const {
+	hits.resize(rays.size());
+	for (int i = 0; i < rays.size(); i++) {
+		_grid.raycast(rays[i], hits[i]);
+	}
+}
+
+template <typename Physics>
+const SpatialGrid& BasicModel<Physics>::getGrid() const {
+	return _grid;
+}
+
+template <typename Physics>
+int BasicModel<Physics>::getHeight() {
 	return _height;
 }
 
-int Model::getWidth() {
+template <typename Physics>
+int BasicModel<Physics>::getWidth() {
 	return _width;
 }
 
-const Player* Model::getPlayer() const {
+template <typename Physics>
+const Player* BasicModel<Physics>::getPlayer() const {
 	return _p;
 }
 
-void Model::setPlayer(Player* p) {
+template <typename Physics>
+void BasicModel<Physics>::setPlayer(Player* p) {
 	_p = p;
 }
 
-std::vector<Entity*> Model::getEntities() {
-	return _entities;
-}
\ No newline at end of file
+template <typename Physics>
+std::vector<Entity*> BasicModel<Physics>::getEntities() {
+	return _bodies.getEntities();
+}
+
+template <typename Physics>
+int BasicModel<Physics>::getEntityCount() const {
+	return (int)_bodies.size();
+}
+
+template <typename Physics>
+Entity* BasicModel<Physics>::getEntity(int index) const {
+	return _bodies.getEntity(index);
+}
+
+template <typename Physics>
+BodyStore& BasicModel<Physics>::getBodyStore() {
+	return _bodies;
+}
+
+template <typename Physics>
+Physics& BasicModel<Physics>::getPhysics() {
+	return _physics;
+}
+
+template <typename Physics>
+const Physics& BasicModel<Physics>::getPhysics() const {
+	return _physics;
+}
+
+template <typename Physics>
+ContactCache& BasicModel<Physics>::getContactCache() {
+	return _contacts;
+}
+
+template <typename Physics>
+const PairStats& BasicModel<Physics>::getPairStats() const {
+	return _pairStats;
+}
+
+template <typename Physics>
+const std::vector<std::pair<int, int>>& BasicModel<Physics>::getContactPairs() const {
+	return _contactPairs;
+}
+
+template <typename Physics>
+const SubstepStats& BasicModel<Physics>::getSubstepStats() const {
+	return _substepStats;
+}
+
+template <typename Physics>
+const SolverStats& BasicModel<Physics>::getSolverStats() const {
+	return _solver.getStats();
+}
+
+template <typename Physics>
+void BasicModel<Physics>::setVelocity(Collider& c, const Vector2& vel) {
+	c.setVelocity(vel);
+	if (_physics.speedCapEnabled) {
+		float length = getLength(vel);
+		if (length >= _physics.maxSpeed) {
+			c.setVelocity(vel * (_physics.maxSpeed / length));
+		}
+	}
+}
+
+template class BasicModel<DefaultPhysics>;
+template class BasicModel<ElasticPhysics>;
+template class BasicModel<RuntimePhysics>;
\ No newline at end of file
@@ -1,30 +1,192 @@
 #pragma once
 #include "Entity.h"
+#include "BodyStore.h"
 #include <vector>
 #include "Player.h"
-#define RESTITUTION 1.0f
-#define FRICTION_ENABLED true
-#define FRICTION_COEFFICIENT 0.8f
-#define PLAYER_SPEED 2
-class Model {
+#include "Physics.h"
+#include "ContactCache.h"
+#include "ContactSolver.h"
+#include "SpatialGrid.h"
+#include "Steering.h"
+#include "BarnesHut.h"
+#include "EventEngine.h"
+#include "InputQueue.h"
+#include "Lod.h"
+#include "StaticGeometry.h"
+#include "ThreadPool.h"
+
+// Per-frame broad phase counters. Filtered pairs are rejected by layer, mask or
+// body type before any narrow phase work.
+struct PairStats {
+	int candidates = 0;
+	int filtered = 0;
+	int tested = 0;
+	int contacts = 0;
+	// bodies that hit the edge of the world
+	int wallHits = 0;
+};
+
+// Per-frame multirate integration counters. histogram[b] is the number of
+// bodies that took 2^b substeps, bin 0 being the base rate.
+struct SubstepStats {
+	std::vector<int> histogram;
+	int fastBodies = 0;
+	int contacts = 0;
+};
+
+template <typename Physics>
+class BasicModel {
 public:
-	Model(int width, int height);
+	BasicModel(int width, int height, Physics physics = Physics());
 	bool resolveOutOfBoundsCollision(Collider& c);
 	void update(double time, Vector2 dir);
+	// dir is held from the start of the step and each change takes over at
+	// its offset. The player is stepped in pieces split at the offsets, and
+	// each piece's direction adds its share of the step's control impulse at
+	// the end of the piece
+	void update(double time, Vector2 dir, const std::vector<DirectionChange>& changes);
+	// The phases update() runs in this order, for callers that schedule the
+	// frame themselves. The legacy resolver handles contacts as it finds them,
+	// so solve() only has work with the iterative solver. Collision callbacks
+	// are queued and run by dispatchEvents()
+	void beginFrame(double time);
+	void narrowPhase();
+	void solve();
+	void integrateFrame(double time, Vector2 dir);
+	void integrateFrame(double time, Vector2 dir, const std::vector<DirectionChange>& changes);
+	void dispatchEvents();
+	void broadphase();
 	void resolveCollision(Collider& c1, Collider& c2);
-	bool checkCollision(Collider c1, Collider c2);
+	void resolveCollision(Collider& c1, Collider& c2, float& accumulated);
+	bool checkCollision(const Collider& c1, const Collider& c2);
 	bool checkCircleCollision(Vector2 c1pos, float c1rad, Vector2 c2pos, float c2rad);
 	void physicsStep(Collider& c, double time);
 	void playerControl(const Vector2 v);
+	// Sets the velocity through the speed cap
+	void setVelocity(Collider& c, const Vector2& vel);
+	static Vector2 heldDirection(double time, Vector2 dir, const std::vector<DirectionChange>& changes);
 	void addEntity(Entity* c);
+	// The last entity moves into the freed index. The entity is not deleted
+	void removeEntity(int index);
+	// Call after body state was written back from outside (a rewind): moves
+	// the grid to the bodies and drops warm-start impulses and event predictions
+	void resync();
 	int getHeight();
 	int getWidth();
 	const Player* getPlayer() const;
 	void setPlayer(Player* p);
 	std::vector<Entity*> getEntities();
+	int getEntityCount() const;
+	Entity* getEntity(int index) const;
+	// The colliders by entity index, and their write log
+	BodyStore& getBodyStore();
+	Physics& getPhysics();
+	const Physics& getPhysics() const;
+	ContactCache& getContactCache();
+	const PairStats& getPairStats() const;
+	// The pairs found touching by the last time-stepped update(), lower index
+	// first, in the order they were resolved
+	const std::vector<std::pair<int, int>>& getContactPairs() const;
+	const SolverStats& getSolverStats() const;
+	const SubstepStats& getSubstepStats() const;
+	const EventStats& getEventStats() const;
+	// Batched spatial queries, results are entity indices
+	void queryCircles(const std::vector<CircleQuery>& queries, QueryResults& results) const;
+	void queryAabbs(const std::vector<AabbQuery>& queries, QueryResults& results) const;
+	void queryNearest(const std::vector<Vector2>& points, int k, QueryResults& results) const;
+	void raycast(const std::vector<Ray>& rays, std::vector<RayHit>& hits) const;
+	const SpatialGrid& getGrid() const;
+	SteeringSystem& getSteering();
+	ForceSettings& getForceSettings();
+	const ForceStats& getForceStats() const;
+	// Level geometry bodies bounce off like the walls, with onCollideWall. The
+	// event-driven mode only sees the walls
+	void setGeometry(StaticGeometry geometry);
+	const StaticGeometry& getGeometry() const;
+	LodSettings& getLodSettings();
+	const LodStats& getLodStats() const;
+	// Where to draw a body, a body on a reduced rate is carried forward by the
+	// time it has banked so it moves smoothly between its steps
+	Vector2 getDisplayPosition(int index) const;
+	// Pool for data-parallel passes, runs them serially when null
+	void setThreadPool(ThreadPool* pool);
 private:
+	bool testPair(const Collider& c1, const Collider& c2);
+	// walls and level geometry, true if the body bounced off either. from is
+	// where the body was before the step, the geometry tests the path from there
+	bool resolveStaticCollision(Collider& c, Vector2 from);
+	void resolveCollisions();
+	void updateGrid();
+	void integrate(double time);
+	// Picks the fast bodies for the frame before the contact passes, which
+	// leave their pairs to integrateSubstepped()
+	void classifySubsteps(double time);
+	void integrateSubstepped(double time);
+	void steer(double time);
+	void accumulateForces(double time);
+	void findContacts();
+	void solveContacts();
+	void assignLod();
+	// Calls visit(i, j) with i < j for every pair the contact passes look at:
+	// all of them, or with LOD only those with an active body that are not
+	// both coarse, taken from the grid. Pairs with a substepped body are left
+	// out
+	template <typename Visit>
+	void forEachPair(Visit visit);
+	template <typename Visit>
+	void visitLodPairs(Visit visit, bool skipFast);
+	void markLodRows(int index);
+	bool followGrid(int index, Vector2 before);
+	void integratePlayer(double time, Vector2 dir, const std::vector<DirectionChange>& changes);
 	int _width;
 	int _height;
-	std::vector<Entity*> _entities;
-	Player* _p;
-};
\ No newline at end of file
+	BodyStore _bodies;
+	Player* _p = nullptr;
+	// the player while integratePlayer() steps it apart from the other bodies
+	Entity* _steppedApart = nullptr;
+	Physics _physics;
+	ContactCache _contacts;
+	ContactSolver _solver;
+	std::vector<float*> _warmImpulses;
+	PairStats _pairStats;
+	std::vector<std::pair<int, int>> _contactPairs;
+	SpatialGrid _grid;
+	SteeringSystem _steering;
+	ThreadPool* _pool = nullptr;
+	std::vector<int> _agents;
+	std::vector<char> _isAgent;
+	std::vector<Vector2> _positions;
+	std::vector<Vector2> _velocities;
+	std::vector<Vector2> _accelerations;
+	SubstepStats _substepStats;
+	std::vector<int> _substeps;
+	std::vector<int> _fast;
+	float _maxDisplacement = 0;
+	QueryResults _fastCandidates;
+	// slow bodies a fast body can reach, stepped on the substep clock
+	std::vector<int> _clocked;
+	std::vector<char> _isClocked;
+	ForceSettings _forceSettings;
+	BarnesHutTree _forceTree;
+	std::vector<float> _masses;
+	std::vector<float> _charges;
+	std::vector<Vector2> _forces;
+	EventEngine _events;
+	struct GameplayEvent {
+		int entity;
+		bool wall;
+	};
+	std::vector<GameplayEvent> _gameplayEvents;
+	StaticGeometry _geometry;
+	LodSystem _lod;
+	std::vector<char> _movable;
+	std::vector<Vector2> _lodPoints;
+	std::vector<int> _lodCandidates;
+	std::vector<int> _lodNeighbours;
+	// bodies off their frame that still have pairs in their own row
+	std::vector<char> _lodRows;
+	// time each body has not been stepped for yet
+	std::vector<double> _lodPending;
+};
+
+typedef BasicModel<DefaultPhysics> Model;
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "NamePool.h"
+
+std::mutex NamePool::_mutex;
+std::atomic<std::string*> NamePool::_chunks[NAME_POOL_MAX_CHUNKS];
+NameId NamePool::_count = 0;
+std::unordered_map<std::string_view, NameId> NamePool::_ids;
+
+NameId NamePool::intern(const std::string& name) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _ids.find(name);
+	if (it != _ids.end()) {
+		return it->second;
+	}
+	NameId id = _count;
+	NameId chunk = id / NAME_POOL_CHUNK;
+	if (chunk >= NAME_POOL_MAX_CHUNKS) {
+		throw "Name pool is full.";
+	}
+	if (id % NAME_POOL_CHUNK == 0) {
+		_chunks[chunk].store(new std::string[NAME_POOL_CHUNK], std::memory_order_release);
+	}
+	std::string& pooled = _chunks[chunk].load(std::memory_order_relaxed)[id % NAME_POOL_CHUNK];
+	pooled = name;
+	_ids.emplace(pooled, id);
+	_count++;
+	return id;
+}
+
+const std::string& NamePool::lookup(NameId id) {
+	return _chunks[id / NAME_POOL_CHUNK].load(std::memory_order_acquire)[id % NAME_POOL_CHUNK];
+}
+
+int NamePool::getCount() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return (int)_count;
+}
+
+size_t NamePool::getBytes() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t chunks = (_count + NAME_POOL_CHUNK - 1) / NAME_POOL_CHUNK;
+	size_t bytes = chunks * NAME_POOL_CHUNK * sizeof(std::string) + _ids.bucket_count() * sizeof(void*);
+	// a node holds the key, the id, the cached hash and the next pointer
+	bytes += _ids.size() * (sizeof(std::string_view) + sizeof(NameId) + 2 * sizeof(void*));
+	for (NameId id = 0; id < _count; id++) {
+		const std::string& name = lookup(id);
+		bytes += name.capacity() > std::string().capacity() ? name.capacity() + 1 : 0;
+	}
+	return bytes;
+}
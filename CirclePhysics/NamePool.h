@@ -0,0 +1,32 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#define NAME_POOL_CHUNK 256
+#define NAME_POOL_MAX_CHUNKS 4096
+
+typedef uint32_t NameId;
+
+// Process-wide string pool for entity names. Entities that share a name share
+// one string and only keep its 4 byte id. Strings are never freed, so a
+// reference from lookup() stays valid for the life of the program, and the
+// index keys are views of the pooled strings rather than second copies. The
+// strings sit in fixed chunks that never move, so lookup() takes no lock, the
+// same as EntityTable; only intern() and the counters do.
+class NamePool {
+public:
+	static NameId intern(const std::string& name);
+	static const std::string& lookup(NameId id);
+	static int getCount();
+	// Heap held by the strings and the index, roughly
+	static size_t getBytes();
+private:
+	static std::mutex _mutex;
+	static std::atomic<std::string*> _chunks[NAME_POOL_MAX_CHUNKS];
+	static NameId _count;
+	static std::unordered_map<std::string_view, NameId> _ids;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+// Physics policies for BasicModel.
+// Compile-time policies declare their parameters as static constexpr members, so
+// a disabled feature (friction, the speed cap) is a constant false branch and is
+// folded away. RuntimePhysics carries the same parameters as plain data so they
+// can be tuned per Model instance. A new policy type also needs an explicit
+// instantiation at the bottom of Model.cpp.
+
+struct DefaultPhysics {
+	static constexpr float restitution = 1.0f;
+	static constexpr bool frictionEnabled = true;
+	static constexpr float frictionCoefficient = 0.8f;
+	static constexpr float playerSpeed = 2;
+	static constexpr bool speedCapEnabled = true;
+	static constexpr float maxSpeed = 200;
+	static constexpr bool warmStarting = false;
+	static constexpr float warmStartFactor = 1.0f;
+	static constexpr bool iterativeSolver = false;
+	static constexpr int solverIterations = 8;
+	static constexpr float solverTolerance = 0.01f;
+	static constexpr bool substepping = false;
+	static constexpr float substepFraction = 0.5f;
+	static constexpr int maxSubsteps = 8;
+	static constexpr bool eventDriven = false;
+};
+
+struct ElasticPhysics {
+	static constexpr float restitution = 1.0f;
+	static constexpr bool frictionEnabled = false;
+	static constexpr float frictionCoefficient = 0.0f;
+	static constexpr float playerSpeed = 2;
+	static constexpr bool speedCapEnabled = false;
+	static constexpr float maxSpeed = 0;
+	static constexpr bool warmStarting = false;
+	static constexpr float warmStartFactor = 1.0f;
+	static constexpr bool iterativeSolver = false;
+	static constexpr int solverIterations = 8;
+	static constexpr float solverTolerance = 0.01f;
+	static constexpr bool substepping = false;
+	static constexpr float substepFraction = 0.5f;
+	static constexpr int maxSubsteps = 8;
+	static constexpr bool eventDriven = false;
+};
+
+struct RuntimePhysics {
+	float restitution = DefaultPhysics::restitution;
+	bool frictionEnabled = DefaultPhysics::frictionEnabled;
+	float frictionCoefficient = DefaultPhysics::frictionCoefficient;
+	float playerSpeed = DefaultPhysics::playerSpeed;
+	bool speedCapEnabled = DefaultPhysics::speedCapEnabled;
+	float maxSpeed = DefaultPhysics::maxSpeed;
+	bool warmStarting = DefaultPhysics::warmStarting;
+	float warmStartFactor = DefaultPhysics::warmStartFactor;
+	bool iterativeSolver = DefaultPhysics::iterativeSolver;
+	int solverIterations = DefaultPhysics::solverIterations;
+	float solverTolerance = DefaultPhysics::solverTolerance;
+	bool substepping = DefaultPhysics::substepping;
+	// a body moving further than this fraction of its radius per step is substepped
+	float substepFraction = DefaultPhysics::substepFraction;
+	// power of two
+	int maxSubsteps = DefaultPhysics::maxSubsteps;
+	// jump from collision to collision instead of stepping, see EventEngine
+	bool eventDriven = DefaultPhysics::eventDriven;
+};
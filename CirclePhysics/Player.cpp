@@ -2,18 +2,32 @@
 #include <iostream>
 
 void Player::onDeath() {
-	std::cout << "died\n";
-	_active = false;
+	if (_logging) {
+		std::cout << "died\n";
+	}
+	setActive(false);
 }
 
 void Player::onCollide() {
-	std::cout << "player collided\n";
+	if (_logging) {
+		std::cout << "player collided\n";
+	}
 	subtractHealth(1);
-	std::cout << "player now has " + std::to_string(_health) + "health\n";
+	if (_logging) {
+		std::cout << "player now has " + std::to_string(getHealth()) + "health\n";
+	}
 }
 
 void Player::onCollideWall() {
-	std::cout << "player collided with wall\n";
+	if (_logging) {
+		std::cout << "player collided with wall\n";
+	}
 	subtractHealth(5);
-	std::cout << "player now has " + std::to_string(_health) + "health\n";
+	if (_logging) {
+		std::cout << "player now has " + std::to_string(getHealth()) + "health\n";
+	}
+}
+
+void Player::setLogging(bool b) {
+	_logging = b;
 }
\ No newline at end of file
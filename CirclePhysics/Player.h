@@ -6,6 +6,9 @@ class Player : public Entity {
 	virtual void onDeath();
 	virtual void onCollide();
 	virtual void onCollideWall();
+public:
+	void setLogging(bool b);
 private:
 	int _lives = NUM_LIVES;
+	bool _logging = true;
 };
\ No newline at end of file
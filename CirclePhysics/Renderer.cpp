@@ -1,4 +1,5 @@
 #include "Renderer.h"
+#include <chrono>
 #include <iostream>
 
 #define ARROW_HEAD_LENGTH 20
@@ -20,30 +21,58 @@ Renderer::Renderer(Model* m) {
 	_m = m;
 }
 
+void Renderer::capture() {
+	std::lock_guard<std::mutex> lock(_snapshotMutex);
+	_sprites.clear();
+	for (int i = 0; i < _m->getEntityCount(); i++) {
+		const Entity* e = _m->getEntity(i);
+		const Collider& c = *e->getCollider();
+		_sprites.push_back(Sprite{ _m->getDisplayPosition(i), c.getVelocity(), c.getWidth(), c.getHeight(), e->getColor() });
+	}
+	_health = _m->getPlayer()->getHealth();
+	_maxHealth = _m->getPlayer()->getMaxHealth();
+	if (_latency != nullptr) {
+		_latency->captured();
+	}
+}
+
+void Renderer::setLatency(InputLatency* latency) {
+	_latency = latency;
+}
+
 void Renderer::Paint(Window* win, Graphics* g) {
 	if (_drawing) {
 		g->Clear();
 		
 		g->FillRect(0, 0, _m->getWidth(), _m->getHeight());
 
-		for (Entity* e : _m->getEntities()) {
-			const Collider& c = *e->getCollider();
-			Color color = c.getColor();
+		// level geometry never changes, so it is drawn straight from the model
+		for (const GeometryShape& shape : _m->getGeometry().getShapes()) {
+			if (shape.shape == GEOMETRY_CIRCLE) {
+				g->DrawEllipse(shape.a.X - shape.radius, shape.a.Y - shape.radius, shape.radius * 2, shape.radius * 2);
+			}
+			else {
+				g->DrawLine(shape.a.X, shape.a.Y, shape.b.X, shape.b.Y);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(_snapshotMutex);
+		for (const Sprite& s : _sprites) {
+			Color color = Color(s.color);
 			g->SetFillColor(color);
 
-			float height = c.getHeight();
-			float width = c.getWidth();
-			Vector2 pos = c.getPos();
-			Vector2 vel = c.getVelocity();
-			g->DrawEllipse(pos.X - width / 2, pos.Y - height / 2, width, height);
+			g->DrawEllipse(s.pos.X - s.width / 2, s.pos.Y - s.height / 2, s.width, s.height);
 			if (ARROW_DRAW) {
-				PaintArrow(win, g, pos, vel, height);
+				PaintArrow(win, g, s.pos, s.vel, s.height);
 			}
 
 			PaintHUD(win, g);
 			
 			g->SetFillColor(255, 255, 255);
 		}
+		if (_latency != nullptr) {
+			_latency->presented(std::chrono::steady_clock::now());
+		}
 	}
 	else {
 		g->Clear();
@@ -80,8 +109,8 @@ void Renderer::PaintHUD(Window* win, Graphics* g) {
 	int modelHeight = _m->getHeight();
 	int modelWidth = _m->getWidth();
 
-	int currHealth = _m->getPlayer()->getHealth();
-	int maxHealth = _m->getPlayer()->getMaxHealth();
+	int currHealth = _health;
+	int maxHealth = _maxHealth;
 
 	g->SetFillColor(Color::WHITE);
 	g->FillRect(HUD_HOR_OFFSET, modelHeight + HUD_VERT_OFFSET, 300, 30);
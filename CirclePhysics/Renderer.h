@@ -1,13 +1,28 @@
 #pragma once
 #include "simplegui.h"
 #include "Vector2.h"
+#include <mutex>
 #include <vector>
 #include "Model.h"
 using namespace simplegui;
 
+// What Paint draws of one entity
+struct Sprite {
+	Vector2 pos;
+	Vector2 vel;
+	float width;
+	float height;
+	uint32_t color;
+};
+
 class Renderer : public Painter {
 public:
 	Renderer(Model* m);
+	// Copies what Paint draws out of the model, so the window thread never
+	// reads entities while a frame is updating them
+	void capture();
+	// Inputs simulated before a capture count as presented when Paint draws it
+	void setLatency(InputLatency* latency);
 	virtual void Paint(Window* win, Graphics* g);
 	void PaintArrow(Window* win, Graphics* g, Vector2 pos, Vector2 vel, float height);
 	void PaintHUD(Window* win, Graphics* g);
@@ -18,6 +33,11 @@ public:
 	void setCurrTime(double d);
 private:
 	Model* _m;
+	std::mutex _snapshotMutex;
+	std::vector<Sprite> _sprites;
+	InputLatency* _latency = nullptr;
+	int _health = 0;
+	int _maxHealth = 1;
 	double _currTime = 0;
 	bool _drawing = true;
 	std::string _defaultDisplay = "You are dead.";
@@ -0,0 +1,192 @@
+#include "Rollback.h"
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Collider>::value, "The history copies colliders as bytes.");
+static_assert(sizeof(Collider) % sizeof(uint32_t) == 0, "The history stores colliders as whole words.");
+
+template <typename Physics>
+RollbackHistory<Physics>::RollbackHistory(BasicModel<Physics>& model, int frames) : _model(model), _frames(frames) {
+	if (frames <= 0) {
+		throw "Rollback history needs room for at least one frame.";
+	}
+}
+
+template <typename Physics>
+RollbackHistory<Physics>::~RollbackHistory() {
+	clear();
+}
+
+template <typename Physics>
+void RollbackHistory<Physics>::read(int index, uint32_t* record) const {
+	const Entity& e = *_model.getEntity(index);
+	memcpy(record, e.getCollider(), sizeof(Collider));
+	record[ROLLBACK_BODY_WORDS - 2] = (uint32_t)e.getHealth();
+	record[ROLLBACK_BODY_WORDS - 1] = e.getActive() ? 1 : 0;
+}
+
+template <typename Physics>
+void RollbackHistory<Physics>::write(int index, const uint32_t* record) {
+	Entity& e = *_model.getEntity(index);
+	memcpy((void*)e.editCollider(), record, sizeof(Collider));
+	e.setHealth((int)record[ROLLBACK_BODY_WORDS - 2]);
+	e.setActive(record[ROLLBACK_BODY_WORDS - 1] != 0);
+}
+
+template <typename Physics>
+void RollbackHistory<Physics>::restart() {
+	// a new baseline, nothing before it can be restored
+	if (_bodies >= 0) {
+		_stats.restarts++;
+	}
+	BodyStore& store = _model.getBodyStore();
+	int n = store.size();
+	_bodies = n;
+	_entityChanges = store.getChanges();
+	_current.resize((size_t)n * ROLLBACK_BODY_WORDS);
+	for (int i = 0; i < n; i++) {
+		read(i, &_current[(size_t)i * ROLLBACK_BODY_WORDS]);
+	}
+	store.setLogging(true);
+	store.clearWritten();
+	_count = 0;
+	_stats.frames = 0;
+	_stats.deltaBytes = 0;
+	_stats.baselineBytes = _current.size() * sizeof(uint32_t);
+}
+
+template <typename Physics>
+bool RollbackHistory<Physics>::sameEntities() {
+	return _bodies >= 0 && _model.getBodyStore().getChanges() == _entityChanges;
+}
+
+template <typename Physics>
+void RollbackHistory<Physics>::capture() {
+	_stats.changedBodies = 0;
+	_stats.changedWords = 0;
+	BodyStore& store = _model.getBodyStore();
+	_stats.loggedBodies = (int)store.getWritten().size();
+	if (!sameEntities()) {
+		restart();
+		return;
+	}
+
+	// the oldest frame makes room once the ring is full
+	int capacity = (int)_frames.size();
+	_newest = (_newest + 1) % capacity;
+	std::vector<uint32_t>& delta = _frames[_newest];
+	if (_count == capacity) {
+		_stats.deltaBytes -= delta.size() * sizeof(uint32_t);
+	}
+	else {
+		_count++;
+	}
+	delta.clear();
+	uint32_t record[ROLLBACK_BODY_WORDS];
+	uint32_t changed[ROLLBACK_BODY_WORDS];
+	for (int i : store.getWritten()) {
+		read(i, record);
+		uint32_t* old = &_current[(size_t)i * ROLLBACK_BODY_WORDS];
+		uint32_t mask = 0;
+		int count = 0;
+		for (int w = 0; w < ROLLBACK_BODY_WORDS; w++) {
+			uint32_t x = record[w] ^ old[w];
+			if (x != 0) {
+				mask |= 1u << w;
+				changed[count++] = x;
+				old[w] = record[w];
+			}
+		}
+		if (mask == 0) {
+			continue;
+		}
+		delta.push_back((uint32_t)i);
+		delta.push_back(mask);
+		delta.insert(delta.end(), changed, changed + count);
+		_stats.changedWords += count;
+		_stats.changedBodies++;
+	}
+	store.clearWritten();
+	_stats.deltaBytes += delta.size() * sizeof(uint32_t);
+	_stats.frames = _count;
+}
+
+template <typename Physics>
+void RollbackHistory<Physics>::rewind(int frames) {
+	if (frames < 0 || frames > _count) {
+		throw "Cannot rewind further than the history holds.";
+	}
+	if (!sameEntities()) {
+		throw "Entities were added or removed since the last capture.";
+	}
+	BodyStore& store = _model.getBodyStore();
+	_changedIndices = store.getWritten();
+	int capacity = (int)_frames.size();
+	for (int f = 0; f < frames; f++) {
+		std::vector<uint32_t>& delta = _frames[_newest];
+		for (size_t k = 0; k < delta.size();) {
+			uint32_t index = delta[k++];
+			uint32_t mask = delta[k++];
+			_changedIndices.push_back((int)index);
+			uint32_t* words = &_current[(size_t)index * ROLLBACK_BODY_WORDS];
+			for (int w = 0; w < ROLLBACK_BODY_WORDS; w++) {
+				if (mask & (1u << w)) {
+					words[w] ^= delta[k++];
+				}
+			}
+		}
+		_stats.deltaBytes -= delta.size() * sizeof(uint32_t);
+		delta.clear();
+		_newest = (_newest - 1 + capacity) % capacity;
+		_count--;
+	}
+	_stats.frames = _count;
+
+	// the bodies in the deltas and those written to after the last capture,
+	// the rest still match the newest state
+	uint32_t record[ROLLBACK_BODY_WORDS];
+	for (int i : _changedIndices) {
+		const uint32_t* words = &_current[(size_t)i * ROLLBACK_BODY_WORDS];
+		read(i, record);
+		if (memcmp(record, words, sizeof(record)) != 0) {
+			write(i, words);
+		}
+	}
+	_changedIndices.clear();
+	store.clearWritten();
+	_model.resync();
+}
+
+template <typename Physics>
+int RollbackHistory<Physics>::getFrameCount() const {
+	return _count;
+}
+
+template <typename Physics>
+int RollbackHistory<Physics>::getCapacity() const {
+	return (int)_frames.size();
+}
+
+template <typename Physics>
+const RollbackStats& RollbackHistory<Physics>::getStats() const {
+	return _stats;
+}
+
+template <typename Physics>
+void RollbackHistory<Physics>::clear() {
+	if (_bodies >= 0) {
+		_model.getBodyStore().setLogging(false);
+	}
+	_changedIndices.clear();
+	for (std::vector<uint32_t>& delta : _frames) {
+		delta.clear();
+	}
+	_bodies = -1;
+	_current.clear();
+	_count = 0;
+	_stats = RollbackStats();
+}
+
+template class RollbackHistory<DefaultPhysics>;
+template class RollbackHistory<ElasticPhysics>;
+template class RollbackHistory<RuntimePhysics>;
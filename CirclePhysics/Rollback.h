@@ -0,0 +1,78 @@
+#pragma once
+#include "Model.h"
+#include <cstdint>
+#include <vector>
+
+// frames of history kept by default, two seconds at the game's frame rate
+#define ROLLBACK_FRAMES 200
+// a body as the history sees it: the collider's bytes, then health and active
+#define ROLLBACK_BODY_WORDS (sizeof(Collider) / sizeof(uint32_t) + 2)
+
+struct RollbackStats {
+	int frames = 0;
+	// bodies written to since the capture before, the only ones the last
+	// capture looked at
+	int loggedBodies = 0;
+	// bodies whose record changed in the last capture
+	int changedBodies = 0;
+	// words those bodies changed, out of ROLLBACK_BODY_WORDS each
+	int changedWords = 0;
+	// entity changes that restarted the history
+	int restarts = 0;
+	size_t deltaBytes = 0;
+	size_t baselineBytes = 0;
+};
+
+// Ring buffer of per-frame snapshots for rewinding a model. The history keeps
+// the newest state in full and, for every frame, the words of each body
+// record that changed, XORed with their old value. The model's body store logs
+// each body on its first write after a capture (see BodyStore) and capturing
+// compares only those records with the newest state, storing what differs: a
+// body nothing wrote to is not even looked at, a body that moved costs its
+// index, a word mask and the four position and velocity words. XOR is its own
+// inverse, so rewinding applies the same deltas backwards and writes back only
+// the bodies that differ.
+//
+// Rewinding restores every collider, health and active flag bit for bit and
+// resyncs the model, so with the plain integrator and either contact path the
+// frames stepped after it are the same as the first time. Warm-start impulses,
+// event predictions and banked LOD time are not part of the history. Adding or
+// removing an entity restarts it. Clearing or destroying the history stops the
+// store logging.
+template <typename Physics>
+class RollbackHistory {
+public:
+	RollbackHistory(BasicModel<Physics>& model, int frames = ROLLBACK_FRAMES);
+	RollbackHistory(const RollbackHistory&) = delete;
+	RollbackHistory& operator=(const RollbackHistory&) = delete;
+	~RollbackHistory();
+	// Call once after every model update
+	void capture();
+	// Puts the model back to the state it had the given number of captures ago
+	void rewind(int frames);
+	// Captures that can be rewound
+	int getFrameCount() const;
+	int getCapacity() const;
+	const RollbackStats& getStats() const;
+	void clear();
+private:
+	void read(int index, uint32_t* record) const;
+	void write(int index, const uint32_t* record);
+	void restart();
+	// false if entities were added or removed since the baseline
+	bool sameEntities();
+
+	BasicModel<Physics>& _model;
+	int _bodies = -1;
+	// the store's entity changes at the baseline, any since restart it
+	int _entityChanges = 0;
+	// the newest captured state, ROLLBACK_BODY_WORDS per body
+	std::vector<uint32_t> _current;
+	// the bodies a rewind has to look at
+	std::vector<int> _changedIndices;
+	// per frame: body index, word mask, then the XOR of every word in the mask
+	std::vector<std::vector<uint32_t>> _frames;
+	int _newest = 0;
+	int _count = 0;
+	RollbackStats _stats;
+};
@@ -0,0 +1,195 @@
+#include "SceneGenerator.h"
+#include "Enemy.h"
+#include <chrono>
+#include <fstream>
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int round = 0; round < PHILOX_ROUNDS; round++) {
+		uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+		uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+		c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+		c1 = (uint32_t)p1;
+		c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+		c3 = (uint32_t)p0;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+// [0, 1) from the top 24 bits, every value equally likely
+static float toUnit(uint32_t bits) {
+	return (bits >> 8) * (1.0f / 16777216.0f);
+}
+
+double SceneStats::getBodiesPerSecond() const {
+	return milliseconds > 0 ? bodies / milliseconds * 1000 : 0;
+}
+
+SceneGenerator::SceneGenerator(ThreadPool& pool) : _pool(pool) {}
+
+SceneBody SceneGenerator::makeBody(const SceneSettings& settings, int index, int attempt) {
+	uint32_t key[2] = { (uint32_t)settings.seed, (uint32_t)(settings.seed >> 32) };
+	uint32_t counter[4] = { (uint32_t)index, (uint32_t)attempt, 0, 0 };
+	uint32_t first[4];
+	uint32_t second[4];
+	philox(counter, key, first);
+	counter[2] = 1;
+	philox(counter, key, second);
+
+	SceneBody b;
+	b.size = settings.minSize + toUnit(first[0]) * (settings.maxSize - settings.minSize);
+	b.mass = b.size * settings.massSizeRatio;
+	b.pos.X = toUnit(first[1]) * (settings.width - b.size) + b.size / 2;
+	b.pos.Y = toUnit(first[2]) * (settings.height - b.size) + b.size / 2;
+	float velocityRange = settings.maxAxisVelocity - settings.minAxisVelocity;
+	b.vel.X = settings.minAxisVelocity + toUnit(first[3]) * velocityRange;
+	b.vel.Y = settings.minAxisVelocity + toUnit(second[0]) * velocityRange;
+	return b;
+}
+
+void SceneGenerator::generate(const SceneSettings& settings) {
+	auto start = std::chrono::steady_clock::now();
+	_stats = SceneStats();
+	_bodies.resize(settings.bodies);
+	_pool.parallelFor(settings.bodies, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			_bodies[i] = makeBody(settings, i);
+		}
+	});
+
+	if (settings.rejectOverlaps) {
+		std::vector<int> pending(settings.bodies);
+		for (int i = 0; i < settings.bodies; i++) {
+			pending[i] = i;
+		}
+		std::vector<int> next;
+		std::vector<char> clear;
+		SpatialGrid placed(settings.maxSize);
+		SpatialGrid drawn(settings.maxSize);
+		for (int attempt = 0; attempt < SCENE_MAX_ATTEMPTS && !pending.empty(); attempt++) {
+			_stats.rounds++;
+			if (attempt > 0) {
+				_pool.parallelFor((int)pending.size(), [&](int begin, int end) {
+					for (int p = begin; p < end; p++) {
+						_bodies[pending[p]] = makeBody(settings, pending[p], attempt);
+					}
+				});
+			}
+			drawn.clear();
+			for (int i : pending) {
+				drawn.insert(i, _bodies[i].pos, _bodies[i].size / 2);
+			}
+			clear.assign(pending.size(), 0);
+			_pool.parallelFor((int)pending.size(), [&](int begin, int end) {
+				std::vector<int> hits;
+				for (int p = begin; p < end; p++) {
+					const SceneBody& b = _bodies[pending[p]];
+					float radius = b.size / 2;
+					if (settings.geometry != nullptr && settings.geometry->overlaps(b.pos, radius)) {
+						continue;
+					}
+					hits.clear();
+					placed.queryCircle(b.pos, radius, hits);
+					if (!hits.empty()) {
+						continue;
+					}
+					hits.clear();
+					drawn.queryCircle(b.pos, radius, hits);
+					bool lowest = true;
+					for (int j : hits) {
+						lowest = lowest && j >= pending[p];
+					}
+					clear[p] = lowest;
+				}
+			});
+			next.clear();
+			for (int p = 0; p < pending.size(); p++) {
+				if (clear[p]) {
+					placed.insert(pending[p], _bodies[pending[p]].pos, _bodies[pending[p]].size / 2);
+				}
+				else {
+					next.push_back(pending[p]);
+				}
+			}
+			_stats.rejected += (int)next.size();
+			pending.swap(next);
+		}
+
+		// bodies that never found room are left out, the rest keep their order
+		_stats.dropped = (int)pending.size();
+		_stats.rejected -= _stats.dropped;
+		if (!pending.empty()) {
+			std::vector<char> dropped(settings.bodies, 0);
+			for (int i : pending) {
+				dropped[i] = 1;
+			}
+			int kept = 0;
+			for (int i = 0; i < settings.bodies; i++) {
+				if (!dropped[i]) {
+					_bodies[kept++] = _bodies[i];
+				}
+			}
+			_bodies.resize(kept);
+		}
+	}
+	_stats.bodies = (int)_bodies.size();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	_stats.milliseconds = elapsed.count();
+}
+
+const std::vector<SceneBody>& SceneGenerator::getBodies() const {
+	return _bodies;
+}
+
+const SceneStats& SceneGenerator::getStats() const {
+	return _stats;
+}
+
+template <typename Physics>
+std::vector<Entity*> SceneGenerator::addTo(BasicModel<Physics>& model) const {
+	std::vector<Entity*> entities;
+	entities.reserve(_bodies.size());
+	NameId name = NamePool::intern("enemy");
+	for (int i = 0; i < _bodies.size(); i++) {
+		const SceneBody& b = _bodies[i];
+		Collider c = Collider(b.pos, b.vel, b.size, b.mass);
+		c.setLayer(LAYER_ENEMY);
+		Enemy* e = new Enemy(c, name);
+		model.addEntity(e);
+		entities.push_back(e);
+	}
+	return entities;
+}
+
+void SceneGenerator::write(std::ostream& out) const {
+	// enough digits to read back the same floats
+	std::streamsize precision = out.precision(9);
+	for (const SceneBody& b : _bodies) {
+		out << b.pos.X << ',' << b.pos.Y << ',' << b.vel.X << ',' << b.vel.Y << ',' << b.size << ',' << b.mass << ',' << TYPE_CIRCLE << '\n';
+	}
+	out.precision(precision);
+}
+
+void SceneGenerator::writeFile(const std::string& path) const {
+	std::ofstream out{ path, std::ios::out };
+	if (!out.is_open()) {
+		throw "Scene file could not be written.";
+	}
+	write(out);
+}
+
+template std::vector<Entity*> SceneGenerator::addTo(BasicModel<DefaultPhysics>& model) const;
+template std::vector<Entity*> SceneGenerator::addTo(BasicModel<ElasticPhysics>& model) const;
+template std::vector<Entity*> SceneGenerator::addTo(BasicModel<RuntimePhysics>& model) const;
@@ -0,0 +1,80 @@
+#pragma once
+#include "Model.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// rounds of redrawing a rejected body before it is left out of the scene
+#define SCENE_MAX_ATTEMPTS 8
+
+struct SceneSettings {
+	uint64_t seed = 0;
+	int bodies = 15;
+	float width = 500;
+	float height = 500;
+	float minSize = 8;
+	float maxSize = 40;
+	// each velocity component is drawn from this range
+	float minAxisVelocity = 0;
+	float maxAxisVelocity = 60;
+	float massSizeRatio = 10;
+	// redraw bodies that would overlap another body or the geometry
+	bool rejectOverlaps = false;
+	const StaticGeometry* geometry = nullptr;
+};
+
+struct SceneBody {
+	Vector2 pos;
+	Vector2 vel;
+	float size;
+	float mass;
+};
+
+struct SceneStats {
+	int bodies = 0;
+	// draws thrown away for overlapping, and bodies still overlapping after
+	// every attempt, which are left out
+	int rejected = 0;
+	int dropped = 0;
+	int rounds = 0;
+	double milliseconds = 0;
+	double getBodiesPerSecond() const;
+};
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"):
+// a keyed bijection of a 128 bit counter, so any draw can be made on its own
+// without stepping a generator state
+void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+// Random scenes that do not depend on the thread count or the order bodies are
+// made in. Draw k of body i is a pure function of the seed, i and k, so without
+// overlap rejection body i is always the same whatever the body count, and
+// bodies are made in parallel on the pool.
+//
+// With rejection every body starts with draw 0 and the draws are checked in
+// rounds: a draw is kept if it is clear of the geometry, of the bodies already
+// kept and of this round's draws of lower-numbered bodies. The rest draw again
+// next round. The outcome is the same for a seed on any number of threads; it
+// is a little stricter than placing bodies one by one, a draw can give way to a
+// lower one that ends up redrawn too.
+class SceneGenerator {
+public:
+	SceneGenerator(ThreadPool& pool);
+	// Draw attempt of body index
+	static SceneBody makeBody(const SceneSettings& settings, int index, int attempt = 0);
+	void generate(const SceneSettings& settings);
+	const std::vector<SceneBody>& getBodies() const;
+	const SceneStats& getStats() const;
+	// Adds an enemy for every body and returns them, the caller owns them
+	template <typename Physics>
+	std::vector<Entity*> addTo(BasicModel<Physics>& model) const;
+	// One line per body in the colliders.txt format
+	void write(std::ostream& out) const;
+	void writeFile(const std::string& path) const;
+private:
+	ThreadPool& _pool;
+	std::vector<SceneBody> _bodies;
+	SceneStats _stats;
+};
@@ -0,0 +1,327 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+void QueryResults::clear() {
+	offsets.clear();
+	indices.clear();
+	offsets.push_back(0);
+}
+
+int QueryResults::getCount(int query) const {
+	return offsets[query + 1] - offsets[query];
+}
+
+const int* QueryResults::begin(int query) const {
+	return indices.data() + offsets[query];
+}
+
+const int* QueryResults::end(int query) const {
+	return indices.data() + offsets[query + 1];
+}
+
+SpatialGrid::SpatialGrid(float cellSize) : _cellSize(cellSize) {}
+
+int SpatialGrid::cellCoord(float v) const {
+	float cell = std::floor(v / _cellSize);
+	// keeps NaN and runaway positions from producing huge cell ranges
+	if (!(std::abs(cell) < SPATIAL_GRID_MAX_CELL)) {
+		return cell > 0 ? SPATIAL_GRID_MAX_CELL : (cell < 0 ? -SPATIAL_GRID_MAX_CELL : 0);
+	}
+	return (int)cell;
+}
+
+template <typename Visit>
+void SpatialGrid::forEachCell(int x0, int x1, int y0, int y1, Visit visit) const {
+	// a range wider than the occupied cells is cheaper to scan the other way
+	if ((double)(x1 - x0 + 1) * (y1 - y0 + 1) > _cells.size()) {
+		for (const auto& cell : _cells) {
+			int x = (int)(cell.first >> 32);
+			int y = (int)(int32_t)(uint32_t)cell.first;
+			if (x >= x0 && x <= x1 && y >= y0 && y <= y1) {
+				visit(cell.second);
+			}
+		}
+		return;
+	}
+	for (int x = x0; x <= x1; x++) {
+		for (int y = y0; y <= y1; y++) {
+			auto it = _cells.find(cellKey(x, y));
+			if (it != _cells.end()) {
+				visit(it->second);
+			}
+		}
+	}
+}
+
+int64_t SpatialGrid::cellKey(int x, int y) {
+	return ((int64_t)x << 32) | (uint32_t)y;
+}
+
+int64_t SpatialGrid::cellOf(Vector2 pos) const {
+	return cellKey(cellCoord(pos.X), cellCoord(pos.Y));
+}
+
+void SpatialGrid::addToCell(int index, int64_t cell) {
+	int x = (int)(cell >> 32);
+	int y = (int)(int32_t)(uint32_t)cell;
+	_minCellX = std::min(_minCellX, x);
+	_maxCellX = std::max(_maxCellX, x);
+	_minCellY = std::min(_minCellY, y);
+	_maxCellY = std::max(_maxCellY, y);
+	std::vector<int>& bucket = _cells[cell];
+	_bodies[index].slot = (int)bucket.size();
+	bucket.push_back(index);
+}
+
+void SpatialGrid::removeFromCell(int index) {
+	auto it = _cells.find(cellOf(_bodies[index].pos));
+	std::vector<int>& bucket = it->second;
+	int slot = _bodies[index].slot;
+	bucket[slot] = bucket.back();
+	_bodies[bucket[slot]].slot = slot;
+	bucket.pop_back();
+	if (bucket.empty()) {
+		_cells.erase(it);
+	}
+}
+
+void SpatialGrid::insert(int index, Vector2 pos, float radius) {
+	if (index >= _bodies.size()) {
+		_bodies.resize(index + 1, Body{ Vector2(), 0, -1 });
+	}
+	if (_bodies[index].slot >= 0) {
+		move(index, pos, radius);
+		return;
+	}
+	_bodies[index].pos = pos;
+	_bodies[index].radius = radius;
+	_maxRadius = std::max(_maxRadius, radius);
+	_count++;
+	addToCell(index, cellOf(pos));
+}
+
+void SpatialGrid::move(int index, Vector2 pos, float radius) {
+	Body& b = _bodies[index];
+	int64_t cell = cellOf(pos);
+	if (cell != cellOf(b.pos)) {
+		// the old cell comes from the old position, so take it out first
+		removeFromCell(index);
+		addToCell(index, cell);
+		_cellChanges++;
+	}
+	b.pos = pos;
+	b.radius = radius;
+	_maxRadius = std::max(_maxRadius, radius);
+}
+
+void SpatialGrid::remove(int index) {
+	if (index >= _bodies.size() || _bodies[index].slot < 0) {
+		return;
+	}
+	removeFromCell(index);
+	_bodies[index].slot = -1;
+	_count--;
+}
+
+void SpatialGrid::clear() {
+	_bodies.clear();
+	_cells.clear();
+	_maxRadius = 0;
+	_count = 0;
+	_minCellX = SPATIAL_GRID_MAX_CELL;
+	_maxCellX = -SPATIAL_GRID_MAX_CELL;
+	_minCellY = SPATIAL_GRID_MAX_CELL;
+	_maxCellY = -SPATIAL_GRID_MAX_CELL;
+}
+
+float SpatialGrid::getCellSize() const {
+	return _cellSize;
+}
+
+int SpatialGrid::getCellChanges() const {
+	return _cellChanges;
+}
+
+void SpatialGrid::resetCellChanges() {
+	_cellChanges = 0;
+}
+
+void SpatialGrid::queryCircle(Vector2 center, float radius, std::vector<int>& out) const {
+	// centers are bucketed, so widen the cell range by the largest radius
+	float reach = radius + _maxRadius;
+	int x0 = cellCoord(center.X - reach), x1 = cellCoord(center.X + reach);
+	int y0 = cellCoord(center.Y - reach), y1 = cellCoord(center.Y + reach);
+	forEachCell(x0, x1, y0, y1, [&](const std::vector<int>& bucket) {
+		for (int i : bucket) {
+			const Body& b = _bodies[i];
+			Vector2 d = b.pos - center;
+			float r = radius + b.radius;
+			if (dot(d, d) < r * r) {
+				out.push_back(i);
+			}
+		}
+	});
+}
+
+void SpatialGrid::queryAabb(Vector2 min, Vector2 max, std::vector<int>& out) const {
+	int x0 = cellCoord(min.X - _maxRadius), x1 = cellCoord(max.X + _maxRadius);
+	int y0 = cellCoord(min.Y - _maxRadius), y1 = cellCoord(max.Y + _maxRadius);
+	forEachCell(x0, x1, y0, y1, [&](const std::vector<int>& bucket) {
+		for (int i : bucket) {
+			const Body& b = _bodies[i];
+			// closest point of the box to the circle center
+			float cx = std::min(std::max(b.pos.X, min.X), max.X);
+			float cy = std::min(std::max(b.pos.Y, min.Y), max.Y);
+			float dx = b.pos.X - cx;
+			float dy = b.pos.Y - cy;
+			if (dx * dx + dy * dy < b.radius * b.radius) {
+				out.push_back(i);
+			}
+		}
+	});
+}
+
+void SpatialGrid::queryNearest(Vector2 point, int k, std::vector<int>& out) const {
+	if (k <= 0 || _count == 0) {
+		return;
+	}
+	// max-heap of (surface distance, index) holding the best k so far
+	std::priority_queue<std::pair<float, int>> best;
+	int cx = cellCoord(point.X);
+	int cy = cellCoord(point.Y);
+	// rings short of the occupied cells are empty, rings past all of them
+	// have nothing left to find
+	int firstRing = std::max(std::max(_minCellX - cx, cx - _maxCellX), std::max(_minCellY - cy, cy - _maxCellY));
+	int lastRing = std::max(std::max(cx - _minCellX, _maxCellX - cx), std::max(cy - _minCellY, _maxCellY - cy));
+	// true if every body centered in the cells x0..x1, y0..y1 is further than
+	// the k-th best so far
+	auto beyond = [&](int x0, int x1, int y0, int y1) {
+		if (best.size() < k) {
+			return false;
+		}
+		float dx = std::max(std::max(x0 * _cellSize - point.X, point.X - (x1 + 1) * _cellSize), 0.0f);
+		float dy = std::max(std::max(y0 * _cellSize - point.Y, point.Y - (y1 + 1) * _cellSize), 0.0f);
+		return std::sqrt(dx * dx + dy * dy) - _maxRadius >= best.top().first;
+	};
+	auto visit = [&](int x0, int x1, int y0, int y1) {
+		if (x0 > x1 || y0 > y1 || beyond(x0, x1, y0, y1)) {
+			return;
+		}
+		for (int x = x0; x <= x1; x++) {
+			for (int y = y0; y <= y1; y++) {
+				if (beyond(x, x, y, y)) {
+					continue;
+				}
+				auto it = _cells.find(cellKey(x, y));
+				if (it == _cells.end()) {
+					continue;
+				}
+				for (int i : it->second) {
+					float d = getLength(_bodies[i].pos - point) - _bodies[i].radius;
+					if (best.size() < k) {
+						best.push({ d, i });
+					}
+					else if (d < best.top().first) {
+						best.pop();
+						best.push({ d, i });
+					}
+				}
+			}
+		}
+	};
+	for (int ring = std::max(firstRing, 0); ring <= lastRing; ring++) {
+		// only the border of the ring, the inside was visited already, and
+		// only where it crosses the occupied cells: the left and right columns
+		// whole, the bottom and top rows between them
+		int y0 = std::max(cy - ring, _minCellY);
+		int y1 = std::min(cy + ring, _maxCellY);
+		int x0 = std::max(cx - ring + 1, _minCellX);
+		int x1 = std::min(cx + ring - 1, _maxCellX);
+		if (cx - ring >= _minCellX) {
+			visit(cx - ring, cx - ring, y0, y1);
+		}
+		if (ring > 0 && cx + ring <= _maxCellX) {
+			visit(cx + ring, cx + ring, y0, y1);
+		}
+		if (cy - ring >= _minCellY) {
+			visit(x0, x1, cy - ring, cy - ring);
+		}
+		if (ring > 0 && cy + ring <= _maxCellY) {
+			visit(x0, x1, cy + ring, cy + ring);
+		}
+		// every unvisited center is at least ring cells away
+		if (best.size() == k && best.top().first <= ring * _cellSize - _maxRadius) {
+			break;
+		}
+	}
+	size_t first = out.size();
+	out.resize(first + best.size());
+	for (size_t i = out.size(); i > first; i--) {
+		out[i - 1] = best.top().second;
+		best.pop();
+	}
+}
+
+bool SpatialGrid::raycast(const Ray& ray, RayHit& hit) const {
+	hit = RayHit();
+	if (!std::isfinite(ray.origin.X + ray.origin.Y + ray.direction.X + ray.direction.Y + ray.maxDistance)) {
+		return false;
+	}
+	float best = ray.maxDistance;
+	int reach = (int)std::ceil(_maxRadius / _cellSize);
+	int x = cellCoord(ray.origin.X);
+	int y = cellCoord(ray.origin.Y);
+	int stepX = ray.direction.X >= 0 ? 1 : -1;
+	int stepY = ray.direction.Y >= 0 ? 1 : -1;
+	const float inf = std::numeric_limits<float>::infinity();
+	float deltaX = ray.direction.X != 0 ? _cellSize / std::abs(ray.direction.X) : inf;
+	float deltaY = ray.direction.Y != 0 ? _cellSize / std::abs(ray.direction.Y) : inf;
+	float nextX = ray.direction.X != 0 ? ((x + (stepX > 0 ? 1 : 0)) * _cellSize - ray.origin.X) / ray.direction.X : inf;
+	float nextY = ray.direction.Y != 0 ? ((y + (stepY > 0 ? 1 : 0)) * _cellSize - ray.origin.Y) / ray.direction.Y : inf;
+
+	// walk the cells the ray passes through, testing every body whose center
+	// is close enough to reach into the current cell
+	while (true) {
+		for (int nx = x - reach; nx <= x + reach; nx++) {
+			for (int ny = y - reach; ny <= y + reach; ny++) {
+				auto it = _cells.find(cellKey(nx, ny));
+				if (it == _cells.end()) {
+					continue;
+				}
+				for (int i : it->second) {
+					const Body& b = _bodies[i];
+					Vector2 oc = ray.origin - b.pos;
+					float half = dot(oc, ray.direction);
+					float c = dot(oc, oc) - b.radius * b.radius;
+					float disc = half * half - c;
+					if (disc < 0) {
+						continue;
+					}
+					float t = c < 0 ? 0 : -half - std::sqrt(disc);
+					if (t >= 0 && t < best) {
+						best = t;
+						hit.index = i;
+						hit.distance = t;
+					}
+				}
+			}
+		}
+		float exit = std::min(nextX, nextY);
+		// anything hit before leaving this cell cannot be beaten further on
+		if (exit >= best) {
+			break;
+		}
+		if (nextX < nextY) {
+			x += stepX;
+			nextX += deltaX;
+		}
+		else {
+			y += stepY;
+			nextY += deltaY;
+		}
+	}
+	return hit.index >= 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "Vector2.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#define SPATIAL_GRID_CELL_SIZE 32.0f
+// cell coordinates are clamped to this range
+#define SPATIAL_GRID_MAX_CELL 1000000
+
+struct CircleQuery {
+	Vector2 center;
+	float radius;
+};
+
+struct AabbQuery {
+	Vector2 min;
+	Vector2 max;
+};
+
+struct Ray {
+	Vector2 origin;
+	// must be normalized
+	Vector2 direction;
+	// must be finite, the grid itself is unbounded
+	float maxDistance;
+};
+
+struct RayHit {
+	// -1 if the ray hit nothing
+	int index = -1;
+	float distance = 0;
+};
+
+// Results of a batch of queries, stored flat. The hits of query q are
+// indices[offsets[q]] up to indices[offsets[q + 1]].
+struct QueryResults {
+	std::vector<int> offsets;
+	std::vector<int> indices;
+	void clear();
+	int getCount(int query) const;
+	const int* begin(int query) const;
+	const int* end(int query) const;
+};
+
+// Uniform hash grid over circle centers. Bodies are identified by the index
+// they were inserted with. Calling move() every frame only touches the cell
+// buckets of bodies that actually changed cell. Queries are const and may run
+// concurrently once the frame's moves are done.
+class SpatialGrid {
+public:
+	SpatialGrid(float cellSize = SPATIAL_GRID_CELL_SIZE);
+	void insert(int index, Vector2 pos, float radius);
+	void move(int index, Vector2 pos, float radius);
+	void remove(int index);
+	void clear();
+	float getCellSize() const;
+	int getCellChanges() const;
+	void resetCellChanges();
+	void queryCircle(Vector2 center, float radius, std::vector<int>& out) const;
+	void queryAabb(Vector2 min, Vector2 max, std::vector<int>& out) const;
+	void queryNearest(Vector2 point, int k, std::vector<int>& out) const;
+	bool raycast(const Ray& ray, RayHit& hit) const;
+private:
+	// the cell is not stored, it is recomputed from pos; slot is -1 for
+	// bodies that are not in the grid
+	struct Body {
+		Vector2 pos;
+		float radius;
+		int slot;
+	};
+	int cellCoord(float v) const;
+	static int64_t cellKey(int x, int y);
+	int64_t cellOf(Vector2 pos) const;
+	void addToCell(int index, int64_t cell);
+	void removeFromCell(int index);
+	template <typename Visit>
+	void forEachCell(int x0, int x1, int y0, int y1, Visit visit) const;
+
+	float _cellSize;
+	float _maxRadius = 0;
+	int _count = 0;
+	int _cellChanges = 0;
+	// every cell a body went into since the last clear() lies inside these,
+	// they never shrink
+	int _minCellX = SPATIAL_GRID_MAX_CELL;
+	int _maxCellX = -SPATIAL_GRID_MAX_CELL;
+	int _minCellY = SPATIAL_GRID_MAX_CELL;
+	int _maxCellY = -SPATIAL_GRID_MAX_CELL;
+	std::vector<Body> _bodies;
+	std::unordered_map<int64_t, std::vector<int>> _cells;
+};
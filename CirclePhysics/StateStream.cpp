@@ -0,0 +1,391 @@
+#include "StateStream.h"
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// the largest varint a 32 bit value takes, four per body
+#define STATE_STREAM_MAX_BODY_BYTES 20
+#define STATE_STREAM_SOCKET_BUFFER (4 * 1024 * 1024)
+
+static void writeVarint(std::vector<char>& out, int32_t value) {
+	uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+	while (v >= 0x80) {
+		out.push_back((char)(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back((char)v);
+}
+
+static bool readVarint(const char*& p, const char* end, int32_t& value) {
+	uint32_t v = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (p == end) {
+			return false;
+		}
+		uint8_t byte = (uint8_t)*p++;
+		v |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			value = (int32_t)((v >> 1) ^ (0u - (v & 1)));
+			return true;
+		}
+	}
+	return false;
+}
+
+// deltas wrap instead of overflowing, the receiving end wraps back
+static int32_t delta(int32_t value, int32_t base) {
+	return (int32_t)((uint32_t)value - (uint32_t)base);
+}
+
+static int32_t undelta(int32_t d, int32_t base) {
+	return (int32_t)((uint32_t)base + (uint32_t)d);
+}
+
+static int32_t quantizeValue(float f) {
+	return (int32_t)std::lround(f * STATE_STREAM_SCALE);
+}
+
+static void loopback(sockaddr_in& address, int port) {
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons((uint16_t)port);
+}
+
+StatePublisher::StatePublisher() {
+	for (uint32_t& f : _historyFrames) {
+		f = STATE_STREAM_NO_FRAME;
+	}
+}
+
+StatePublisher::~StatePublisher() {
+	close();
+}
+
+bool StatePublisher::open(int port) {
+	close();
+	_socket = socket(AF_INET, SOCK_DGRAM, 0);
+	if (_socket < 0) {
+		return false;
+	}
+	int buffer = STATE_STREAM_SOCKET_BUFFER;
+	setsockopt(_socket, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+	sockaddr_in address;
+	loopback(address, port);
+	socklen_t length = sizeof(address);
+	if (bind(_socket, (sockaddr*)&address, sizeof(address)) != 0 || getsockname(_socket, (sockaddr*)&address, &length) != 0) {
+		close();
+		return false;
+	}
+	_port = ntohs(address.sin_port);
+	return true;
+}
+
+void StatePublisher::close() {
+	if (_socket >= 0) {
+		::close(_socket);
+		_socket = -1;
+	}
+	_observers.clear();
+}
+
+int StatePublisher::getPort() const {
+	return _port;
+}
+
+uint32_t StatePublisher::getFrame() const {
+	return _frame;
+}
+
+const PublishStats& StatePublisher::getStats() const {
+	return _stats;
+}
+
+StreamBody StatePublisher::quantize(const Collider& c) {
+	return StreamBody{ quantizeValue(c.getPos().X), quantizeValue(c.getPos().Y),
+		quantizeValue(c.getVelocity().X), quantizeValue(c.getVelocity().Y) };
+}
+
+void StatePublisher::readAcks() {
+	while (true) {
+		StateAck ack;
+		sockaddr_in from;
+		socklen_t length = sizeof(from);
+		ssize_t n = recvfrom(_socket, &ack, sizeof(ack), MSG_DONTWAIT, (sockaddr*)&from, &length);
+		if (n < 0) {
+			return;
+		}
+		if (n != sizeof(ack) || ack.magic != STATE_STREAM_MAGIC) {
+			continue;
+		}
+		Observer* o = nullptr;
+		for (Observer& candidate : _observers) {
+			if (candidate.address == from.sin_addr.s_addr && candidate.port == from.sin_port) {
+				o = &candidate;
+			}
+		}
+		if (o == nullptr) {
+			_observers.push_back(Observer{ from.sin_addr.s_addr, from.sin_port, STATE_STREAM_NO_FRAME, _frame });
+			o = &_observers.back();
+		}
+		o->heard = _frame;
+		// acks can arrive out of order, only a newer one moves the baseline
+		if (ack.frame == STATE_STREAM_NO_FRAME) {
+			o->acked = STATE_STREAM_NO_FRAME;
+		}
+		else if (ack.frame <= _frame && (o->acked == STATE_STREAM_NO_FRAME || ack.frame > o->acked)) {
+			o->acked = ack.frame;
+		}
+	}
+}
+
+void StatePublisher::publish(const std::vector<Entity*>& entities) {
+	if (_socket < 0) {
+		return;
+	}
+	readAcks();
+	_frame++;
+	int slot = _frame % STATE_STREAM_HISTORY;
+	std::vector<StreamBody>& current = _history[slot];
+	current.resize(entities.size());
+	for (int i = 0; i < entities.size(); i++) {
+		current[i] = quantize(*entities[i]->getCollider());
+	}
+	_historyFrames[slot] = _frame;
+
+	for (int i = (int)_observers.size() - 1; i >= 0; i--) {
+		if (_frame - _observers[i].heard > STATE_STREAM_TIMEOUT) {
+			_observers.erase(_observers.begin() + i);
+		}
+	}
+
+	_stats.observers = (int)_observers.size();
+	_stats.frames++;
+	_stats.packets = 0;
+	_stats.bytes = 0;
+	_stats.keyframeBytes = 0;
+	_stats.deltaBytes = 0;
+	_stats.keyframes = 0;
+	_stats.deltas = 0;
+	std::map<uint32_t, std::vector<std::vector<char>>> encoded;
+	for (const Observer& o : _observers) {
+		uint32_t baseline = o.acked;
+		if (baseline != STATE_STREAM_NO_FRAME && (_frame - baseline >= STATE_STREAM_HISTORY || _historyFrames[baseline % STATE_STREAM_HISTORY] != baseline)) {
+			baseline = STATE_STREAM_NO_FRAME;
+		}
+		auto it = encoded.find(baseline);
+		if (it == encoded.end()) {
+			it = encoded.emplace(baseline, std::vector<std::vector<char>>()).first;
+			encode(baseline, it->second);
+		}
+		sockaddr_in to;
+		memset(&to, 0, sizeof(to));
+		to.sin_family = AF_INET;
+		to.sin_addr.s_addr = o.address;
+		to.sin_port = o.port;
+		long long bytes = 0;
+		for (const std::vector<char>& packet : it->second) {
+			if (sendto(_socket, packet.data(), packet.size(), 0, (sockaddr*)&to, sizeof(to)) == (ssize_t)packet.size()) {
+				bytes += packet.size();
+				_stats.packets++;
+			}
+		}
+		_stats.bytes += bytes;
+		if (baseline == STATE_STREAM_NO_FRAME) {
+			_stats.keyframes++;
+			_stats.keyframeBytes += bytes;
+		}
+		else {
+			_stats.deltas++;
+			_stats.deltaBytes += bytes;
+		}
+	}
+}
+
+void StatePublisher::encode(uint32_t baseline, std::vector<std::vector<char>>& packets) const {
+	const std::vector<StreamBody>& current = _history[_frame % STATE_STREAM_HISTORY];
+	const std::vector<StreamBody>* base = baseline == STATE_STREAM_NO_FRAME ? nullptr : &_history[baseline % STATE_STREAM_HISTORY];
+	StatePacketHeader header = { STATE_STREAM_MAGIC, _frame, baseline, (uint32_t)current.size(), 0, 0 };
+	std::vector<char> packet;
+	uint32_t i = 0;
+	// an empty frame still goes out as one datagram so observers see it
+	do {
+		header.first = i;
+		packet.assign(sizeof(header), 0);
+		while (i < current.size() && packet.size() + STATE_STREAM_MAX_BODY_BYTES <= sizeof(header) + STATE_STREAM_PACKET) {
+			StreamBody b = base != nullptr && i < base->size() ? (*base)[i] : StreamBody();
+			writeVarint(packet, delta(current[i].x, b.x));
+			writeVarint(packet, delta(current[i].y, b.y));
+			writeVarint(packet, delta(current[i].vx, b.vx));
+			writeVarint(packet, delta(current[i].vy, b.vy));
+			i++;
+		}
+		header.count = i - header.first;
+		memcpy(packet.data(), &header, sizeof(header));
+		packets.push_back(packet);
+	} while (i < current.size());
+}
+
+StateObserver::StateObserver() {
+	for (uint32_t& f : _historyFrames) {
+		f = STATE_STREAM_NO_FRAME;
+	}
+}
+
+StateObserver::~StateObserver() {
+	close();
+}
+
+bool StateObserver::connect(int port) {
+	close();
+	_socket = socket(AF_INET, SOCK_DGRAM, 0);
+	if (_socket < 0) {
+		return false;
+	}
+	// a keyframe of a large world arrives as one burst
+	int buffer = STATE_STREAM_SOCKET_BUFFER;
+	setsockopt(_socket, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+	sockaddr_in address;
+	loopback(address, 0);
+	if (bind(_socket, (sockaddr*)&address, sizeof(address)) != 0) {
+		close();
+		return false;
+	}
+	loopback(address, port);
+	if (::connect(_socket, (sockaddr*)&address, sizeof(address)) != 0) {
+		close();
+		return false;
+	}
+	sendAck(STATE_STREAM_NO_FRAME);
+	return true;
+}
+
+void StateObserver::close() {
+	if (_socket >= 0) {
+		::close(_socket);
+		_socket = -1;
+	}
+}
+
+void StateObserver::sendAck(uint32_t frame) {
+	StateAck ack = { STATE_STREAM_MAGIC, frame };
+	send(_socket, &ack, sizeof(ack), 0);
+}
+
+bool StateObserver::receive(int timeoutMilliseconds) {
+	if (_socket < 0) {
+		return false;
+	}
+	// the subscription may have been lost, ask again until something arrives
+	if (_frame == 0 && _building == 0) {
+		sendAck(STATE_STREAM_NO_FRAME);
+	}
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+	char buffer[65536];
+	while (true) {
+		ssize_t n;
+		while ((n = recv(_socket, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+			_stats.bytes += n;
+			if (handle(buffer, n)) {
+				return true;
+			}
+		}
+		int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+		if (remaining <= 0) {
+			return false;
+		}
+		pollfd p = { _socket, POLLIN, 0 };
+		poll(&p, 1, remaining);
+	}
+}
+
+bool StateObserver::handle(const char* data, size_t size) {
+	StatePacketHeader header;
+	if (size < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != STATE_STREAM_MAGIC || header.frame <= _frame || header.frame < _building ||
+		header.first > header.bodies || header.count > header.bodies - header.first) {
+		return false;
+	}
+	const std::vector<StreamBody>* base = nullptr;
+	if (header.baseline != STATE_STREAM_NO_FRAME) {
+		int slot = header.baseline % STATE_STREAM_HISTORY;
+		if (_historyFrames[slot] != header.baseline) {
+			_stats.lostBaselines++;
+			_building = 0;
+			sendAck(STATE_STREAM_NO_FRAME);
+			return false;
+		}
+		base = &_history[slot];
+	}
+	if (header.frame != _building) {
+		if (_building != 0) {
+			_stats.incomplete++;
+		}
+		_building = header.frame;
+		_bodies.assign(header.bodies, StreamBody());
+		_have.assign(header.bodies, 0);
+		_missing = header.bodies;
+	}
+
+	const char* p = data + sizeof(header);
+	const char* end = data + size;
+	for (uint32_t i = header.first; i < header.first + header.count; i++) {
+		StreamBody b = base != nullptr && i < base->size() ? (*base)[i] : StreamBody();
+		int32_t d[4];
+		for (int32_t& v : d) {
+			if (!readVarint(p, end, v)) {
+				return false;
+			}
+		}
+		_bodies[i] = StreamBody{ undelta(d[0], b.x), undelta(d[1], b.y), undelta(d[2], b.vx), undelta(d[3], b.vy) };
+		if (!_have[i]) {
+			_have[i] = 1;
+			_missing--;
+		}
+	}
+	if (_missing > 0) {
+		return false;
+	}
+
+	int slot = header.frame % STATE_STREAM_HISTORY;
+	_history[slot] = _bodies;
+	_historyFrames[slot] = header.frame;
+	_frame = header.frame;
+	_building = 0;
+	_stats.frames++;
+	sendAck(_frame);
+	_positions.resize(_bodies.size());
+	_velocities.resize(_bodies.size());
+	for (int i = 0; i < _bodies.size(); i++) {
+		_positions[i] = Vector2{ (float)_bodies[i].x / STATE_STREAM_SCALE, (float)_bodies[i].y / STATE_STREAM_SCALE };
+		_velocities[i] = Vector2{ (float)_bodies[i].vx / STATE_STREAM_SCALE, (float)_bodies[i].vy / STATE_STREAM_SCALE };
+	}
+	return true;
+}
+
+uint32_t StateObserver::getFrame() const {
+	return _frame;
+}
+
+const std::vector<Vector2>& StateObserver::getPositions() const {
+	return _positions;
+}
+
+const std::vector<Vector2>& StateObserver::getVelocities() const {
+	return _velocities;
+}
+
+const ObserveStats& StateObserver::getStats() const {
+	return _stats;
+}
+#endif
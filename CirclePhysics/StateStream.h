@@ -0,0 +1,140 @@
+#pragma once
+// Streams simulation state to observers over UDP, POSIX only (BSD sockets)
+#include "Entity.h"
+#include <cstdint>
+#include <vector>
+
+#define STATE_STREAM_MAGIC 0x53504343u
+// positions and velocities are sent in steps of 1 / STATE_STREAM_SCALE
+#define STATE_STREAM_SCALE 64
+// frames kept on both ends to decode against, an ack older than this is
+// answered with a keyframe
+#define STATE_STREAM_HISTORY 32
+// bytes of body data per datagram, small enough not to be fragmented
+#define STATE_STREAM_PACKET 1200
+// observers that have not acked for this many frames are dropped
+#define STATE_STREAM_TIMEOUT 600
+#define STATE_STREAM_NO_FRAME 0xFFFFFFFFu
+
+// One body quantized, what both ends keep per frame
+struct StreamBody {
+	int32_t x;
+	int32_t y;
+	int32_t vx;
+	int32_t vy;
+};
+
+// Starts every datagram. A frame is split over as many datagrams as it needs,
+// each covering bodies [first, first + count) and decodable on its own
+struct StatePacketHeader {
+	uint32_t magic;
+	uint32_t frame;
+	// frame the values are deltas against, STATE_STREAM_NO_FRAME for a keyframe
+	uint32_t baseline;
+	uint32_t bodies;
+	uint32_t first;
+	uint32_t count;
+};
+
+// Sent back by an observer for every frame it rebuilt. STATE_STREAM_NO_FRAME
+// subscribes, or asks for a keyframe when the observer lost its baseline
+struct StateAck {
+	uint32_t magic;
+	uint32_t frame;
+};
+
+struct PublishStats {
+	int observers = 0;
+	int frames = 0;
+	// datagrams and bytes sent for the last frame, over every observer
+	int packets = 0;
+	long long bytes = 0;
+	long long keyframeBytes = 0;
+	long long deltaBytes = 0;
+	int keyframes = 0;
+	int deltas = 0;
+};
+
+// Sends every frame's positions and velocities to any number of observers.
+// Values are quantized and each observer gets them as deltas against the last
+// frame it acknowledged, zigzag varint encoded, so slow or still bodies cost a
+// byte per field. Observers that acked nothing yet, or whose last ack fell out
+// of the history, get a keyframe. Observers sharing a baseline share the
+// encoded datagrams. Acks are read without blocking at the start of publish().
+class StatePublisher {
+public:
+	StatePublisher();
+	~StatePublisher();
+	StatePublisher(const StatePublisher&) = delete;
+	StatePublisher& operator=(const StatePublisher&) = delete;
+	// Binds to the loopback address, port 0 picks a free one
+	bool open(int port);
+	void close();
+	int getPort() const;
+	void publish(const std::vector<Entity*>& entities);
+	uint32_t getFrame() const;
+	const PublishStats& getStats() const;
+	static StreamBody quantize(const Collider& c);
+private:
+	struct Observer {
+		uint32_t address;
+		uint16_t port;
+		uint32_t acked;
+		uint32_t heard;
+	};
+	void readAcks();
+	void encode(uint32_t baseline, std::vector<std::vector<char>>& packets) const;
+
+	int _socket = -1;
+	int _port = 0;
+	uint32_t _frame = 0;
+	std::vector<StreamBody> _history[STATE_STREAM_HISTORY];
+	uint32_t _historyFrames[STATE_STREAM_HISTORY];
+	std::vector<Observer> _observers;
+	PublishStats _stats;
+};
+
+struct ObserveStats {
+	int frames = 0;
+	// frames given up because a newer one started before they were complete
+	int incomplete = 0;
+	// datagrams whose baseline was no longer held, answered with a keyframe request
+	int lostBaselines = 0;
+	long long bytes = 0;
+};
+
+// Reference client: subscribes to a StatePublisher and rebuilds the state,
+// exact to the quantization step
+class StateObserver {
+public:
+	StateObserver();
+	~StateObserver();
+	StateObserver(const StateObserver&) = delete;
+	StateObserver& operator=(const StateObserver&) = delete;
+	bool connect(int port);
+	void close();
+	// Reads datagrams for up to timeout milliseconds, returns true as soon as a
+	// frame newer than the last one is complete
+	bool receive(int timeoutMilliseconds);
+	// 0 until the first frame arrives
+	uint32_t getFrame() const;
+	const std::vector<Vector2>& getPositions() const;
+	const std::vector<Vector2>& getVelocities() const;
+	const ObserveStats& getStats() const;
+private:
+	bool handle(const char* data, size_t size);
+	void sendAck(uint32_t frame);
+
+	int _socket = -1;
+	uint32_t _frame = 0;
+	std::vector<StreamBody> _history[STATE_STREAM_HISTORY];
+	uint32_t _historyFrames[STATE_STREAM_HISTORY];
+	// the frame being put together
+	uint32_t _building = 0;
+	std::vector<StreamBody> _bodies;
+	std::vector<char> _have;
+	uint32_t _missing = 0;
+	std::vector<Vector2> _positions;
+	std::vector<Vector2> _velocities;
+	ObserveStats _stats;
+};
@@ -0,0 +1,300 @@
+#include "StaticGeometry.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+static Vector2 shapeMin(const GeometryShape& s) {
+	if (s.shape == GEOMETRY_CIRCLE) {
+		return s.a - s.radius;
+	}
+	return Vector2{ std::min(s.a.X, s.b.X), std::min(s.a.Y, s.b.Y) };
+}
+
+static Vector2 shapeMax(const GeometryShape& s) {
+	if (s.shape == GEOMETRY_CIRCLE) {
+		return s.a + s.radius;
+	}
+	return Vector2{ std::max(s.a.X, s.b.X), std::max(s.a.Y, s.b.Y) };
+}
+
+static Vector2 shapeCenter(const GeometryShape& s) {
+	return s.shape == GEOMETRY_CIRCLE ? s.a : (s.a + s.b) * 0.5f;
+}
+
+// Closest point of the shape's outline to p, and how far the circle's edge
+// has to stay from it
+static Vector2 closestPoint(const GeometryShape& s, Vector2 p, float& clearance) {
+	if (s.shape == GEOMETRY_CIRCLE) {
+		clearance = s.radius;
+		return s.a;
+	}
+	clearance = 0;
+	Vector2 ab = s.b - s.a;
+	float lengthSquared = dot(ab, ab);
+	float t = lengthSquared > 0 ? dot(p - s.a, ab) / lengthSquared : 0;
+	t = std::min(std::max(t, 0.0f), 1.0f);
+	return s.a + ab * t;
+}
+
+// Where a circle moving from from to to first touches a point it starts clear
+// of, as a fraction of the move
+static void sweepPoint(Vector2 from, Vector2 to, Vector2 point, float reach, float& t, Vector2& normal) {
+	Vector2 d = to - from;
+	Vector2 m = from - point;
+	float b = dot(m, d);
+	float c = dot(m, m) - reach * reach;
+	float a = dot(d, d);
+	if (c <= 0 || b >= 0 || a == 0) {
+		return;
+	}
+	float discriminant = b * b - a * c;
+	if (discriminant < 0) {
+		return;
+	}
+	float hit = (-b - std::sqrt(discriminant)) / a;
+	if (hit < t) {
+		t = hit;
+		normal = (from + d * hit - point) / reach;
+	}
+}
+
+// The first time the moving circle touches the shape, t stays above 1 if
+// the move never does
+static void sweepShape(const GeometryShape& s, Vector2 from, Vector2 to, float radius, float& t, Vector2& normal) {
+	if (s.shape == GEOMETRY_CIRCLE) {
+		sweepPoint(from, to, s.a, radius + s.radius, t, normal);
+		return;
+	}
+	sweepPoint(from, to, s.a, radius, t, normal);
+	sweepPoint(from, to, s.b, radius, t, normal);
+	Vector2 ab = s.b - s.a;
+	float length = getLength(ab);
+	if (length == 0) {
+		return;
+	}
+	// the side of the segment the circle starts on
+	Vector2 side = Vector2{ -ab.Y, ab.X } / length;
+	float distance = dot(from - s.a, side);
+	if (distance < 0) {
+		side = side * -1.0f;
+		distance = -distance;
+	}
+	float approach = dot(to - from, side);
+	if (distance < radius || approach >= 0) {
+		return;
+	}
+	float hit = (radius - distance) / approach;
+	float along = dot(from + (to - from) * hit - s.a, ab) / (length * length);
+	if (hit < t && along >= 0 && along <= 1) {
+		t = hit;
+		normal = side;
+	}
+}
+
+StaticGeometry::StaticGeometry() {}
+
+StaticGeometry::StaticGeometry(std::vector<GeometryShape> shapes) : _shapes(std::move(shapes)) {
+	_stats.shapes = (int)_shapes.size();
+	if (!_shapes.empty()) {
+		_nodes.reserve(2 * _shapes.size() / GEOMETRY_LEAF_SIZE + 1);
+		build(0, (int)_shapes.size(), 1);
+	}
+	for (const GeometryShape& s : _shapes) {
+		Vector2 lo = shapeMin(s);
+		Vector2 hi = shapeMax(s);
+		_minX.push_back(lo.X);
+		_minY.push_back(lo.Y);
+		_maxX.push_back(hi.X);
+		_maxY.push_back(hi.Y);
+	}
+	_stats.nodes = (int)_nodes.size();
+}
+
+StaticGeometry StaticGeometry::fromFile(const std::string& path) {
+	std::ifstream in{ path, std::ios::in };
+	if (!in.is_open()) {
+		throw "Geometry file could not be opened.";
+	}
+	std::vector<GeometryShape> shapes;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::stringstream fields(line);
+		std::string kind;
+		std::getline(fields, kind, ',');
+		std::vector<float> values;
+		std::string value;
+		while (std::getline(fields, value, ',')) {
+			values.push_back(std::stof(value));
+		}
+		if (kind == "circle" && values.size() == 3) {
+			shapes.push_back(GeometryShape{ GEOMETRY_CIRCLE, Vector2{ values[0], values[1] }, Vector2(), values[2] });
+		}
+		else if ((kind == "segment" && values.size() == 4) || (kind == "polyline" && values.size() >= 4 && values.size() % 2 == 0)) {
+			for (int i = 2; i + 1 < values.size(); i += 2) {
+				shapes.push_back(GeometryShape{ GEOMETRY_SEGMENT, Vector2{ values[i - 2], values[i - 1] }, Vector2{ values[i], values[i + 1] }, 0 });
+			}
+		}
+		else {
+			throw "Geometry line is not a segment, polyline or circle.";
+		}
+	}
+	return StaticGeometry(std::move(shapes));
+}
+
+int StaticGeometry::build(int first, int count, int depth) {
+	int node = (int)_nodes.size();
+	_nodes.push_back(GeometryNode{ shapeMin(_shapes[first]), shapeMax(_shapes[first]), first, count });
+	Vector2 centerMin = shapeCenter(_shapes[first]);
+	Vector2 centerMax = centerMin;
+	for (int i = first; i < first + count; i++) {
+		Vector2 lo = shapeMin(_shapes[i]);
+		Vector2 hi = shapeMax(_shapes[i]);
+		Vector2 c = shapeCenter(_shapes[i]);
+		_nodes[node].min = Vector2{ std::min(_nodes[node].min.X, lo.X), std::min(_nodes[node].min.Y, lo.Y) };
+		_nodes[node].max = Vector2{ std::max(_nodes[node].max.X, hi.X), std::max(_nodes[node].max.Y, hi.Y) };
+		centerMin = Vector2{ std::min(centerMin.X, c.X), std::min(centerMin.Y, c.Y) };
+		centerMax = Vector2{ std::max(centerMax.X, c.X), std::max(centerMax.Y, c.Y) };
+	}
+	_stats.depth = std::max(_stats.depth, depth);
+	if (count <= GEOMETRY_LEAF_SIZE || depth >= GEOMETRY_MAX_DEPTH) {
+		return node;
+	}
+
+	// split at the median center along the wider axis of the centers
+	bool alongX = centerMax.X - centerMin.X >= centerMax.Y - centerMin.Y;
+	int half = count / 2;
+	std::nth_element(_shapes.begin() + first, _shapes.begin() + first + half, _shapes.begin() + first + count,
+		[alongX](const GeometryShape& s1, const GeometryShape& s2) {
+			return alongX ? shapeCenter(s1).X < shapeCenter(s2).X : shapeCenter(s1).Y < shapeCenter(s2).Y;
+		});
+	build(first, half, depth + 1);
+	int right = build(first + half, count - half, depth + 1);
+	_nodes[node].index = right;
+	_nodes[node].count = 0;
+	return node;
+}
+
+bool StaticGeometry::empty() const {
+	return _shapes.empty();
+}
+
+const std::vector<GeometryShape>& StaticGeometry::getShapes() const {
+	return _shapes;
+}
+
+const std::vector<GeometryNode>& StaticGeometry::getNodes() const {
+	return _nodes;
+}
+
+const GeometryStats& StaticGeometry::getStats() const {
+	return _stats;
+}
+
+bool StaticGeometry::collide(Vector2 from, Vector2& pos, Vector2& vel, float radius) const {
+	if (_nodes.empty()) {
+		return false;
+	}
+	bool hit = false;
+	// the box around the whole move, from the position as it is now after
+	// earlier stops and pushes
+	Vector2 lo = Vector2{ std::min(from.X, pos.X), std::min(from.Y, pos.Y) } - radius;
+	Vector2 hi = Vector2{ std::max(from.X, pos.X), std::max(from.Y, pos.Y) } + radius;
+	int stack[GEOMETRY_MAX_DEPTH + 1];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		int node = stack[--top];
+		const GeometryNode& n = _nodes[node];
+		if (hi.X < n.min.X || lo.X > n.max.X || hi.Y < n.min.Y || lo.Y > n.max.Y) {
+			continue;
+		}
+		if (n.count == 0) {
+			stack[top++] = n.index;
+			stack[top++] = node + 1;
+			continue;
+		}
+		for (int i = n.index; i < n.index + n.count; i++) {
+			// most shapes in a leaf are out of reach, skip them on the box
+			if (hi.X < _minX[i] || lo.X > _maxX[i] || hi.Y < _minY[i] || lo.Y > _maxY[i]) {
+				continue;
+			}
+			float t = 2;
+			Vector2 normal;
+			sweepShape(_shapes[i], from, pos, radius, t, normal);
+			if (t <= 1) {
+				// crossed into the shape on the way: stop where it first touched
+				pos = from + (pos - from) * t;
+			}
+			else {
+				float clearance;
+				Vector2 q = closestPoint(_shapes[i], pos, clearance);
+				Vector2 d = pos - q;
+				float reach = radius + clearance;
+				if (dot(d, d) >= reach * reach) {
+					continue;
+				}
+				float distance = getLength(d);
+				if (distance > 0) {
+					normal = d / distance;
+				}
+				else if (_shapes[i].shape == GEOMETRY_SEGMENT) {
+					// dead on the line, leave against the way the body is going
+					Vector2 ab = _shapes[i].b - _shapes[i].a;
+					normal = Vector2{ -ab.Y, ab.X } / std::max(getLength(ab), 1e-6f);
+					if (dot(normal, vel) > 0) {
+						normal = normal * -1.0f;
+					}
+				}
+				else {
+					normal = Vector2{ 0, -1 };
+				}
+				pos = q + normal * reach;
+			}
+			lo = Vector2{ std::min(from.X, pos.X), std::min(from.Y, pos.Y) } - radius;
+			hi = Vector2{ std::max(from.X, pos.X), std::max(from.Y, pos.Y) } + radius;
+			float along = dot(vel, normal);
+			if (along < 0) {
+				vel -= normal * (2 * along);
+				hit = true;
+			}
+		}
+	}
+	return hit;
+}
+
+bool StaticGeometry::overlaps(Vector2 pos, float radius) const {
+	if (_nodes.empty()) {
+		return false;
+	}
+	int stack[GEOMETRY_MAX_DEPTH + 1];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		int node = stack[--top];
+		const GeometryNode& n = _nodes[node];
+		if (pos.X + radius < n.min.X || pos.X - radius > n.max.X || pos.Y + radius < n.min.Y || pos.Y - radius > n.max.Y) {
+			continue;
+		}
+		if (n.count == 0) {
+			stack[top++] = n.index;
+			stack[top++] = node + 1;
+			continue;
+		}
+		for (int i = n.index; i < n.index + n.count; i++) {
+			float clearance;
+			Vector2 q = closestPoint(_shapes[i], pos, clearance);
+			Vector2 d = pos - q;
+			if (dot(d, d) < (radius + clearance) * (radius + clearance)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "Vector2.h"
+#include <string>
+#include <vector>
+
+// primitives per BVH leaf
+#define GEOMETRY_LEAF_SIZE 4
+// deepest BVH the traversal stack has room for
+#define GEOMETRY_MAX_DEPTH 64
+
+enum geometryShape {
+	GEOMETRY_SEGMENT = 0,
+	GEOMETRY_CIRCLE = 1
+};
+
+// A segment from a to b, or a circle around a with radius
+struct GeometryShape {
+	int shape;
+	Vector2 a;
+	Vector2 b;
+	float radius;
+};
+
+struct GeometryNode {
+	Vector2 min;
+	Vector2 max;
+	// leaves: first primitive and count; inner nodes: right child, count 0,
+	// the left child is the next node
+	int index;
+	int count;
+};
+
+struct GeometryStats {
+	int shapes = 0;
+	int nodes = 0;
+	int depth = 0;
+};
+
+// Level geometry that never moves: line segments (polylines are stored as
+// their segments) and static circles. A bounding volume hierarchy over them is
+// built once when the geometry is made and never changes, so a body away from
+// all geometry costs one box test against the root. Bodies bounce off it the
+// way they bounce off the world's walls. The path a body moved along in the
+// step is tested too, so a fast body cannot pass through a thin segment.
+//
+// Files have one shape per line, comma separated:
+//   segment,x1,y1,x2,y2
+//   polyline,x1,y1,x2,y2,x3,y3,...
+//   circle,x,y,radius
+class StaticGeometry {
+public:
+	StaticGeometry();
+	StaticGeometry(std::vector<GeometryShape> shapes);
+	static StaticGeometry fromFile(const std::string& path);
+	bool empty() const;
+	const std::vector<GeometryShape>& getShapes() const;
+	const std::vector<GeometryNode>& getNodes() const;
+	// For a circle that moved from from to pos: stops it where its path first
+	// meets a shape it started clear of, pushes it out of every shape it
+	// overlaps and mirrors its velocity off the ones it moves into. Returns
+	// true if it hit any
+	bool collide(Vector2 from, Vector2& pos, Vector2& vel, float radius) const;
+	// True if a circle there would touch any shape, for placing bodies
+	bool overlaps(Vector2 pos, float radius) const;
+	const GeometryStats& getStats() const;
+private:
+	int build(int first, int count, int depth);
+
+	std::vector<GeometryShape> _shapes;
+	// the shapes' boxes side by side, so a leaf rejects the shapes out of
+	// reach without loading them
+	std::vector<float> _minX;
+	std::vector<float> _minY;
+	std::vector<float> _maxX;
+	std::vector<float> _maxY;
+	std::vector<GeometryNode> _nodes;
+	GeometryStats _stats;
+};
@@ -0,0 +1,216 @@
+#include "StatsSegment.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// a reader gives up after this many torn copies in a row
+#define STATS_READ_ATTEMPTS 1000
+
+static int frameBin(double milliseconds) {
+	double microseconds = milliseconds * 1000;
+	if (microseconds < 1) {
+		return 0;
+	}
+	int bin = (int)(std::log2(microseconds) * STATS_BINS_PER_OCTAVE);
+	return std::min(std::max(bin, 0), STATS_HISTOGRAM_BINS - 1);
+}
+
+#ifdef _WIN32
+static void* mapSegment(const std::string& name, bool create, void*& handle) {
+	std::string local = "Local\\" + name;
+	if (create) {
+		handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(StatsSegmentData), local.c_str());
+	}
+	else {
+		handle = OpenFileMappingA(FILE_MAP_READ, FALSE, local.c_str());
+	}
+	if (handle == NULL) {
+		handle = nullptr;
+		return nullptr;
+	}
+	void* data = MapViewOfFile(handle, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, sizeof(StatsSegmentData));
+	if (data == NULL) {
+		CloseHandle(handle);
+		handle = nullptr;
+		return nullptr;
+	}
+	return data;
+}
+
+static void unmapSegment(const void* data, void* handle, const std::string& name, bool remove) {
+	UnmapViewOfFile(data);
+	CloseHandle(handle);
+}
+#else
+// a POSIX mapping needs no handle besides its address
+static void* mapSegment(const std::string& name, bool create, void*&) {
+	std::string path = "/" + name;
+	int fd = shm_open(path.c_str(), create ? O_CREAT | O_RDWR : O_RDONLY, 0644);
+	if (fd < 0) {
+		return nullptr;
+	}
+	if (create && ftruncate(fd, sizeof(StatsSegmentData)) != 0) {
+		::close(fd);
+		return nullptr;
+	}
+	void* data = mmap(nullptr, sizeof(StatsSegmentData), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping keeps the segment alive on its own
+	::close(fd);
+	return data == MAP_FAILED ? nullptr : data;
+}
+
+static void unmapSegment(const void* data, void*, const std::string& name, bool remove) {
+	munmap((void*)data, sizeof(StatsSegmentData));
+	if (remove) {
+		shm_unlink(("/" + name).c_str());
+	}
+}
+#endif
+
+double LiveStats::getBinMilliseconds(int bin) {
+	return std::pow(2.0, (double)bin / STATS_BINS_PER_OCTAVE) / 1000;
+}
+
+double LiveStats::getPercentile(double fraction) const {
+	uint64_t total = 0;
+	for (uint64_t count : frameHistogram) {
+		total += count;
+	}
+	uint64_t seen = 0;
+	for (int b = 0; b < STATS_HISTOGRAM_BINS; b++) {
+		seen += frameHistogram[b];
+		if (total > 0 && seen >= fraction * total) {
+			return getBinMilliseconds(b + 1);
+		}
+	}
+	return 0;
+}
+
+StatsSegment::StatsSegment() {
+	memset(&_stats, 0, sizeof(_stats));
+	_stats.playerHealth = -1;
+}
+
+StatsSegment::~StatsSegment() {
+	close();
+}
+
+bool StatsSegment::create(const std::string& name) {
+	close();
+	_data = (StatsSegmentData*)mapSegment(name, true, _handle);
+	if (_data == nullptr) {
+		return false;
+	}
+	_name = name;
+	_data->sequence.store(0, std::memory_order_relaxed);
+	memcpy(&_data->stats, &_stats, sizeof(_stats));
+	_data->magic = STATS_SEGMENT_MAGIC;
+	_data->version = STATS_SEGMENT_VERSION;
+	_data->size = sizeof(StatsSegmentData);
+	return true;
+}
+
+void StatsSegment::close() {
+	if (_data != nullptr) {
+		unmapSegment(_data, _handle, _name, true);
+		_data = nullptr;
+		_handle = nullptr;
+	}
+}
+
+template <typename Physics>
+void StatsSegment::recordModel(const BasicModel<Physics>& model, double time) {
+	const PairStats& pairs = model.getPairStats();
+	_stats.frame++;
+	_stats.seconds += time;
+	_stats.bodies = model.getEntityCount();
+	_stats.contacts = pairs.contacts;
+	_stats.wallHits = pairs.wallHits;
+	_stats.totalContacts += pairs.contacts;
+	_stats.totalWallHits += pairs.wallHits;
+	if (time > 0) {
+		double rate = pairs.contacts / time;
+		_stats.contactsPerSecond = _stats.frame == 1 ? rate : _stats.contactsPerSecond + (rate - _stats.contactsPerSecond) * STATS_RATE_SMOOTHING;
+	}
+	const Player* p = model.getPlayer();
+	_stats.playerHealth = p != nullptr ? p->getHealth() : -1;
+	_stats.playerMaxHealth = p != nullptr ? p->getMaxHealth() : -1;
+}
+
+void StatsSegment::recordFrame(double frameMilliseconds, double workMilliseconds, int missedDeadlines) {
+	_stats.frameMilliseconds = frameMilliseconds;
+	_stats.workMilliseconds = workMilliseconds;
+	_stats.missedDeadlines = missedDeadlines;
+	_stats.frameHistogram[frameBin(frameMilliseconds)]++;
+}
+
+void StatsSegment::publish() {
+	if (_data == nullptr) {
+		return;
+	}
+	uint32_t sequence = _data->sequence.load(std::memory_order_relaxed);
+	_data->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&_data->stats, &_stats, sizeof(_stats));
+	_data->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+const LiveStats& StatsSegment::getStats() const {
+	return _stats;
+}
+
+StatsReader::StatsReader() {}
+
+StatsReader::~StatsReader() {
+	close();
+}
+
+bool StatsReader::open(const std::string& name) {
+	close();
+	_data = (const StatsSegmentData*)mapSegment(name, false, _handle);
+	if (_data == nullptr) {
+		return false;
+	}
+	if (_data->magic != STATS_SEGMENT_MAGIC || _data->version != STATS_SEGMENT_VERSION || _data->size != sizeof(StatsSegmentData)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void StatsReader::close() {
+	if (_data != nullptr) {
+		unmapSegment(_data, _handle, "", false);
+		_data = nullptr;
+		_handle = nullptr;
+	}
+}
+
+bool StatsReader::read(LiveStats& stats) const {
+	if (_data == nullptr) {
+		return false;
+	}
+	for (int attempt = 0; attempt < STATS_READ_ATTEMPTS; attempt++) {
+		uint32_t before = _data->sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			continue;
+		}
+		memcpy(&stats, &_data->stats, sizeof(stats));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (_data->sequence.load(std::memory_order_relaxed) == before) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template void StatsSegment::recordModel(const BasicModel<DefaultPhysics>& model, double time);
+template void StatsSegment::recordModel(const BasicModel<ElasticPhysics>& model, double time);
+template void StatsSegment::recordModel(const BasicModel<RuntimePhysics>& model, double time);
@@ -0,0 +1,94 @@
+#pragma once
+// Live counters in a named shared-memory segment, shm_open on POSIX and a
+// file mapping on Windows
+#include "Model.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define STATS_SEGMENT_NAME "circlephysics_stats"
+#define STATS_SEGMENT_MAGIC 0x54535043u
+#define STATS_SEGMENT_VERSION 1
+// frame time histogram, eight bins per doubling of microseconds, the last bin
+// takes everything from about 65 ms up
+#define STATS_HISTOGRAM_BINS 128
+#define STATS_BINS_PER_OCTAVE 8
+// weight of the newest frame in the smoothed contact rate
+#define STATS_RATE_SMOOTHING 0.05
+
+// What a reader sees, plain data so it can be copied in and out of the segment
+struct LiveStats {
+	uint64_t frame;
+	// simulated time
+	double seconds;
+	// from the start of one frame to the next, and the work inside it
+	double frameMilliseconds;
+	double workMilliseconds;
+	int32_t missedDeadlines;
+	int32_t bodies;
+	int32_t contacts;
+	int32_t wallHits;
+	double contactsPerSecond;
+	uint64_t totalContacts;
+	uint64_t totalWallHits;
+	// -1 without a player
+	int32_t playerHealth;
+	int32_t playerMaxHealth;
+	uint64_t frameHistogram[STATS_HISTOGRAM_BINS];
+	// lower edge of a histogram bin in milliseconds
+	static double getBinMilliseconds(int bin);
+	// frame time below which the given fraction of frames fall, from the histogram
+	double getPercentile(double fraction) const;
+};
+
+// Laid out at the start of the segment. sequence is a seqlock: odd while the
+// writer is copying stats in, a reader retries when it saw an odd value or the
+// value changed under it
+struct StatsSegmentData {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	std::atomic<uint32_t> sequence;
+	LiveStats stats;
+};
+
+// Writer side. The model and the game loop fill in their counters each frame
+// and publish() copies them into the segment. Nothing allocates after create(),
+// and the writer never waits for readers.
+class StatsSegment {
+public:
+	StatsSegment();
+	~StatsSegment();
+	StatsSegment(const StatsSegment&) = delete;
+	StatsSegment& operator=(const StatsSegment&) = delete;
+	bool create(const std::string& name = STATS_SEGMENT_NAME);
+	void close();
+	// Body, contact and wall counters of the frame the model just stepped
+	template <typename Physics>
+	void recordModel(const BasicModel<Physics>& model, double time);
+	void recordFrame(double frameMilliseconds, double workMilliseconds, int missedDeadlines);
+	void publish();
+	const LiveStats& getStats() const;
+private:
+	StatsSegmentData* _data = nullptr;
+	std::string _name;
+	void* _handle = nullptr;
+	LiveStats _stats;
+};
+
+// Reader side, for another process
+class StatsReader {
+public:
+	StatsReader();
+	~StatsReader();
+	StatsReader(const StatsReader&) = delete;
+	StatsReader& operator=(const StatsReader&) = delete;
+	bool open(const std::string& name = STATS_SEGMENT_NAME);
+	void close();
+	// A consistent copy of the latest stats, false if the segment is not there
+	// or the writer kept changing it
+	bool read(LiveStats& stats) const;
+private:
+	const StatsSegmentData* _data = nullptr;
+	void* _handle = nullptr;
+};
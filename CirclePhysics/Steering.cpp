@@ -0,0 +1,100 @@
+#include "Steering.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+double SteeringStats::getMsPer100k() const {
+	if (agents == 0) {
+		return 0;
+	}
+	return milliseconds * 100000.0 / agents;
+}
+
+SteeringSettings& SteeringSystem::getSettings() {
+	return _settings;
+}
+
+const SteeringStats& SteeringSystem::getStats() const {
+	return _stats;
+}
+
+void SteeringSystem::compute(const std::vector<int>& agents, const std::vector<char>& isAgent,
+	const std::vector<Vector2>& positions, const std::vector<Vector2>& velocities,
+	const SpatialGrid& grid, Vector2 target, std::vector<Vector2>& accelerations, ThreadPool* pool) {
+	auto start = std::chrono::steady_clock::now();
+	accelerations.resize(agents.size());
+	std::atomic<int> visited(0);
+	if (pool != nullptr) {
+		pool->parallelFor((int)agents.size(), [&](int begin, int end) {
+			int local = 0;
+			computeRange(begin, end, agents, isAgent, positions, velocities, grid, target, accelerations, local);
+			visited += local;
+		});
+	}
+	else {
+		int local = 0;
+		computeRange(0, (int)agents.size(), agents, isAgent, positions, velocities, grid, target, accelerations, local);
+		visited = local;
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	_stats.agents = (int)agents.size();
+	_stats.neighborsVisited = visited;
+	_stats.milliseconds = elapsed.count();
+}
+
+void SteeringSystem::computeRange(int begin, int end, const std::vector<int>& agents, const std::vector<char>& isAgent,
+	const std::vector<Vector2>& positions, const std::vector<Vector2>& velocities,
+	const SpatialGrid& grid, Vector2 target, std::vector<Vector2>& accelerations, int& visited) const {
+	std::vector<int> neighbors;
+	float separationSq = _settings.separationRadius * _settings.separationRadius;
+	for (int a = begin; a < end; a++) {
+		int self = agents[a];
+		Vector2 pos = positions[self];
+		Vector2 vel = velocities[self];
+
+		// seek: steer towards cruising straight at the target
+		Vector2 toTarget = target - pos;
+		float distance = getLength(toTarget);
+		Vector2 seek = Vector2();
+		if (distance > 0) {
+			seek = toTarget * (_settings.cruiseSpeed / distance) - vel;
+		}
+
+		neighbors.clear();
+		grid.queryCircle(pos, _settings.neighborRadius, neighbors);
+		Vector2 separation = Vector2();
+		Vector2 heading = Vector2();
+		int flockmates = 0;
+		int used = 0;
+		for (int n : neighbors) {
+			if (n == self) {
+				continue;
+			}
+			if (used++ >= _settings.maxNeighbors) {
+				break;
+			}
+			Vector2 away = pos - positions[n];
+			float dSq = dot(away, away);
+			// push away from anything close, weighted by inverse distance
+			if (dSq < separationSq && dSq > 0) {
+				separation += away / dSq * _settings.separationRadius;
+			}
+			if (isAgent[n]) {
+				heading += velocities[n];
+				flockmates++;
+			}
+		}
+		visited += used;
+		Vector2 alignment = Vector2();
+		if (flockmates > 0) {
+			alignment = heading / (float)flockmates - vel;
+		}
+
+		Vector2 acc = seek * _settings.seekWeight + separation * _settings.separationWeight + alignment * _settings.alignmentWeight;
+		float length = getLength(acc);
+		if (length > _settings.maxAcceleration) {
+			acc *= _settings.maxAcceleration / length;
+		}
+		accelerations[a] = acc;
+	}
+}
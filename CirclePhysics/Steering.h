@@ -0,0 +1,47 @@
+#pragma once
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+#include <vector>
+
+struct SteeringSettings {
+	bool enabled = false;
+	// collider layers that steer, see LAYER_ENEMY
+	uint32_t layers = 0;
+	float seekWeight = 1.0f;
+	float separationWeight = 1.5f;
+	float alignmentWeight = 0.5f;
+	float neighborRadius = 40.0f;
+	float separationRadius = 20.0f;
+	int maxNeighbors = 16;
+	// speed the seek behavior tries to reach
+	float cruiseSpeed = 40.0f;
+	// cap on the combined acceleration
+	float maxAcceleration = 60.0f;
+};
+
+struct SteeringStats {
+	int agents = 0;
+	int neighborsVisited = 0;
+	double milliseconds = 0;
+	double getMsPer100k() const;
+};
+
+// Seek, separation and alignment for every agent in one data-parallel pass.
+// Works on flat position/velocity arrays indexed like the model's entities
+// and finds neighbors through the model's spatial grid, so the per-agent work
+// does not depend on the total body count.
+class SteeringSystem {
+public:
+	SteeringSettings& getSettings();
+	const SteeringStats& getStats() const;
+	void compute(const std::vector<int>& agents, const std::vector<char>& isAgent,
+		const std::vector<Vector2>& positions, const std::vector<Vector2>& velocities,
+		const SpatialGrid& grid, Vector2 target, std::vector<Vector2>& accelerations, ThreadPool* pool);
+private:
+	void computeRange(int begin, int end, const std::vector<int>& agents, const std::vector<char>& isAgent,
+		const std::vector<Vector2>& positions, const std::vector<Vector2>& velocities,
+		const SpatialGrid& grid, Vector2 target, std::vector<Vector2>& accelerations, int& visited) const;
+
+	SteeringSettings _settings;
+	SteeringStats _stats;
+};
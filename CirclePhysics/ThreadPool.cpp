@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(int threads) {
+	if (threads <= 0) {
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	for (int i = 0; i < threads; i++) {
+		_threads.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	for (std::thread& t : _threads) {
+		t.join();
+	}
+}
+
+int ThreadPool::getThreadCount() const {
+	return (int)_threads.size();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::move(job));
+		_pending++;
+	}
+	_wake.notify_one();
+}
+
+bool ThreadPool::runOne(std::unique_lock<std::mutex>& lock) {
+	if (_jobs.empty()) {
+		return false;
+	}
+	std::function<void()> job = std::move(_jobs.front());
+	_jobs.pop_front();
+	lock.unlock();
+	job();
+	lock.lock();
+	_pending--;
+	if (_pending == 0) {
+		_done.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::work() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+		if (_stopping && _jobs.empty()) {
+			return;
+		}
+		runOne(lock);
+	}
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_pending > 0) {
+		if (!runOne(lock)) {
+			_done.wait(lock);
+		}
+	}
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& body, int minChunk) {
+	if (count <= 0) {
+		return;
+	}
+	int workers = getThreadCount() + 1;
+	int chunk = std::max(minChunk, (count + workers * 4 - 1) / (workers * 4));
+	int chunks = (count + chunk - 1) / chunk;
+	if (chunks == 1) {
+		body(0, count);
+		return;
+	}
+
+	std::atomic<int> next(0);
+	std::atomic<int> running(0);
+	std::mutex doneMutex;
+	std::condition_variable doneCv;
+	auto drain = [&] {
+		int c;
+		while ((c = next++) < chunks) {
+			body(c * chunk, std::min(count, (c + 1) * chunk));
+		}
+	};
+	int helpers = std::min(chunks - 1, getThreadCount());
+	running = helpers;
+	for (int i = 0; i < helpers; i++) {
+		submit([&] {
+			drain();
+			std::lock_guard<std::mutex> lock(doneMutex);
+			if (--running == 0) {
+				doneCv.notify_all();
+			}
+		});
+	}
+	drain();
+
+	// help with other queued work until our helpers have finished
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (running > 0) {
+		if (!runOne(lock)) {
+			lock.unlock();
+			{
+				std::unique_lock<std::mutex> doneLock(doneMutex);
+				doneCv.wait_for(doneLock, std::chrono::milliseconds(1), [&] { return running == 0; });
+			}
+			lock.lock();
+		}
+	}
+	lock.unlock();
+	// the last helper may still be releasing doneMutex
+	std::lock_guard<std::mutex> doneLock(doneMutex);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by the systems that run data-parallel
+// passes. A thread waiting in parallelFor() or wait() runs queued jobs itself
+// instead of blocking, so nested use from inside a job does not deadlock.
+class ThreadPool {
+public:
+	ThreadPool(int threads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	int getThreadCount() const;
+	void submit(std::function<void()> job);
+	void wait();
+	// Calls body(begin, end) over [0, count) split into chunks of at least minChunk
+	void parallelFor(int count, const std::function<void(int, int)>& body, int minChunk = 256);
+private:
+	void work();
+	bool runOne(std::unique_lock<std::mutex>& lock);
+
+	std::vector<std::thread> _threads;
+	std::deque<std::function<void()>> _jobs;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _done;
+	int _pending = 0;
+	bool _stopping = false;
+};
@@ -99,3 +99,6 @@ inline float getLength(Vector2 v) {
     return std::sqrt(v.X * v.X + v.Y * v.Y);
 }
 
+inline float dot(Vector2 v1, Vector2 v2) {
+    return v1.X * v2.X + v1.Y * v2.Y;
+}
\ No newline at end of file
@@ -0,0 +1,254 @@
+#pragma once
+#include "Vector2.h"
+#include <cmath>
+
+// Batches of Vector2 stored as lanes of X and lanes of Y, with the same
+// operators as Vector2 plus lane-wise dot, getLength and normalize. 4 lanes map
+// to SSE, 8 to AVX and 16 to AVX-512 when the compiler targets them; wider
+// batches fall back to pairs of narrower ones, and VECTOR2_BATCH_SCALAR (or a
+// target without SSE2) selects plain loops. Lanes go through the same IEEE
+// operations as the scalar Vector2 code, so they match it except where the
+// compiler fuses scalar multiply-adds.
+#if !defined(VECTOR2_BATCH_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VECTOR2_BATCH_SSE 1
+#include <immintrin.h>
+#if defined(__AVX__)
+#define VECTOR2_BATCH_AVX 1
+#endif
+#if defined(__AVX512F__)
+#define VECTOR2_BATCH_AVX512 1
+#endif
+#endif
+
+// N floats as one value. The general case is two halves.
+template <int N>
+struct FloatBatch {
+	FloatBatch<N / 2> lo, hi;
+
+	static FloatBatch broadcast(float f) {
+		return FloatBatch{ FloatBatch<N / 2>::broadcast(f), FloatBatch<N / 2>::broadcast(f) };
+	}
+	static FloatBatch load(const float* p) {
+		return FloatBatch{ FloatBatch<N / 2>::load(p), FloatBatch<N / 2>::load(p + N / 2) };
+	}
+	void store(float* p) const {
+		lo.store(p);
+		hi.store(p + N / 2);
+	}
+	friend FloatBatch operator+(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ a.lo + b.lo, a.hi + b.hi }; }
+	friend FloatBatch operator-(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ a.lo - b.lo, a.hi - b.hi }; }
+	friend FloatBatch operator*(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ a.lo * b.lo, a.hi * b.hi }; }
+	friend FloatBatch operator/(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ a.lo / b.lo, a.hi / b.hi }; }
+	friend FloatBatch sqrt(const FloatBatch& a) { return FloatBatch{ sqrt(a.lo), sqrt(a.hi) }; }
+};
+
+#if defined(VECTOR2_BATCH_SSE)
+template <>
+struct FloatBatch<4> {
+	__m128 v;
+
+	static FloatBatch broadcast(float f) { return FloatBatch{ _mm_set1_ps(f) }; }
+	static FloatBatch load(const float* p) { return FloatBatch{ _mm_loadu_ps(p) }; }
+	void store(float* p) const { _mm_storeu_ps(p, v); }
+	friend FloatBatch operator+(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm_add_ps(a.v, b.v) }; }
+	friend FloatBatch operator-(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm_sub_ps(a.v, b.v) }; }
+	friend FloatBatch operator*(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm_mul_ps(a.v, b.v) }; }
+	friend FloatBatch operator/(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm_div_ps(a.v, b.v) }; }
+	friend FloatBatch sqrt(const FloatBatch& a) { return FloatBatch{ _mm_sqrt_ps(a.v) }; }
+};
+#else
+template <>
+struct FloatBatch<4> {
+	float v[4];
+
+	static FloatBatch broadcast(float f) { return FloatBatch{ { f, f, f, f } }; }
+	static FloatBatch load(const float* p) { return FloatBatch{ { p[0], p[1], p[2], p[3] } }; }
+	void store(float* p) const {
+		for (int i = 0; i < 4; i++) {
+			p[i] = v[i];
+		}
+	}
+	friend FloatBatch operator+(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+	friend FloatBatch operator-(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+	friend FloatBatch operator*(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+	friend FloatBatch operator/(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } }; }
+	friend FloatBatch sqrt(const FloatBatch& a) { return FloatBatch{ { std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3]) } }; }
+};
+#endif
+
+#if defined(VECTOR2_BATCH_AVX)
+template <>
+struct FloatBatch<8> {
+	__m256 v;
+
+	static FloatBatch broadcast(float f) { return FloatBatch{ _mm256_set1_ps(f) }; }
+	static FloatBatch load(const float* p) { return FloatBatch{ _mm256_loadu_ps(p) }; }
+	void store(float* p) const { _mm256_storeu_ps(p, v); }
+	friend FloatBatch operator+(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm256_add_ps(a.v, b.v) }; }
+	friend FloatBatch operator-(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm256_sub_ps(a.v, b.v) }; }
+	friend FloatBatch operator*(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm256_mul_ps(a.v, b.v) }; }
+	friend FloatBatch operator/(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm256_div_ps(a.v, b.v) }; }
+	friend FloatBatch sqrt(const FloatBatch& a) { return FloatBatch{ _mm256_sqrt_ps(a.v) }; }
+};
+#endif
+
+#if defined(VECTOR2_BATCH_AVX512)
+template <>
+struct FloatBatch<16> {
+	__m512 v;
+
+	static FloatBatch broadcast(float f) { return FloatBatch{ _mm512_set1_ps(f) }; }
+	static FloatBatch load(const float* p) { return FloatBatch{ _mm512_loadu_ps(p) }; }
+	void store(float* p) const { _mm512_storeu_ps(p, v); }
+	friend FloatBatch operator+(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm512_add_ps(a.v, b.v) }; }
+	friend FloatBatch operator-(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm512_sub_ps(a.v, b.v) }; }
+	friend FloatBatch operator*(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm512_mul_ps(a.v, b.v) }; }
+	friend FloatBatch operator/(const FloatBatch& a, const FloatBatch& b) { return FloatBatch{ _mm512_div_ps(a.v, b.v) }; }
+	friend FloatBatch sqrt(const FloatBatch& a) { return FloatBatch{ _mm512_sqrt_ps(a.v) }; }
+};
+#endif
+
+template <int N>
+struct Vector2Batch {
+	FloatBatch<N> X, Y;
+
+	static Vector2Batch broadcast(Vector2 v) {
+		return Vector2Batch{ FloatBatch<N>::broadcast(v.X), FloatBatch<N>::broadcast(v.Y) };
+	}
+	// N consecutive Vector2s
+	static Vector2Batch load(const Vector2* v) {
+		float x[N], y[N];
+		for (int i = 0; i < N; i++) {
+			x[i] = v[i].X;
+			y[i] = v[i].Y;
+		}
+		return load(x, y);
+	}
+	// N floats from each of two arrays
+	static Vector2Batch load(const float* x, const float* y) {
+		return Vector2Batch{ FloatBatch<N>::load(x), FloatBatch<N>::load(y) };
+	}
+	void store(Vector2* v) const {
+		float x[N], y[N];
+		store(x, y);
+		for (int i = 0; i < N; i++) {
+			v[i] = Vector2{ x[i], y[i] };
+		}
+	}
+	void store(float* x, float* y) const {
+		X.store(x);
+		Y.store(y);
+	}
+	Vector2 get(int lane) const {
+		float x[N], y[N];
+		store(x, y);
+		return Vector2{ x[lane], y[lane] };
+	}
+	inline Vector2Batch operator+=(const Vector2Batch v2) {
+		X = X + v2.X;
+		Y = Y + v2.Y;
+		return *this;
+	}
+	inline Vector2Batch operator-=(const Vector2Batch v2) {
+		X = X - v2.X;
+		Y = Y - v2.Y;
+		return *this;
+	}
+	inline Vector2Batch operator*=(const Vector2Batch v2) {
+		X = X * v2.X;
+		Y = Y * v2.Y;
+		return *this;
+	}
+	inline Vector2Batch operator/=(const Vector2Batch v2) {
+		X = X / v2.X;
+		Y = Y / v2.Y;
+		return *this;
+	}
+	inline Vector2Batch operator+=(const float f) {
+		return *this += Vector2Batch{ FloatBatch<N>::broadcast(f), FloatBatch<N>::broadcast(f) };
+	}
+	inline Vector2Batch operator-=(const float f) {
+		return *this -= Vector2Batch{ FloatBatch<N>::broadcast(f), FloatBatch<N>::broadcast(f) };
+	}
+	inline Vector2Batch operator*=(const float f) {
+		return *this *= Vector2Batch{ FloatBatch<N>::broadcast(f), FloatBatch<N>::broadcast(f) };
+	}
+	inline Vector2Batch operator/=(const float f) {
+		return *this /= Vector2Batch{ FloatBatch<N>::broadcast(f), FloatBatch<N>::broadcast(f) };
+	}
+};
+
+typedef Vector2Batch<4> Vector2x4;
+typedef Vector2Batch<8> Vector2x8;
+typedef Vector2Batch<16> Vector2x16;
+
+template <int N>
+inline Vector2Batch<N> operator+(const Vector2Batch<N>& v1, const Vector2Batch<N>& v2) {
+	return Vector2Batch<N>{ v1.X + v2.X, v1.Y + v2.Y };
+}
+
+template <int N>
+inline Vector2Batch<N> operator-(const Vector2Batch<N>& v1, const Vector2Batch<N>& v2) {
+	return Vector2Batch<N>{ v1.X - v2.X, v1.Y - v2.Y };
+}
+
+template <int N>
+inline Vector2Batch<N> operator*(const Vector2Batch<N>& v1, const Vector2Batch<N>& v2) {
+	return Vector2Batch<N>{ v1.X * v2.X, v1.Y * v2.Y };
+}
+
+template <int N>
+inline Vector2Batch<N> operator/(const Vector2Batch<N>& v1, const Vector2Batch<N>& v2) {
+	return Vector2Batch<N>{ v1.X / v2.X, v1.Y / v2.Y };
+}
+
+template <int N>
+inline Vector2Batch<N> operator+(const Vector2Batch<N>& v1, const float f) {
+	FloatBatch<N> s = FloatBatch<N>::broadcast(f);
+	return Vector2Batch<N>{ v1.X + s, v1.Y + s };
+}
+
+template <int N>
+inline Vector2Batch<N> operator-(const Vector2Batch<N>& v1, const float f) {
+	FloatBatch<N> s = FloatBatch<N>::broadcast(f);
+	return Vector2Batch<N>{ v1.X - s, v1.Y - s };
+}
+
+template <int N>
+inline Vector2Batch<N> operator*(const Vector2Batch<N>& v1, const float f) {
+	FloatBatch<N> s = FloatBatch<N>::broadcast(f);
+	return Vector2Batch<N>{ v1.X * s, v1.Y * s };
+}
+
+template <int N>
+inline Vector2Batch<N> operator/(const Vector2Batch<N>& v1, const float f) {
+	FloatBatch<N> s = FloatBatch<N>::broadcast(f);
+	return Vector2Batch<N>{ v1.X / s, v1.Y / s };
+}
+
+// per-lane scale, like Vector2 * float with a different float in every lane
+template <int N>
+inline Vector2Batch<N> operator*(const Vector2Batch<N>& v1, const FloatBatch<N>& f) {
+	return Vector2Batch<N>{ v1.X * f, v1.Y * f };
+}
+
+template <int N>
+inline Vector2Batch<N> operator/(const Vector2Batch<N>& v1, const FloatBatch<N>& f) {
+	return Vector2Batch<N>{ v1.X / f, v1.Y / f };
+}
+
+template <int N>
+inline FloatBatch<N> dot(const Vector2Batch<N>& v1, const Vector2Batch<N>& v2) {
+	return v1.X * v2.X + v1.Y * v2.Y;
+}
+
+template <int N>
+inline FloatBatch<N> getLength(const Vector2Batch<N>& v) {
+	return sqrt(v.X * v.X + v.Y * v.Y);
+}
+
+// v / getLength(v) per lane; zero vectors give NaN, as the scalar form does
+template <int N>
+inline Vector2Batch<N> normalize(const Vector2Batch<N>& v) {
+	return v / getLength(v);
+}
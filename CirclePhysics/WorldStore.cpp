@@ -0,0 +1,300 @@
+#include "WorldStore.h"
+#include "Enemy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static int tileX(int64_t tile) {
+	return (int)(tile >> 32);
+}
+
+static int tileY(int64_t tile) {
+	return (int)(uint32_t)tile;
+}
+
+static int64_t tileKey(int x, int y) {
+	return ((int64_t)x << 32) | (uint32_t)y;
+}
+
+template <typename Physics>
+WorldStore<Physics>::WorldStore(BasicModel<Physics>& model, const std::string& directory, StreamSettings settings)
+	: _model(model), _directory(directory), _settings(settings) {
+	std::filesystem::create_directories(directory);
+	_thread = std::thread(&WorldStore::io, this);
+}
+
+template <typename Physics>
+WorldStore<Physics>::~WorldStore() {
+	flush();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	_thread.join();
+}
+
+template <typename Physics>
+void WorldStore<Physics>::addBodies(const std::vector<TileBody>& bodies) {
+	std::unordered_map<int64_t, std::vector<TileBody>> byTile;
+	for (const TileBody& b : bodies) {
+		byTile[getTile(Vector2{ b.x, b.y })].push_back(b);
+	}
+	for (auto& tile : byTile) {
+		submit(Job{ JOB_APPEND, tile.first, std::move(tile.second) });
+	}
+}
+
+template <typename Physics>
+void WorldStore<Physics>::update(Vector2 focus) {
+	std::deque<Loaded> loaded;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		loaded.swap(_loaded);
+	}
+	applyLoads(loaded);
+
+	// ask for every tile around the focus that is inside the world
+	int64_t center = getTile(focus);
+	int lastX = (int)std::ceil(_model.getWidth() / _settings.tileSize) - 1;
+	int lastY = (int)std::ceil(_model.getHeight() / _settings.tileSize) - 1;
+	for (int y = tileY(center) - _settings.loadRadius; y <= tileY(center) + _settings.loadRadius; y++) {
+		for (int x = tileX(center) - _settings.loadRadius; x <= tileX(center) + _settings.loadRadius; x++) {
+			int64_t tile = tileKey(x, y);
+			if (x < 0 || y < 0 || x > lastX || y > lastY || _tiles.count(tile) > 0) {
+				continue;
+			}
+			_tiles[tile] = false;
+			submit(Job{ JOB_LOAD, tile, {} });
+		}
+	}
+
+	evict(center, false);
+
+	// the focus tile has to be there before the frame can run
+	auto it = _tiles.find(center);
+	if (it != _tiles.end() && !it->second) {
+		auto start = std::chrono::steady_clock::now();
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [&] {
+			return std::any_of(_loaded.begin(), _loaded.end(), [&](const Loaded& l) { return l.tile == center; });
+		});
+		loaded.clear();
+		loaded.swap(_loaded);
+		lock.unlock();
+		applyLoads(loaded);
+		_stats.stalls++;
+		_stats.stallMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	_stats.residentTiles = 0;
+	_stats.pendingLoads = 0;
+	for (const auto& tile : _tiles) {
+		(tile.second ? _stats.residentTiles : _stats.pendingLoads)++;
+	}
+	_stats.bodies = (int)_owned.size();
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stats.bytesRead = _bytesRead;
+	_stats.bytesWritten = _bytesWritten;
+}
+
+template <typename Physics>
+void WorldStore<Physics>::applyLoads(std::deque<Loaded>& loaded) {
+	for (Loaded& l : loaded) {
+		_tiles[l.tile] = true;
+		_stats.loads++;
+		for (const TileBody& b : l.bodies) {
+			Collider c = Collider(Vector2{ b.x, b.y }, Vector2{ b.vx, b.vy }, b.size, b.mass, b.type);
+			c.setBodyType(b.bodyType);
+			c.setLayer(b.layer);
+			c.setMask(b.mask);
+			c.setCharge(b.charge);
+			Enemy* e = new Enemy(c, "enemy");
+			e->setColor(b.color);
+			_model.addEntity(e);
+			_owned.insert(e);
+		}
+	}
+}
+
+template <typename Physics>
+void WorldStore<Physics>::evict(int64_t center, bool all) {
+	// every resident tile that is too far out goes, even if it is empty now,
+	// so its file no longer holds the bodies it was loaded with
+	std::unordered_map<int64_t, std::vector<TileBody>> written;
+	for (const auto& tile : _tiles) {
+		int distance = std::max(std::abs(tileX(tile.first) - tileX(center)), std::abs(tileY(tile.first) - tileY(center)));
+		if (tile.second && (all || distance > _settings.evictRadius)) {
+			written[tile.first];
+		}
+	}
+	std::unordered_map<int64_t, std::vector<TileBody>> handedOver;
+	for (int i = _model.getEntityCount() - 1; i >= 0; i--) {
+		Entity* e = _model.getEntity(i);
+		if (_owned.count(e) == 0) {
+			continue;
+		}
+		int64_t tile = getTile(e->getCollider()->getPos());
+		auto w = written.find(tile);
+		if (w != written.end()) {
+			w->second.push_back(save(*e));
+		}
+		else if (_tiles.count(tile) == 0) {
+			handedOver[tile].push_back(save(*e));
+			_stats.handedOver++;
+		}
+		else {
+			continue;
+		}
+		_model.removeEntity(i);
+		_owned.erase(e);
+		delete e;
+	}
+	for (auto& tile : written) {
+		_tiles.erase(tile.first);
+		_stats.evictions++;
+		submit(Job{ JOB_WRITE, tile.first, std::move(tile.second) });
+	}
+	for (auto& tile : handedOver) {
+		submit(Job{ JOB_APPEND, tile.first, std::move(tile.second) });
+	}
+}
+
+template <typename Physics>
+void WorldStore<Physics>::flush() {
+	std::deque<Loaded> loaded;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [this] { return _busy == 0; });
+		loaded.swap(_loaded);
+	}
+	applyLoads(loaded);
+	evict(0, true);
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this] { return _busy == 0; });
+	_stats.bytesRead = _bytesRead;
+	_stats.bytesWritten = _bytesWritten;
+	_stats.residentTiles = 0;
+	_stats.pendingLoads = 0;
+	_stats.bodies = 0;
+}
+
+template <typename Physics>
+void WorldStore<Physics>::submit(Job job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::move(job));
+		_busy++;
+	}
+	_wake.notify_one();
+}
+
+template <typename Physics>
+void WorldStore<Physics>::io() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+		if (_jobs.empty()) {
+			return;
+		}
+		Job job = std::move(_jobs.front());
+		_jobs.pop_front();
+		lock.unlock();
+
+		std::string path = getPath(job.tile);
+		long long bytes = 0;
+		if (job.kind == JOB_LOAD) {
+			std::ifstream in{ path, std::ios::in | std::ios::binary };
+			uint32_t header[2] = { 0, 0 };
+			if (in.is_open() && in.read((char*)header, sizeof(header))) {
+				if (header[0] != WORLD_STORE_MAGIC || header[1] != WORLD_STORE_VERSION) {
+					std::cout << "Ignoring tile " << path << " with a bad header\n";
+				}
+				else {
+					bytes += sizeof(header);
+					TileBody b;
+					while (in.read((char*)&b, sizeof(b))) {
+						job.bodies.push_back(b);
+						bytes += sizeof(b);
+					}
+				}
+			}
+		}
+		else if (job.kind == JOB_WRITE && job.bodies.empty()) {
+			std::filesystem::remove(path);
+		}
+		else {
+			bool append = job.kind == JOB_APPEND && std::filesystem::exists(path);
+			std::ofstream out{ path, std::ios::out | std::ios::binary | (append ? std::ios::app : std::ios::trunc) };
+			if (!out.is_open()) {
+				std::cout << "Could not write " << path << "\n";
+			}
+			else {
+				if (!append) {
+					uint32_t header[2] = { WORLD_STORE_MAGIC, WORLD_STORE_VERSION };
+					out.write((const char*)header, sizeof(header));
+					bytes += sizeof(header);
+				}
+				out.write((const char*)job.bodies.data(), job.bodies.size() * sizeof(TileBody));
+				bytes += job.bodies.size() * sizeof(TileBody);
+			}
+		}
+
+		lock.lock();
+		if (job.kind == JOB_LOAD) {
+			_bytesRead += bytes;
+			_loaded.push_back(Loaded{ job.tile, std::move(job.bodies) });
+		}
+		else {
+			_bytesWritten += bytes;
+		}
+		_busy--;
+		_done.notify_all();
+	}
+}
+
+template <typename Physics>
+std::string WorldStore<Physics>::getPath(int64_t tile) const {
+	return _directory + "/tile_" + std::to_string(tileX(tile)) + "_" + std::to_string(tileY(tile)) + ".bin";
+}
+
+template <typename Physics>
+TileBody WorldStore<Physics>::save(const Entity& e) {
+	const Collider& c = *e.getCollider();
+	TileBody b = TileBody();
+	b.x = c.getPos().X;
+	b.y = c.getPos().Y;
+	b.vx = c.getVelocity().X;
+	b.vy = c.getVelocity().Y;
+	b.size = c.getHeight();
+	b.mass = c.getMass();
+	b.charge = c.getCharge();
+	b.layer = c.getLayer();
+	b.mask = c.getMask();
+	b.color = e.getColor();
+	b.type = (uint8_t)c.getType();
+	b.bodyType = (uint8_t)c.getBodyType();
+	return b;
+}
+
+template <typename Physics>
+const StreamSettings& WorldStore<Physics>::getSettings() const {
+	return _settings;
+}
+
+template <typename Physics>
+const StreamStats& WorldStore<Physics>::getStats() const {
+	return _stats;
+}
+
+template <typename Physics>
+int64_t WorldStore<Physics>::getTile(Vector2 pos) const {
+	return tileKey((int)std::floor(pos.X / _settings.tileSize), (int)std::floor(pos.Y / _settings.tileSize));
+}
+
+template class WorldStore<DefaultPhysics>;
+template class WorldStore<ElasticPhysics>;
+template class WorldStore<RuntimePhysics>;
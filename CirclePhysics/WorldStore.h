@@ -0,0 +1,126 @@
+#pragma once
+#include "Model.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#define WORLD_STORE_MAGIC 0x4C544350u
+#define WORLD_STORE_VERSION 1
+
+// One body as stored in a tile file. A tile file is an 8 byte header (magic,
+// version) followed by these records back to back
+struct TileBody {
+	float x;
+	float y;
+	float vx;
+	float vy;
+	float size;
+	float mass;
+	float charge;
+	uint32_t layer;
+	uint32_t mask;
+	uint32_t color;
+	uint8_t type;
+	uint8_t bodyType;
+	uint8_t padding[2];
+};
+
+struct StreamSettings {
+	float tileSize = 512;
+	// tiles within this many tiles of the focus are loaded ahead of time
+	int loadRadius = 1;
+	// resident tiles further out than this are written back and evicted
+	int evictRadius = 2;
+};
+
+struct StreamStats {
+	int residentTiles = 0;
+	int pendingLoads = 0;
+	// bodies of resident tiles currently in the model
+	int bodies = 0;
+	int loads = 0;
+	int evictions = 0;
+	// bodies that crossed into a tile on disk and were appended to it
+	int handedOver = 0;
+	long long bytesRead = 0;
+	long long bytesWritten = 0;
+	// frames that had to wait for the focus tile to finish loading
+	int stalls = 0;
+	double stallMilliseconds = 0;
+};
+
+// Pages a world much larger than memory through a model. The world is cut into
+// square tiles, each a file in the store's directory. Tiles around the focus
+// (usually the player) are read on a background I/O thread and their bodies
+// added to the model; resident tiles that fall far behind are written back and
+// their bodies removed. A body belongs to the tile its center is in at the time
+// it is written, so bodies that crossed a tile edge leave with the tile they are
+// in now, and a body that wanders into a tile that is not loaded is appended to
+// that tile's file. The I/O thread works through its jobs in order, so a tile
+// is always written before it can be read again.
+//
+// Only bodies the store created are paged, entities added to the model
+// directly (the player) stay. The store owns and deletes its entities.
+template <typename Physics>
+class WorldStore {
+public:
+	WorldStore(BasicModel<Physics>& model, const std::string& directory, StreamSettings settings = StreamSettings());
+	~WorldStore();
+	WorldStore(const WorldStore&) = delete;
+	WorldStore& operator=(const WorldStore&) = delete;
+	// Adds bodies to the tiles on disk, for building a world before streaming it
+	void addBodies(const std::vector<TileBody>& bodies);
+	// Call once per frame before the model update
+	void update(Vector2 focus);
+	// Writes every resident tile back and waits for the I/O thread
+	void flush();
+	const StreamSettings& getSettings() const;
+	const StreamStats& getStats() const;
+	int64_t getTile(Vector2 pos) const;
+private:
+	enum JobKind {
+		JOB_LOAD,
+		JOB_WRITE,
+		JOB_APPEND
+	};
+	struct Job {
+		JobKind kind;
+		int64_t tile;
+		std::vector<TileBody> bodies;
+	};
+	struct Loaded {
+		int64_t tile;
+		std::vector<TileBody> bodies;
+	};
+	void io();
+	void submit(Job job);
+	void applyLoads(std::deque<Loaded>& loaded);
+	void evict(int64_t center, bool all);
+	std::string getPath(int64_t tile) const;
+	static TileBody save(const Entity& e);
+
+	BasicModel<Physics>& _model;
+	std::string _directory;
+	StreamSettings _settings;
+	StreamStats _stats;
+	// tiles with bodies in the model, true once loaded and false while loading
+	std::unordered_map<int64_t, bool> _tiles;
+	std::unordered_set<const Entity*> _owned;
+
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _done;
+	std::deque<Job> _jobs;
+	std::deque<Loaded> _loaded;
+	int _busy = 0;
+	long long _bytesRead = 0;
+	long long _bytesWritten = 0;
+	bool _stopping = false;
+};
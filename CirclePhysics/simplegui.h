@@ -2,7 +2,9 @@
 
 #include <cstdint>
 
-#if BUILDING_SIMPLEGUI
+#if !defined(_WIN32)
+#define SIMPLEGUI_API
+#elif BUILDING_SIMPLEGUI
 #define SIMPLEGUI_API __declspec(dllexport)
 #else
 #define SIMPLEGUI_API __declspec(dllimport)
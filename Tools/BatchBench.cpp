@@ -0,0 +1,105 @@
+// Sweeps restitution and friction over a batch of headless worlds with
+// BatchRunner and runs the same batch on pools of growing size. Prints the
+// worlds per second and the speedup for every thread count, then the mean
+// survival time for each pair of parameters. Exits with 1 if a world's result
+// depends on the thread count, or if every pair of parameters ends the same,
+// when the sweep measures nothing.
+//
+//   BatchBench [seeds] [seconds]
+#include "BatchRunner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#define BATCH_BENCH_WIDTH 500
+#define BATCH_BENCH_HEIGHT 500
+#define BATCH_BENCH_ENEMIES 15
+
+static bool sameResults(const std::vector<WorldResult>& a, const std::vector<WorldResult>& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (int i = 0; i < a.size(); i++) {
+		if (a[i].seed != b[i].seed || a[i].survived != b[i].survived || a[i].steps != b[i].steps ||
+			a[i].survivalTime != b[i].survivalTime || a[i].finalHealth != b[i].finalHealth) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	int seeds = argc > 1 ? atoi(argv[1]) : 16;
+	double seconds = argc > 2 ? atof(argv[2]) : 10;
+	std::vector<float> restitutions = { 0.6f, 0.8f, 1.0f };
+	std::vector<float> frictions = { 0.0f, 0.4f, 0.8f };
+	WorldConfig base;
+	base.width = BATCH_BENCH_WIDTH;
+	base.height = BATCH_BENCH_HEIGHT;
+	base.enemies = BATCH_BENCH_ENEMIES;
+	base.maxTime = seconds;
+
+	// worker threads, the caller of run() works too; at least one pool with a
+	// worker so the parallel path runs on a single core machine as well
+	int cores = (int)std::thread::hardware_concurrency();
+	std::vector<int> workers = { 0 };
+	for (int w = 1; w < std::max(cores, 2); w = w * 2 + 1) {
+		workers.push_back(w);
+	}
+
+	std::vector<WorldResult> reference;
+	double serialMs = 0;
+	int failures = 0;
+	printf("%d worlds of %g simulated seconds, %d cores\n", (int)(restitutions.size() * frictions.size()) * seeds, seconds, cores);
+	printf("%-8s %12s %12s %10s\n", "threads", "wall ms", "worlds/s", "speedup");
+	for (int w : workers) {
+		ThreadPool pool(w);
+		BatchRunner runner(pool);
+		runner.addSweep(base, restitutions, frictions, seeds);
+		runner.run();
+		double ms = runner.getWallMilliseconds();
+		if (w == 0) {
+			reference = runner.getResults();
+			serialMs = ms;
+		}
+		else if (!sameResults(reference, runner.getResults())) {
+			printf("results on %d threads differ from one thread\n", w + 1);
+			failures++;
+		}
+		printf("%-8d %12.1f %12.1f %10.2f\n", w + 1, ms, reference.size() / ms * 1000, serialMs / ms);
+	}
+
+	printf("%-12s %10s %14s %10s\n", "restitution", "friction", "survival s", "survived");
+	int world = 0;
+	int sameRows = 0;
+	double firstSurvival = 0;
+	int firstSurvived = 0;
+	for (float restitution : restitutions) {
+		for (float friction : frictions) {
+			double survival = 0;
+			int survived = 0;
+			for (int s = 0; s < seeds; s++, world++) {
+				survival += reference[world].survivalTime;
+				survived += reference[world].survived ? 1 : 0;
+			}
+			printf("%-12.1f %10.1f %14.3f %6d/%d\n", restitution, friction, survival / seeds, survived, seeds);
+			if (world == seeds) {
+				firstSurvival = survival;
+				firstSurvived = survived;
+			}
+			if (survival == firstSurvival && survived == firstSurvived) {
+				sameRows++;
+			}
+		}
+	}
+	if (sameRows == (int)(restitutions.size() * frictions.size())) {
+		printf("every pair of parameters gave the same results\n");
+		failures++;
+	}
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,76 @@
+// Compares two MicroBench JSON files and fails if any benchmark got slower
+// than the threshold allows.
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#define COMPARE_DEFAULT_THRESHOLD 10.0
+
+// reads "name" and "ns_per_op" from every benchmark line MicroBench writes
+static bool load(const char* path, std::map<std::string, double>& times, std::vector<std::string>& order) {
+	std::ifstream in(path);
+	if (!in.is_open()) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(in, line)) {
+		size_t name = line.find("\"name\": \"");
+		size_t time = line.find("\"ns_per_op\": ");
+		if (name == std::string::npos || time == std::string::npos) {
+			continue;
+		}
+		name += 9;
+		std::string key = line.substr(name, line.find('"', name) - name);
+		times[key] = atof(line.c_str() + time + 13);
+		order.push_back(key);
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		printf("usage: BenchCompare baseline.json current.json [threshold percent, default %g]\n", COMPARE_DEFAULT_THRESHOLD);
+		return 2;
+	}
+	double threshold = argc > 3 ? atof(argv[3]) : COMPARE_DEFAULT_THRESHOLD;
+	std::map<std::string, double> baseline, current;
+	std::vector<std::string> baselineOrder, currentOrder;
+	if (!load(argv[1], baseline, baselineOrder)) {
+		printf("could not read %s\n", argv[1]);
+		return 2;
+	}
+	if (!load(argv[2], current, currentOrder)) {
+		printf("could not read %s\n", argv[2]);
+		return 2;
+	}
+
+	int regressions = 0;
+	printf("%-28s %12s %12s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+	for (const std::string& name : currentOrder) {
+		auto it = baseline.find(name);
+		if (it == baseline.end()) {
+			printf("%-28s %12s %12.3f %9s  new\n", name.c_str(), "-", current[name], "-");
+			continue;
+		}
+		double change = (current[name] - it->second) / it->second * 100;
+		const char* verdict = "";
+		if (change > threshold) {
+			verdict = "  REGRESSION";
+			regressions++;
+		}
+		else if (change < -threshold) {
+			verdict = "  faster";
+		}
+		printf("%-28s %12.3f %12.3f %+8.1f%%%s\n", name.c_str(), it->second, current[name], change, verdict);
+	}
+	for (const std::string& name : baselineOrder) {
+		if (current.find(name) == current.end()) {
+			printf("%-28s %12.3f %12s %9s  missing\n", name.c_str(), baseline[name], "-", "-");
+		}
+	}
+	printf("%d regression%s beyond %g%%\n", regressions, regressions == 1 ? "" : "s", threshold);
+	return regressions > 0 ? 1 : 0;
+}
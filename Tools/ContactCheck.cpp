@@ -0,0 +1,165 @@
+// Packs a square block of touching bodies and lets their own gravity press it
+// together until it rests, once with the single-pass resolver, once with the
+// iterative solver starting every contact from zero and once warm started from
+// the contact cache. Prints the cache hit rate, the velocity passes the solver
+// needed per frame and the deepest overlap left between the bodies once the
+// block rests, then removes a body from the middle of the block and prints the
+// hit rate of the frame after. Exits with 1 if the solver stopped before its
+// tolerance was met, if warm started it still ran out of passes on a resting
+// frame, if it leaves the bodies overlapping as deep as the single pass does,
+// if warm starting does not settle in fewer passes, if the resting contacts
+// miss the cache or if removing a body throws away the cached contacts of the
+// others.
+//
+//   ContactCheck [side] [frames]
+#include "Enemy.h"
+#include "Model.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#define CONTACT_SIZE 10.0f
+#define CONTACT_MASS 1.0f
+#define CONTACT_GRAVITY 500.0f
+#define CONTACT_TIMESTEP 0.01
+#define CONTACT_ITERATIONS 32
+// hit rate the resting contacts and the contacts after a removal must reach
+#define CONTACT_MIN_HIT_RATE 0.9f
+
+struct StackResult {
+	double passes = 0;
+	double contacts = 0;
+	double hitRate = 0;
+	float overlap = 0;
+	// frames the solver ran out of passes on, and frames it stopped on early
+	// with an impulse change still over the tolerance
+	int exhausted = 0;
+	int unconverged = 0;
+	float hitRateAfterRemoval = 0;
+	int contactsAfterRemoval = 0;
+};
+
+// deepest overlap of any two bodies
+static float deepestOverlap(const std::vector<std::unique_ptr<Enemy>>& entities) {
+	float deepest = 0;
+	for (int i = 0; i < entities.size(); i++) {
+		const Collider& a = *entities[i]->getCollider();
+		for (int j = i + 1; j < entities.size(); j++) {
+			const Collider& b = *entities[j]->getCollider();
+			deepest = std::max(deepest, (a.getHeight() + b.getHeight()) / 2 - getLength(a.getPos() - b.getPos()));
+		}
+	}
+	return deepest;
+}
+
+static StackResult runStack(int side, int frames, bool iterative, bool warm) {
+	std::vector<std::unique_ptr<Enemy>> entities;
+	float extent = side * CONTACT_SIZE * 4;
+	RuntimePhysics physics;
+	physics.restitution = 0;
+	physics.frictionEnabled = false;
+	physics.iterativeSolver = iterative;
+	physics.solverIterations = CONTACT_ITERATIONS;
+	physics.warmStarting = warm;
+	BasicModel<RuntimePhysics> m((int)extent, (int)extent, physics);
+	ForceSettings& forces = m.getForceSettings();
+	forces.enabled = true;
+	forces.gravity = CONTACT_GRAVITY;
+	float origin = (extent - side * CONTACT_SIZE) / 2 + CONTACT_SIZE / 2;
+	NameId name = NamePool::intern("enemy");
+	for (int y = 0; y < side; y++) {
+		for (int x = 0; x < side; x++) {
+			Collider c = Collider(Vector2{ origin + x * CONTACT_SIZE, origin + y * CONTACT_SIZE }, Vector2(), CONTACT_SIZE, CONTACT_MASS);
+			c.setLayer(LAYER_ENEMY);
+			entities.push_back(std::make_unique<Enemy>(c, name));
+			m.addEntity(entities.back().get());
+		}
+	}
+
+	// the second half of the frames is taken as resting
+	StackResult result;
+	int measured = 0;
+	for (int f = 0; f < frames; f++) {
+		m.update(CONTACT_TIMESTEP, Vector2());
+		if (f < frames / 2) {
+			continue;
+		}
+		const SolverStats& solver = m.getSolverStats();
+		result.passes += solver.velocityIterations;
+		result.contacts += m.getPairStats().contacts;
+		result.hitRate += m.getContactCache().getStats().getHitRate();
+		result.overlap = std::max(result.overlap, deepestOverlap(entities));
+		if (iterative && solver.velocityIterations >= CONTACT_ITERATIONS) {
+			result.exhausted++;
+		}
+		else if (iterative && solver.maxImpulseDelta >= physics.solverTolerance) {
+			result.unconverged++;
+		}
+		measured++;
+	}
+	result.passes /= measured;
+	result.contacts /= measured;
+	result.hitRate /= measured;
+
+	m.removeEntity((side / 2) * side + side / 2);
+	m.update(CONTACT_TIMESTEP, Vector2());
+	result.hitRateAfterRemoval = m.getContactCache().getStats().getHitRate();
+	result.contactsAfterRemoval = m.getPairStats().contacts;
+	return result;
+}
+
+int main(int argc, char* argv[]) {
+	int side = argc > 1 ? atoi(argv[1]) : 12;
+	int frames = argc > 2 ? atoi(argv[2]) : 300;
+	if (side < 2 || frames < 2) {
+		printf("usage: ContactCheck [side >= 2] [frames >= 2]\n");
+		return EXIT_FAILURE;
+	}
+	printf("%d bodies in a block under their own gravity, %d frames, up to %d solver passes\n", side * side, frames, CONTACT_ITERATIONS);
+	printf("%-8s %10s %10s %10s %12s %16s\n", "start", "contacts", "passes", "hit rate", "overlap", "hit after remove");
+	StackResult single = runStack(side, frames, false, false);
+	StackResult cold = runStack(side, frames, true, false);
+	StackResult warm = runStack(side, frames, true, true);
+	printf("%-8s %10.1f %10s %10s %12.4f %16s\n", "single", single.contacts, "-", "-", single.overlap, "-");
+	printf("%-8s %10.1f %10.2f %10s %12.4f %16s\n", "cold", cold.contacts, cold.passes, "-", cold.overlap, "-");
+	printf("%-8s %10.1f %10.2f %10.3f %12.4f %16.3f\n", "warm", warm.contacts, warm.passes, warm.hitRate, warm.overlap, warm.hitRateAfterRemoval);
+
+	int failures = 0;
+	if (warm.contacts == 0) {
+		printf("the block did not rest in contact\n");
+		failures++;
+	}
+	if (warm.exhausted > 0) {
+		printf("warm started, %d resting frames used all %d passes\n", warm.exhausted, CONTACT_ITERATIONS);
+		failures++;
+	}
+	for (const StackResult* r : { &cold, &warm }) {
+		if (r->unconverged > 0) {
+			printf("%s start: %d frames stopped with the impulse change over the tolerance\n", r == &cold ? "cold" : "warm", r->unconverged);
+			failures++;
+		}
+		if (r->overlap >= single.overlap) {
+			printf("%s start left an overlap of %.4f, the single pass %.4f\n", r == &cold ? "cold" : "warm", r->overlap, single.overlap);
+			failures++;
+		}
+	}
+	if (warm.passes >= cold.passes) {
+		printf("warm starting took %.2f passes per frame, starting from zero %.2f\n", warm.passes, cold.passes);
+		failures++;
+	}
+	if (warm.hitRate < CONTACT_MIN_HIT_RATE) {
+		printf("resting contacts hit the cache %.3f of the time\n", warm.hitRate);
+		failures++;
+	}
+	if (warm.contactsAfterRemoval == 0 || warm.hitRateAfterRemoval < CONTACT_MIN_HIT_RATE) {
+		printf("after removing a body the cache hit %.3f of %d contacts\n", warm.hitRateAfterRemoval, warm.contactsAfterRemoval);
+		failures++;
+	}
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,257 @@
+// Differential validation: steps the same seeded scenes through the reference
+// path (BasicModel<DefaultPhysics>, legacy all-pairs resolveCollision) and an
+// alternative path side by side, and compares the pairs in contact, every
+// body's position and velocity, total momentum and kinetic energy after each
+// step. Reports the first frame and body that diverge. Every seed runs twice,
+// once as is and once with fast bodies at a frame-sized step, so bodies cross
+// more than their radius in a step and the substep path has work. Runs
+// headless; exits with 1 on divergence, or if the substep path never
+// substepped a body.
+//
+//   DiffCheck [path] [--scenes N] [--bodies N] [--steps N] [--tolerance T]
+//
+// path is one of
+//   grid     RuntimePhysics with the DefaultPhysics values, pairs taken from the
+//            spatial grid through a single full-rate LOD level (default; must
+//            match)
+//   runtime  RuntimePhysics with the DefaultPhysics values, all pairs (must match)
+//   solver   iterative contact solver
+//   warm     warm-started legacy resolver
+//   substep  multirate substepping
+#include "Enemy.h"
+#include "Model.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+#define DIFF_WIDTH 500
+#define DIFF_HEIGHT 500
+#define DIFF_MIN_WIDTH_HEIGHT 8
+#define DIFF_MAX_WIDTH_HEIGHT 40
+#define DIFF_MAX_AXIS_VELOCITY 60
+#define DIFF_MASS_WIDTH_HEIGHT_RATIO 10
+#define DIFF_TIMESTEP 0.01
+// every tenth body of a scene is static
+#define DIFF_STATIC_EVERY 10
+// in a fast scene every third dynamic body moves at this speed, just under the
+// speed cap, and the step is a 30 Hz frame
+#define DIFF_FAST_EVERY 3
+#define DIFF_FAST_SPEED 180
+#define DIFF_FAST_TIMESTEP (1.0 / 30)
+
+struct BodySeed {
+	Vector2 pos;
+	Vector2 vel;
+	float size;
+	int bodyType;
+};
+
+struct Totals {
+	Vector2 momentum;
+	double energy;
+};
+
+template <typename Physics>
+class World {
+public:
+	World(const std::vector<BodySeed>& bodies, Physics physics, bool grid = false) : _model(DIFF_WIDTH, DIFF_HEIGHT, physics) {
+		if (grid) {
+			// every body active every frame, so only where the pairs come from changes
+			LodSettings& lod = _model.getLodSettings();
+			lod.enabled = true;
+			lod.levels = { LodLevel{ 2.0f * (DIFF_WIDTH + DIFF_HEIGHT), 1, false } };
+		}
+		for (const BodySeed& b : bodies) {
+			Collider c = Collider(b.pos, b.vel, b.size, b.size * DIFF_MASS_WIDTH_HEIGHT_RATIO);
+			c.setBodyType(b.bodyType);
+			c.setLayer(LAYER_ENEMY);
+			_entities.emplace_back(new Enemy(c, "body"));
+			_model.addEntity(_entities.back().get());
+		}
+	}
+	void step(double time) {
+		_model.update(time, Vector2());
+	}
+	std::vector<std::pair<int, int>> getContactPairs() const {
+		std::vector<std::pair<int, int>> pairs = _model.getContactPairs();
+		std::sort(pairs.begin(), pairs.end());
+		return pairs;
+	}
+	int getSubstepped() const {
+		return _model.getSubstepStats().fastBodies;
+	}
+	const Collider& getBody(int i) const {
+		return *_entities[i]->getCollider();
+	}
+	Totals getTotals() const {
+		Totals t = Totals{ Vector2(), 0 };
+		for (const std::unique_ptr<Enemy>& e : _entities) {
+			const Collider& c = *e->getCollider();
+			if (c.getBodyType() == BODY_DYNAMIC) {
+				t.momentum += c.getVelocity() * c.getMass();
+				t.energy += 0.5 * c.getMass() * dot(c.getVelocity(), c.getVelocity());
+			}
+		}
+		return t;
+	}
+private:
+	BasicModel<Physics> _model;
+	std::vector<std::unique_ptr<Enemy>> _entities;
+};
+
+static std::vector<BodySeed> makeScene(unsigned int seed, int count, bool fast) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> size(DIFF_MIN_WIDTH_HEIGHT, DIFF_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> velocity(-DIFF_MAX_AXIS_VELOCITY, DIFF_MAX_AXIS_VELOCITY);
+	std::uniform_real_distribution<float> unit(0, 1);
+	std::uniform_real_distribution<float> angle(0, 6.2831853f);
+	std::vector<BodySeed> bodies;
+	for (int i = 0; i < count; i++) {
+		float widthHeight = size(rng);
+		Vector2 pos{ unit(rng) * (DIFF_WIDTH - widthHeight) + widthHeight / 2, unit(rng) * (DIFF_HEIGHT - widthHeight) + widthHeight / 2 };
+		bool fixed = i % DIFF_STATIC_EVERY == DIFF_STATIC_EVERY - 1;
+		Vector2 vel = fixed ? Vector2() : Vector2{ velocity(rng), velocity(rng) };
+		if (fast && !fixed && i % DIFF_FAST_EVERY == 0) {
+			float a = angle(rng);
+			vel = Vector2{ std::cos(a), std::sin(a) } * DIFF_FAST_SPEED;
+		}
+		bodies.push_back(BodySeed{ pos, vel, widthHeight, fixed ? BODY_STATIC : BODY_DYNAMIC });
+	}
+	return bodies;
+}
+
+static bool relativeClose(double a, double b, double tolerance) {
+	return std::abs(a - b) <= tolerance * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+// Steps both worlds and returns the first divergent frame, or -1. substepped
+// counts the bodies the alternative substepped over the frames run
+static int compare(World<DefaultPhysics>& reference, World<RuntimePhysics>& alternative, int bodies, int steps, double time, float tolerance, int& substepped) {
+	for (int frame = 0; frame < steps; frame++) {
+		reference.step(time);
+		alternative.step(time);
+		substepped += alternative.getSubstepped();
+		std::vector<std::pair<int, int>> referencePairs = reference.getContactPairs();
+		std::vector<std::pair<int, int>> alternativePairs = alternative.getContactPairs();
+		if (referencePairs != alternativePairs) {
+			auto mismatch = std::mismatch(referencePairs.begin(), referencePairs.end(), alternativePairs.begin(), alternativePairs.end());
+			printf("  frame %d: %d contacts, alternative has %d", frame, (int)referencePairs.size(), (int)alternativePairs.size());
+			if (mismatch.first != referencePairs.end()) {
+				printf(", reference has %d-%d", mismatch.first->first, mismatch.first->second);
+			}
+			if (mismatch.second != alternativePairs.end()) {
+				printf(", alternative has %d-%d", mismatch.second->first, mismatch.second->second);
+			}
+			printf("\n");
+			return frame;
+		}
+		for (int i = 0; i < bodies; i++) {
+			const Collider& r = reference.getBody(i);
+			const Collider& a = alternative.getBody(i);
+			float dp = getLength(r.getPos() - a.getPos());
+			float dv = getLength(r.getVelocity() - a.getVelocity());
+			if (!(dp <= tolerance) || !(dv <= tolerance)) {
+				printf("  frame %d, body %d: position (%g, %g) vs (%g, %g), velocity (%g, %g) vs (%g, %g)\n", frame, i,
+					r.getPos().X, r.getPos().Y, a.getPos().X, a.getPos().Y,
+					r.getVelocity().X, r.getVelocity().Y, a.getVelocity().X, a.getVelocity().Y);
+				return frame;
+			}
+		}
+		Totals rt = reference.getTotals();
+		Totals at = alternative.getTotals();
+		if (!relativeClose(rt.momentum.X, at.momentum.X, tolerance) || !relativeClose(rt.momentum.Y, at.momentum.Y, tolerance)) {
+			printf("  frame %d: momentum (%g, %g) vs (%g, %g)\n", frame, rt.momentum.X, rt.momentum.Y, at.momentum.X, at.momentum.Y);
+			return frame;
+		}
+		if (!relativeClose(rt.energy, at.energy, tolerance)) {
+			printf("  frame %d: kinetic energy %.9g vs %.9g\n", frame, rt.energy, at.energy);
+			return frame;
+		}
+	}
+	return -1;
+}
+
+int main(int argc, char* argv[]) {
+	std::string path = "grid";
+	int scenes = 8;
+	int bodies = 60;
+	int steps = 1000;
+	float tolerance = 1e-4f;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--scenes") == 0 && i + 1 < argc) {
+			scenes = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--bodies") == 0 && i + 1 < argc) {
+			bodies = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+			steps = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+			tolerance = (float)atof(argv[++i]);
+		}
+		else if (argv[i][0] != '-') {
+			path = argv[i];
+		}
+		else {
+			printf("usage: DiffCheck [grid|runtime|solver|warm|substep] [--scenes N] [--bodies N] [--steps N] [--tolerance T]\n");
+			return 2;
+		}
+	}
+
+	RuntimePhysics physics;
+	if (path == "solver") {
+		physics.iterativeSolver = true;
+	}
+	else if (path == "warm") {
+		physics.warmStarting = true;
+	}
+	else if (path == "substep") {
+		physics.substepping = true;
+	}
+	else if (path != "runtime" && path != "grid") {
+		printf("unknown path %s\n", path.c_str());
+		return 2;
+	}
+
+	int diverged = 0;
+	int substepped = 0;
+	for (int s = 0; s < scenes; s++) {
+		for (bool fast : { false, true }) {
+			unsigned int seed = 1000 + s;
+			std::vector<BodySeed> scene = makeScene(seed, bodies, fast);
+			World<DefaultPhysics> reference(scene, DefaultPhysics());
+			World<RuntimePhysics> alternative(scene, physics, path == "grid");
+			printf("seed %u, %d bodies%s, %s path\n", seed, bodies, fast ? ", fast" : "", path.c_str());
+			int sceneSubstepped = 0;
+			int frame = compare(reference, alternative, bodies, steps, fast ? DIFF_FAST_TIMESTEP : DIFF_TIMESTEP, tolerance, sceneSubstepped);
+			if (frame >= 0) {
+				printf("  DIVERGED at frame %d of %d\n", frame, steps);
+				diverged++;
+			}
+			else {
+				printf("  matched for %d steps\n", steps);
+			}
+			if (physics.substepping) {
+				printf("  %d body steps substepped\n", sceneSubstepped);
+			}
+			substepped += sceneSubstepped;
+		}
+	}
+	printf("%d of %d scenes diverged\n", diverged, scenes * 2);
+	bool unused = physics.substepping && substepped == 0;
+	if (unused) {
+		printf("the substep path never substepped a body\n");
+	}
+	if (diverged > 0 || unused) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
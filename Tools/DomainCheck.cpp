@@ -0,0 +1,138 @@
+// Runs scenes of growing density through DomainRunner and through Model::update
+// over the whole world in one process. Every body of the small scene must end
+// up in the same state bit for bit; the denser scenes have chains of touching
+// bodies longer than the ghost band, so their drift is only printed. Then
+// kills a worker and checks the runner notices. Linux only.
+//
+//   DomainCheck [workers] [bodies]
+#include "DomainDecomposition.h"
+#include "Enemy.h"
+#include "Model.h"
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+
+#define CHECK_WIDTH 800
+#define CHECK_HEIGHT 400
+#define CHECK_STEPS 500
+#define CHECK_TIMESTEP 0.01
+// four of the largest diameters
+#define CHECK_GHOST_WIDTH 100
+
+static std::vector<BodyState> makeScene(int bodies) {
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> x(20, CHECK_WIDTH - 20);
+	std::uniform_real_distribution<float> y(20, CHECK_HEIGHT - 20);
+	std::uniform_real_distribution<float> v(-60, 60);
+	std::uniform_real_distribution<float> r(4, 12);
+	std::vector<BodyState> scene;
+	for (uint32_t i = 0; i < bodies; i++) {
+		float radius = r(rng);
+		scene.push_back(BodyState{ i, x(rng), y(rng), v(rng), v(rng), radius, radius * 20, 0, 0x1u, 0xffffffffu });
+	}
+	return scene;
+}
+
+// Returns the number of bodies that differ from the single process run, -1 if
+// the runner failed
+static int check(int workers, int bodies) {
+	std::vector<BodyState> scene = makeScene(bodies);
+	DomainRunner domains(CHECK_WIDTH, CHECK_HEIGHT, workers, CHECK_GHOST_WIDTH);
+	BasicModel<RuntimePhysics> model(CHECK_WIDTH, CHECK_HEIGHT, RuntimePhysics());
+	std::vector<std::unique_ptr<Enemy>> entities;
+	NameId name = NamePool::intern("body");
+	for (const BodyState& b : scene) {
+		domains.addBody(b);
+		Collider c = Collider(Vector2{ b.x, b.y }, Vector2{ b.vx, b.vy }, 2 * b.radius, b.mass);
+		c.setLayer(b.layer);
+		c.setMask(b.mask);
+		entities.push_back(std::make_unique<Enemy>(c, name));
+		model.addEntity(entities.back().get());
+	}
+	if (!domains.start()) {
+		printf("could not start %d workers\n", workers);
+		domains.stop();
+		return -1;
+	}
+	int migrated = 0;
+	double referenceMs = 0;
+	double splitMs = 0;
+	bool ok = true;
+	for (int s = 0; ok && s < CHECK_STEPS; s++) {
+		auto start = std::chrono::steady_clock::now();
+		model.update(CHECK_TIMESTEP, Vector2());
+		referenceMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		ok = domains.step(CHECK_TIMESTEP);
+		migrated += domains.getStats().migrated;
+		splitMs += domains.getStats().stepMilliseconds;
+	}
+	std::vector<BodyState> split;
+	ok = ok && domains.gather(split);
+	domains.stop();
+	if (!ok) {
+		printf("a worker failed\n");
+		return -1;
+	}
+	if (split.size() != scene.size()) {
+		printf("%zu bodies came back, expected %zu\n", split.size(), scene.size());
+		return -1;
+	}
+
+	int different = 0;
+	float worst = 0;
+	for (int i = 0; i < scene.size(); i++) {
+		const Collider& c = *entities[i]->getCollider();
+		BodyState reference = scene[i];
+		reference.x = c.getPos().X;
+		reference.y = c.getPos().Y;
+		reference.vx = c.getVelocity().X;
+		reference.vy = c.getVelocity().Y;
+		different += memcmp(&split[i], &reference, sizeof(BodyState)) != 0 ? 1 : 0;
+		worst = std::max(worst, std::hypot(split[i].x - reference.x, split[i].y - reference.y));
+	}
+	printf("%-8d %8d %10d %12.3f %12.3f %10d %10g\n", bodies, workers, migrated, referenceMs / CHECK_STEPS, splitMs / CHECK_STEPS, different, worst);
+	return different;
+}
+
+int main(int argc, char* argv[]) {
+	int workers = argc > 1 ? atoi(argv[1]) : 4;
+	std::vector<int> scenes = { 60, 400, 1200 };
+	if (argc > 2) {
+		scenes = { atoi(argv[2]) };
+	}
+	int failures = 0;
+	printf("%d steps in %dx%d\n", CHECK_STEPS, CHECK_WIDTH, CHECK_HEIGHT);
+	printf("%-8s %8s %10s %12s %12s %10s %10s\n", "bodies", "workers", "hand-overs", "ms/step", "split ms", "different", "max error");
+	for (int bodies : scenes) {
+		int different = check(workers, bodies);
+		failures += different < 0 || (bodies == scenes[0] && different != 0) ? 1 : 0;
+	}
+
+	// a dead worker must fail the next step rather than hang or go unnoticed
+	DomainRunner domains(CHECK_WIDTH, CHECK_HEIGHT, std::max(workers, 2), CHECK_GHOST_WIDTH);
+	for (const BodyState& b : makeScene(scenes[0])) {
+		domains.addBody(b);
+	}
+	bool noticed = domains.start() && domains.step(CHECK_TIMESTEP);
+	if (noticed) {
+		kill(domains.getWorkerPid(1), SIGKILL);
+		noticed = !domains.step(CHECK_TIMESTEP);
+	}
+	std::vector<BodyState> left;
+	noticed = noticed && !domains.gather(left);
+	domains.stop();
+	printf("killed worker %s\n", noticed ? "noticed" : "not noticed");
+	failures += noticed ? 0 : 1;
+
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,168 @@
+// Runs an elastic, frictionless scene through the event-driven mode of Model
+// and through the time-stepped path. Both count contact onsets, a pair that
+// touches and did not touch before: a collision event on the event-driven path,
+// a pair overlapping after a step that did not after the last one on the
+// stepped path. Prints onsets per second of wall time, wall time per simulated
+// second and energy drift for both, and checks that the event-driven result
+// is the same bit for bit at other frame rates. The stepped path runs with the iterative
+// solver, the legacy resolver gains energy without bound in elastic scenes.
+// Exits with 1 if either path's energy is not finite or a frame rate differs.
+//
+//   EventBench [bodies] [simulated seconds]
+#include "Enemy.h"
+#include "Model.h"
+#include "SpatialGrid.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <unordered_set>
+
+#define BENCH_WIDTH 1000
+#define BENCH_HEIGHT 1000
+#define BENCH_MIN_WIDTH_HEIGHT 8
+#define BENCH_MAX_WIDTH_HEIGHT 16
+#define BENCH_MAX_AXIS_VELOCITY 60
+#define BENCH_MASS_WIDTH_HEIGHT_RATIO 10
+#define BENCH_TIMESTEP 0.01
+// the engine's frame clock ends on the same time whatever the steps, so the
+// positions written back have to be the same bit for bit
+#define BENCH_RATE_TOLERANCE 0.0f
+
+struct Run {
+	double wallSeconds;
+	long long onsets;
+	double energyBefore;
+	double energyAfter;
+	std::vector<Vector2> positions;
+};
+
+static double kineticEnergy(const std::vector<std::unique_ptr<Enemy>>& entities) {
+	double energy = 0;
+	for (const std::unique_ptr<Enemy>& e : entities) {
+		const Collider& c = *e->getCollider();
+		energy += 0.5 * c.getMass() * dot(c.getVelocity(), c.getVelocity());
+	}
+	return energy;
+}
+
+// Pairs overlapping now, keyed as ContactCache keys them
+static void overlapping(const std::vector<std::unique_ptr<Enemy>>& entities, SpatialGrid& grid, std::unordered_set<uint64_t>& pairs) {
+	grid.clear();
+	for (int i = 0; i < entities.size(); i++) {
+		const Collider& c = *entities[i]->getCollider();
+		grid.insert(i, c.getPos(), c.getRadius());
+	}
+	pairs.clear();
+	std::vector<int> hits;
+	for (int i = 0; i < entities.size(); i++) {
+		const Collider& c = *entities[i]->getCollider();
+		hits.clear();
+		grid.queryCircle(c.getPos(), c.getRadius(), hits);
+		for (int j : hits) {
+			if (j > i) {
+				pairs.insert(ContactCache::getKey(i, j));
+			}
+		}
+	}
+}
+
+static Run run(int bodies, double seconds, double timestep, bool eventDriven) {
+	RuntimePhysics physics;
+	physics.restitution = 1.0f;
+	physics.frictionEnabled = false;
+	physics.speedCapEnabled = false;
+	physics.iterativeSolver = !eventDriven;
+	physics.eventDriven = eventDriven;
+	BasicModel<RuntimePhysics> m(BENCH_WIDTH, BENCH_HEIGHT, physics);
+
+	// a loose lattice so the scene starts without overlaps
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> size(BENCH_MIN_WIDTH_HEIGHT, BENCH_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> velocity(-BENCH_MAX_AXIS_VELOCITY, BENCH_MAX_AXIS_VELOCITY);
+	int side = (int)std::ceil(std::sqrt((double)bodies));
+	float spacing = (float)BENCH_WIDTH / side;
+	std::vector<std::unique_ptr<Enemy>> entities;
+	for (int i = 0; i < bodies; i++) {
+		float widthHeight = std::min(size(rng), spacing * 0.9f);
+		Vector2 pos{ (i % side + 0.5f) * spacing, (i / side + 0.5f) * spacing };
+		Collider c = Collider(pos, Vector2{ velocity(rng), velocity(rng) }, widthHeight, widthHeight * BENCH_MASS_WIDTH_HEIGHT_RATIO);
+		entities.emplace_back(new Enemy(c, "body"));
+		m.addEntity(entities.back().get());
+	}
+
+	Run r;
+	r.onsets = 0;
+	r.wallSeconds = 0;
+	r.energyBefore = kineticEnergy(entities);
+	int steps = (int)std::llround(seconds / timestep);
+	SpatialGrid grid(BENCH_MAX_WIDTH_HEIGHT);
+	std::unordered_set<uint64_t> before, after;
+	overlapping(entities, grid, before);
+	for (int s = 0; s < steps; s++) {
+		long long pairEvents = m.getEventStats().pairEvents;
+		auto start = std::chrono::steady_clock::now();
+		m.update(timestep, Vector2());
+		r.wallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (eventDriven) {
+			r.onsets += m.getEventStats().pairEvents - pairEvents;
+			continue;
+		}
+		// finding the pairs is not part of the step's time
+		overlapping(entities, grid, after);
+		for (uint64_t pair : after) {
+			r.onsets += before.count(pair) == 0 ? 1 : 0;
+		}
+		std::swap(before, after);
+	}
+	r.energyAfter = kineticEnergy(entities);
+	for (const std::unique_ptr<Enemy>& e : entities) {
+		r.positions.push_back(e->getCollider()->getPos());
+	}
+	return r;
+}
+
+static void report(const char* name, const Run& r, double seconds) {
+	printf("%-14s %10lld %14.0f %14.2f %+13.2e\n", name, r.onsets, r.onsets / r.wallSeconds,
+		r.wallSeconds / seconds * 1000, (r.energyAfter - r.energyBefore) / r.energyBefore);
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 400;
+	double seconds = argc > 2 ? atof(argv[2]) : 10;
+
+	Run stepped = run(bodies, seconds, BENCH_TIMESTEP, false);
+	Run events = run(bodies, seconds, BENCH_TIMESTEP, true);
+	printf("%d bodies, %g simulated seconds, steps of %g s\n", bodies, seconds, BENCH_TIMESTEP);
+	printf("%-14s %10s %14s %14s %13s\n", "path", "onsets", "per wall sec", "ms per sim sec", "energy drift");
+	report("time-stepped", stepped, seconds);
+	report("event-driven", events, seconds);
+	int failures = 0;
+	for (const Run* r : { &stepped, &events }) {
+		if (!std::isfinite(r->energyAfter)) {
+			printf("%s energy is not finite\n", r == &stepped ? "time-stepped" : "event-driven");
+			failures++;
+		}
+	}
+
+	// the same simulated time at other frame rates has to land in the same place
+	for (double timestep : { 0.001, 0.05, seconds }) {
+		Run other = run(bodies, seconds, timestep, true);
+		float worst = 0;
+		for (int i = 0; i < bodies; i++) {
+			worst = std::max(worst, getLength(other.positions[i] - events.positions[i]));
+		}
+		printf("event-driven at steps of %g s: max position difference %g\n", timestep, worst);
+		if (!(worst <= BENCH_RATE_TOLERANCE)) {
+			failures++;
+		}
+	}
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
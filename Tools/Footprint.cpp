@@ -0,0 +1,74 @@
+// Reports how much memory a body costs: the fixed record sizes, then the heap
+// growth per body while a dense scene is built and added to a model, against
+// the figure measured before the entity side table and the spatial grid.
+// Linux only (mallinfo2).
+#include "Enemy.h"
+#include "Model.h"
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <string>
+
+// spacing of the scene lattice, about 4 bodies per grid cell
+#define FOOTPRINT_SPACING 16.0f
+#define FOOTPRINT_SIZE 8.0f
+// heap per body at the same scene size when every entity owned its collider
+// and name and the model only kept pointers
+#define FOOTPRINT_BASELINE 112.4
+
+static size_t heapBytes() {
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+}
+
+int main(int argc, char* argv[]) {
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	int side = 1;
+	while (side * side < n) {
+		side++;
+	}
+	printf("record sizes (bytes)\n");
+	printf("  ColliderCore    %3zu  read by every step\n", sizeof(ColliderCore));
+	printf("  Collider        %3zu\n", sizeof(Collider));
+	printf("  Enemy           %3zu  plus allocator overhead\n", sizeof(Enemy));
+	printf("  EntityColdData  %3zu  side table row\n", sizeof(EntityColdData));
+
+	std::vector<Entity*> entities;
+	entities.reserve(n);
+	size_t start = heapBytes();
+	double perBody;
+	{
+		float extent = side * FOOTPRINT_SPACING;
+		Model m((int)extent, (int)extent);
+		NameId name = NamePool::intern("enemy");
+		for (int i = 0; i < n; i++) {
+			Vector2 pos{ (i % side) * FOOTPRINT_SPACING, (i / side) * FOOTPRINT_SPACING };
+			Collider c = Collider(pos, Vector2{ 1, 1 }, FOOTPRINT_SIZE, FOOTPRINT_SIZE * 10);
+			c.setLayer(LAYER_ENEMY);
+			Entity* e = new Enemy(c, name);
+			entities.push_back(e);
+			m.addEntity(e);
+		}
+		perBody = (double)(heapBytes() - start) / n;
+	}
+	double gridPerBody;
+	{
+		// the model's grid on its own, which the baseline did not have
+		size_t before = heapBytes();
+		SpatialGrid grid;
+		for (int i = 0; i < n; i++) {
+			grid.insert(i, entities[i]->getCollider()->getPos(), FOOTPRINT_SIZE / 2);
+		}
+		gridPerBody = (double)(heapBytes() - before) / n;
+	}
+	printf("\n%d bodies, %d names interned, heap per body (bytes)\n", n, NamePool::getCount());
+	printf("  total                  %6.1f\n", perBody);
+	printf("    of which grid        %6.1f\n", gridPerBody);
+	printf("    of which name pool   %6.1f\n", (double)NamePool::getBytes() / n);
+	printf("  baseline               %6.1f  (%.0f%% of it now, %.0f%% without the grid)\n", FOOTPRINT_BASELINE,
+		100 * perBody / FOOTPRINT_BASELINE, 100 * (perBody - gridPerBody) / FOOTPRINT_BASELINE);
+	for (Entity* e : entities) {
+		delete e;
+	}
+	return 0;
+}
@@ -0,0 +1,63 @@
+// Compares BarnesHutTree against direct summation on a random scene at a few
+// opening angles and prints the error and timings for each.
+#include "BarnesHut.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#define BENCH_EXTENT 4000.0f
+#define BENCH_GRAVITY 100.0f
+#define BENCH_COULOMB 50.0f
+
+int main(int argc, char* argv[]) {
+	int n = argc > 1 ? atoi(argv[1]) : 20000;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> position(0, BENCH_EXTENT);
+	std::uniform_real_distribution<float> mass(1, 5);
+	std::uniform_real_distribution<float> charge(-1, 1);
+	std::vector<Vector2> positions(n);
+	std::vector<float> masses(n);
+	std::vector<float> charges(n);
+	for (int i = 0; i < n; i++) {
+		positions[i] = Vector2{ position(rng), position(rng) };
+		masses[i] = mass(rng);
+		charges[i] = charge(rng);
+	}
+
+	ThreadPool pool;
+	ForceSettings settings;
+	settings.gravity = BENCH_GRAVITY;
+	settings.coulomb = BENCH_COULOMB;
+	std::vector<Vector2> reference;
+	auto start = std::chrono::steady_clock::now();
+	BarnesHutTree::computeDirect(positions, masses, charges, settings, reference, &pool);
+	std::chrono::duration<double, std::milli> direct = std::chrono::steady_clock::now() - start;
+	printf("%d bodies, %d threads, direct summation %.2f ms\n", n, pool.getThreadCount(), direct.count());
+	printf("theta  rms error  max error  build ms  walk ms  speedup  interactions\n");
+
+	BarnesHutTree tree;
+	std::vector<Vector2> forces;
+	for (float theta : { 0.2f, 0.35f, 0.5f, 0.7f, 1.0f }) {
+		settings.theta = theta;
+		tree.build(positions, masses, charges, &pool);
+		tree.computeForces(settings, forces, &pool);
+		// errors are relative to the mean force so tiny forces do not dominate
+		double squared = 0;
+		double reference2 = 0;
+		double worst = 0;
+		for (int i = 0; i < n; i++) {
+			Vector2 d = forces[i] - reference[i];
+			squared += dot(d, d);
+			reference2 += dot(reference[i], reference[i]);
+			worst = std::max(worst, (double)getLength(d));
+		}
+		double scale = std::sqrt(reference2 / n);
+		const ForceStats& stats = tree.getStats();
+		double total = stats.buildMilliseconds + stats.traverseMilliseconds;
+		printf("%5.2f  %9.2e  %9.2e  %8.2f  %7.2f  %6.1fx  %lld\n", theta, std::sqrt(squared / n) / scale, worst / scale,
+			stats.buildMilliseconds, stats.traverseMilliseconds, direct.count() / total, stats.interactions);
+	}
+	return 0;
+}
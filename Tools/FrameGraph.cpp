@@ -0,0 +1,127 @@
+// Runs the game's frame as a job graph headless: the model phases in a chain,
+// with a HUD-style job and a snapshot job beside them. Prints the average
+// start and end of every job, the frame wall time, the summed work and the
+// critical path, and checks that the scheduled frames land in exactly the same
+// state as calling update(). Exits with 1 if they do not.
+//
+//   FrameGraph [bodies] [frames]
+#include "Enemy.h"
+#include "JobGraph.h"
+#include "Model.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#define GRAPH_WIDTH 500
+#define GRAPH_HEIGHT 500
+#define GRAPH_MIN_WIDTH_HEIGHT 8
+#define GRAPH_MAX_WIDTH_HEIGHT 40
+#define GRAPH_MAX_AXIS_VELOCITY 60
+#define GRAPH_MASS_WIDTH_HEIGHT_RATIO 10
+#define GRAPH_TIMESTEP 0.01
+// a stand-in for building HUD text, in iterations
+#define GRAPH_HUD_WORK 200000
+
+static void populate(Model& m, std::vector<std::unique_ptr<Enemy>>& entities, int bodies) {
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> size(GRAPH_MIN_WIDTH_HEIGHT, GRAPH_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> velocity(-GRAPH_MAX_AXIS_VELOCITY, GRAPH_MAX_AXIS_VELOCITY);
+	std::uniform_real_distribution<float> unit(0, 1);
+	for (int i = 0; i < bodies; i++) {
+		float widthHeight = size(rng);
+		Vector2 pos{ unit(rng) * (GRAPH_WIDTH - widthHeight) + widthHeight / 2, unit(rng) * (GRAPH_HEIGHT - widthHeight) + widthHeight / 2 };
+		Collider c = Collider(pos, Vector2{ velocity(rng), velocity(rng) }, widthHeight, widthHeight * GRAPH_MASS_WIDTH_HEIGHT_RATIO);
+		c.setLayer(LAYER_ENEMY);
+		entities.emplace_back(new Enemy(c, "enemy"));
+		m.addEntity(entities.back().get());
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 600;
+	int frames = argc > 2 ? atoi(argv[2]) : 200;
+
+	ThreadPool pool;
+	Model reference(GRAPH_WIDTH, GRAPH_HEIGHT);
+	Model scheduled(GRAPH_WIDTH, GRAPH_HEIGHT);
+	std::vector<std::unique_ptr<Enemy>> referenceEntities;
+	std::vector<std::unique_ptr<Enemy>> scheduledEntities;
+	populate(reference, referenceEntities, bodies);
+	populate(scheduled, scheduledEntities, bodies);
+	reference.setThreadPool(&pool);
+	scheduled.setThreadPool(&pool);
+	reference.getSteering().getSettings().enabled = true;
+	scheduled.getSteering().getSettings().enabled = true;
+
+	std::vector<Vector2> snapshot;
+	volatile double hud = 0;
+	JobGraph frame;
+	int input = frame.addJob("input", [] {});
+	int broadphase = frame.addJob("broadphase", [&] { scheduled.broadphase(); }, { input });
+	int steering = frame.addJob("steering", [&] { scheduled.beginFrame(GRAPH_TIMESTEP); }, { broadphase });
+	int narrow = frame.addJob("narrow phase", [&] { scheduled.narrowPhase(); }, { steering });
+	int solve = frame.addJob("solve", [&] { scheduled.solve(); }, { narrow });
+	int integrate = frame.addJob("integrate", [&] { scheduled.integrateFrame(GRAPH_TIMESTEP, Vector2()); }, { solve });
+	int events = frame.addJob("gameplay events", [&] { scheduled.dispatchEvents(); }, { integrate });
+	frame.addJob("snapshot", [&] {
+		snapshot.clear();
+		for (int i = 0; i < scheduled.getEntityCount(); i++) {
+			snapshot.push_back(scheduled.getEntity(i)->getCollider()->getPos());
+		}
+	}, { events });
+	frame.addJob("hud", [&] {
+		double sum = 0;
+		for (int i = 0; i < GRAPH_HUD_WORK; i++) {
+			sum += i * 0.5;
+		}
+		hud = sum;
+	}, { input });
+
+	std::vector<JobTiming> average(frame.getJobCount());
+	double wall = 0;
+	double work = 0;
+	double critical = 0;
+	int mismatches = 0;
+	for (int f = 0; f < frames; f++) {
+		reference.update(GRAPH_TIMESTEP, Vector2());
+		frame.run(&pool);
+		const FrameTiming& timing = frame.getTiming();
+		wall += timing.wallMilliseconds;
+		work += timing.workMilliseconds;
+		critical += timing.criticalPathMilliseconds;
+		for (int j = 0; j < frame.getJobCount(); j++) {
+			average[j].start += timing.jobs[j].start / frames;
+			average[j].end += timing.jobs[j].end / frames;
+		}
+		for (int i = 0; i < bodies; i++) {
+			const Collider& a = *referenceEntities[i]->getCollider();
+			const Collider& b = *scheduledEntities[i]->getCollider();
+			if (getLength(a.getPos() - b.getPos()) != 0 || getLength(a.getVelocity() - b.getVelocity()) != 0) {
+				if (mismatches == 0) {
+					printf("frame %d, body %d differs from update()\n", f, i);
+				}
+				mismatches++;
+				break;
+			}
+		}
+	}
+
+	printf("%d bodies, %d frames on %d threads\n", bodies, frames, pool.getThreadCount());
+	printf("%-16s %10s %10s\n", "job", "start ms", "end ms");
+	for (int j = 0; j < frame.getJobCount(); j++) {
+		printf("%-16s %10.3f %10.3f\n", frame.getName(j).c_str(), average[j].start, average[j].end);
+	}
+	printf("frame %.3f ms, work %.3f ms, critical path %.3f ms\n", wall / frames, work / frames, critical / frames);
+	printf("last critical path:");
+	for (int j : frame.getTiming().criticalPath) {
+		printf(" %s", frame.getName(j).c_str());
+	}
+	printf("\n");
+	if (mismatches > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,230 @@
+// Builds levels of random polylines and static circles and checks the
+// StaticGeometry BVH against testing every shape, then times one static
+// collision pass per body: the four walls alone, the BVH at several level
+// sizes and every shape without the BVH. Then fires fast bodies straight at
+// segments, each far enough to cross one in a single step, and counts the ones
+// that end up on the far side. Last it steps bodies through a level and counts
+// onCollideWall calls and bodies left inside geometry. Exits with 1 if the BVH
+// disagrees with the brute force, a fast body crossed a segment, nothing hit
+// the geometry or bodies ended up inside it.
+//
+//   GeometryBench [bodies] [frames]
+#include "Model.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#define GEOMETRY_WIDTH 2000
+#define GEOMETRY_HEIGHT 2000
+#define GEOMETRY_SEGMENT_LENGTH 20
+#define GEOMETRY_SEGMENTS_PER_POLYLINE 8
+#define GEOMETRY_MIN_CIRCLE 5
+#define GEOMETRY_MAX_CIRCLE 20
+#define GEOMETRY_MIN_WIDTH_HEIGHT 8
+#define GEOMETRY_MAX_WIDTH_HEIGHT 24
+#define GEOMETRY_MAX_AXIS_VELOCITY 60
+#define GEOMETRY_MASS_WIDTH_HEIGHT_RATIO 10
+#define GEOMETRY_TIMESTEP 0.01
+#define GEOMETRY_PROBES 20000
+#define GEOMETRY_PASSES 20
+// bodies may sit this far inside geometry where a push out of one shape went into another
+#define GEOMETRY_TOLERANCE 1.0f
+#define GEOMETRY_SHOTS 10000
+// how far a fast body moves in its step, several of its diameters
+#define GEOMETRY_SHOT_DISTANCE 100.0f
+
+static int wallHits = 0;
+
+class Probe : public Entity {
+public:
+	using Entity::Entity;
+	void onDeath() {}
+	void onCollide() {}
+	void onCollideWall() {
+		wallHits++;
+	}
+};
+
+// random walks of short segments, and a circle for every ten segments
+static std::vector<GeometryShape> makeLevel(int segments, std::mt19937& rng) {
+	std::uniform_real_distribution<float> unit(0, 1);
+	std::vector<GeometryShape> shapes;
+	while (shapes.size() < segments) {
+		Vector2 at{ unit(rng) * GEOMETRY_WIDTH, unit(rng) * GEOMETRY_HEIGHT };
+		float angle = unit(rng) * 6.2832f;
+		for (int s = 0; s < GEOMETRY_SEGMENTS_PER_POLYLINE && shapes.size() < segments; s++) {
+			angle += (unit(rng) - 0.5f) * 1.5f;
+			Vector2 next = at + Vector2{ std::cos(angle), std::sin(angle) } * GEOMETRY_SEGMENT_LENGTH;
+			shapes.push_back(GeometryShape{ GEOMETRY_SEGMENT, at, next, 0 });
+			at = next;
+		}
+	}
+	for (int i = 0; i < segments / 10; i++) {
+		float radius = GEOMETRY_MIN_CIRCLE + unit(rng) * (GEOMETRY_MAX_CIRCLE - GEOMETRY_MIN_CIRCLE);
+		shapes.push_back(GeometryShape{ GEOMETRY_CIRCLE, Vector2{ unit(rng) * GEOMETRY_WIDTH, unit(rng) * GEOMETRY_HEIGHT }, Vector2(), radius });
+	}
+	return shapes;
+}
+
+static float depthInside(const GeometryShape& s, Vector2 p, float radius) {
+	if (s.shape == GEOMETRY_CIRCLE) {
+		return radius + s.radius - getLength(p - s.a);
+	}
+	Vector2 ab = s.b - s.a;
+	float t = std::min(std::max(dot(p - s.a, ab) / dot(ab, ab), 0.0f), 1.0f);
+	return radius - getLength(p - (s.a + ab * t));
+}
+
+static bool overlapsAny(const std::vector<GeometryShape>& shapes, Vector2 p, float radius) {
+	for (const GeometryShape& s : shapes) {
+		if (depthInside(s, p, radius) > 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 1000;
+	int frames = argc > 2 ? atoi(argv[2]) : 300;
+	std::mt19937 rng(31);
+	std::uniform_real_distribution<float> unit(0, 1);
+	std::uniform_real_distribution<float> size(GEOMETRY_MIN_WIDTH_HEIGHT, GEOMETRY_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> velocity(-GEOMETRY_MAX_AXIS_VELOCITY, GEOMETRY_MAX_AXIS_VELOCITY);
+	int failures = 0;
+
+	// the same bodies for every timing, a pass works on copies
+	std::vector<Collider> colliders;
+	for (int i = 0; i < bodies; i++) {
+		float widthHeight = size(rng);
+		Vector2 pos{ unit(rng) * (GEOMETRY_WIDTH - widthHeight) + widthHeight / 2, unit(rng) * (GEOMETRY_HEIGHT - widthHeight) + widthHeight / 2 };
+		colliders.push_back(Collider(pos, Vector2{ velocity(rng), velocity(rng) }, widthHeight, widthHeight * GEOMETRY_MASS_WIDTH_HEIGHT_RATIO));
+	}
+	Model walls(GEOMETRY_WIDTH, GEOMETRY_HEIGHT);
+	double wallNs = 0;
+	for (int pass = 0; pass < GEOMETRY_PASSES; pass++) {
+		std::vector<Collider> work = colliders;
+		auto start = std::chrono::steady_clock::now();
+		for (Collider& c : work) {
+			walls.resolveOutOfBoundsCollision(c);
+		}
+		wallNs += since(start);
+	}
+	printf("%d bodies in %dx%d\n", bodies, GEOMETRY_WIDTH, GEOMETRY_HEIGHT);
+	printf("%-10s %8s %8s %8s %12s %12s %10s\n", "segments", "shapes", "nodes", "depth", "walls ns", "bvh ns", "linear ns");
+
+	for (int segments : { 100, 1000, 10000 }) {
+		std::vector<GeometryShape> shapes = makeLevel(segments, rng);
+		StaticGeometry geometry(shapes);
+
+		int mismatches = 0;
+		for (int i = 0; i < GEOMETRY_PROBES; i++) {
+			Vector2 p{ unit(rng) * GEOMETRY_WIDTH, unit(rng) * GEOMETRY_HEIGHT };
+			float radius = size(rng) / 2;
+			if (geometry.overlaps(p, radius) != overlapsAny(shapes, p, radius)) {
+				mismatches++;
+			}
+		}
+		if (mismatches > 0) {
+			printf("%d segments: %d of %d probes disagree with testing every shape\n", segments, mismatches, GEOMETRY_PROBES);
+			failures++;
+		}
+
+		double bvhNs = 0;
+		double linearNs = 0;
+		int hits = 0;
+		for (int pass = 0; pass < GEOMETRY_PASSES; pass++) {
+			std::vector<Collider> work = colliders;
+			auto start = std::chrono::steady_clock::now();
+			for (Collider& c : work) {
+				walls.resolveOutOfBoundsCollision(c);
+				Vector2 pos = c.getPos();
+				Vector2 vel = c.getVelocity();
+				// as if it got here in the last step
+				hits += geometry.collide(pos - vel * (float)GEOMETRY_TIMESTEP, pos, vel, c.getRadius()) ? 1 : 0;
+			}
+			bvhNs += since(start);
+			start = std::chrono::steady_clock::now();
+			for (const Collider& c : colliders) {
+				hits += overlapsAny(shapes, c.getPos(), c.getRadius()) ? 1 : 0;
+			}
+			linearNs += since(start);
+		}
+		const GeometryStats& stats = geometry.getStats();
+		double perBody = (double)bodies * GEOMETRY_PASSES;
+		printf("%-10d %8d %8d %8d %12.1f %12.1f %10.1f\n", segments, stats.shapes, stats.nodes, stats.depth,
+			wallNs / perBody, bvhNs / perBody, linearNs / perBody);
+	}
+
+	// each shot starts clear of a segment and would end its step beyond it; the
+	// same shot tested only where it ends shows what the path test is for
+	std::vector<GeometryShape> shapes = makeLevel(1000, rng);
+	StaticGeometry level(shapes);
+	int crossed = 0;
+	int crossedAtEnd = 0;
+	for (int shot = 0; shot < GEOMETRY_SHOTS; shot++) {
+		const GeometryShape& s = shapes[(int)(unit(rng) * (shapes.size() - shapes.size() / 11))];
+		Vector2 ab = s.b - s.a;
+		Vector2 side = Vector2{ -ab.Y, ab.X } / getLength(ab);
+		Vector2 middle = s.a + ab * (0.25f + 0.5f * unit(rng));
+		float radius = size(rng) / 2;
+		Vector2 from = middle + side * (radius + 1 + unit(rng) * 10);
+		if (level.overlaps(from, radius)) {
+			continue;
+		}
+		Vector2 to = from - side * GEOMETRY_SHOT_DISTANCE;
+		Vector2 vel = side * -(GEOMETRY_SHOT_DISTANCE / (float)GEOMETRY_TIMESTEP);
+		Vector2 pos = to;
+		Vector2 v = vel;
+		level.collide(from, pos, v, radius);
+		crossed += dot(pos - middle, side) < 0 ? 1 : 0;
+		pos = to;
+		v = vel;
+		level.collide(to, pos, v, radius);
+		crossedAtEnd += dot(pos - middle, side) < 0 ? 1 : 0;
+	}
+	printf("%d fast shots at segments: %d crossed one, %d would have without the path test\n", GEOMETRY_SHOTS, crossed, crossedAtEnd);
+	if (crossed > 0) {
+		failures++;
+	}
+
+	// a full model run through a level, bodies start clear of the geometry
+	Model m(GEOMETRY_WIDTH, GEOMETRY_HEIGHT);
+	m.setGeometry(level);
+	std::vector<std::unique_ptr<Entity>> entities;
+	for (const Collider& c : colliders) {
+		if (!m.getGeometry().overlaps(c.getPos(), c.getRadius())) {
+			entities.emplace_back(new Probe(c, "probe"));
+			m.addEntity(entities.back().get());
+		}
+	}
+	for (int f = 0; f < frames; f++) {
+		m.update(GEOMETRY_TIMESTEP, Vector2());
+	}
+	int inside = 0;
+	for (int i = 0; i < m.getEntityCount(); i++) {
+		const Collider& c = *m.getEntity(i)->getCollider();
+		for (const GeometryShape& s : shapes) {
+			if (depthInside(s, c.getPos(), c.getRadius()) > GEOMETRY_TOLERANCE) {
+				inside++;
+				break;
+			}
+		}
+	}
+	printf("%d bodies through %d frames: %d wall and geometry hits, %d bodies inside geometry\n", m.getEntityCount(), frames, wallHits, inside);
+	if (wallHits == 0 || inside > 0) {
+		failures++;
+	}
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,145 @@
+// Checks the timestamped input path. A producer thread presses keys at random
+// times into an InputQueue while paced frames drain it into Model, the way
+// the window thread and the game loop do. Verifies that no press is lost or
+// reordered and that every change lands inside its step, checks that a change
+// part way through a step splits the player's step there, and prints
+// input-to-simulation and input-to-present latency.
+//
+//   InputCheck [seconds] [presses per second]
+#include "FramePacer.h"
+#include "InputQueue.h"
+#include "Model.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#define INPUT_WIDTH 500
+#define INPUT_HEIGHT 500
+#define INPUT_FRAMES_PER_SECOND 100
+
+static void print(const char* name, const LatencyStats& stats) {
+	printf("%-22s %8d %10.3f %10.3f %10.3f %10.3f\n", name, stats.samples, stats.mean, stats.p50, stats.p99, stats.max);
+}
+
+static int checkSplit() {
+	// a quarter step left, then down for the rest. Without friction the first
+	// piece ends with a quarter of the impulse to the left, which the player
+	// coasts on for the other three quarters of the step
+	RuntimePhysics physics;
+	physics.frictionEnabled = false;
+	BasicModel<RuntimePhysics> m(INPUT_WIDTH, INPUT_HEIGHT, physics);
+	Collider hitbox = Collider(Vector2{ 250, 250 }, Vector2(), 8, 1);
+	Player p(hitbox, "Player");
+	p.setLogging(false);
+	m.addEntity(&p);
+	m.setPlayer(&p);
+	double step = 0.01;
+	std::vector<DirectionChange> changes = { DirectionChange{ step / 4, Vector2{ 0, 1 } } };
+	m.update(step, Vector2{ -1, 0 }, changes);
+	float speed = physics.playerSpeed;
+	Vector2 v = p.getCollider()->getVelocity();
+	Vector2 pos = p.getCollider()->getPos();
+	Vector2 expectedV{ -speed / 4, speed * 3 / 4 };
+	Vector2 expectedPos{ 250 - speed / 4 * (float)(step * 3 / 4), 250 };
+	printf("change a quarter way through a step: velocity (%g, %g), expected (%g, %g); position (%g, %g), expected (%g, %g)\n",
+		v.X, v.Y, expectedV.X, expectedV.Y, pos.X, pos.Y, expectedPos.X, expectedPos.Y);
+	return getLength(v - expectedV) <= 1e-4f * speed && getLength(pos - expectedPos) <= 1e-4f ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+	double seconds = argc > 1 ? atof(argv[1]) : 3;
+	double pressRate = argc > 2 ? atof(argv[2]) : 300;
+	int failures = checkSplit();
+
+	Model m(INPUT_WIDTH, INPUT_HEIGHT);
+	Collider hitbox = Collider(Vector2{ 250, 250 }, Vector2(), 8, 1);
+	Player p(hitbox, "Player");
+	p.setLogging(false);
+	m.addEntity(&p);
+	m.setPlayer(&p);
+
+	InputQueue queue;
+	InputLatency latency;
+	std::atomic<bool> running(true);
+	std::atomic<int> pushed(0);
+	std::atomic<int> dropped(0);
+	std::thread producer([&] {
+		const Vector2 directions[] = { Vector2{ 0, -1 }, Vector2{ -1, 0 }, Vector2{ 0, 1 }, Vector2{ 1, 0 } };
+		std::mt19937 rng(9);
+		std::exponential_distribution<double> gap(pressRate);
+		int sequence = 0;
+		while (running) {
+			std::this_thread::sleep_for(std::chrono::duration<double>(gap(rng)));
+			// the direction encodes the sequence number so order can be checked
+			if (queue.push(InputEvent{ directions[sequence % 4], std::chrono::steady_clock::now() })) {
+				sequence++;
+				pushed++;
+			}
+			else {
+				dropped++;
+			}
+		}
+	});
+
+	FramePacer pacer(INPUT_FRAMES_PER_SECOND);
+	std::vector<DirectionChange> changes;
+	Vector2 held;
+	int collected = 0;
+	int outOfStep = 0;
+	int outOfOrder = 0;
+	int frames = (int)(seconds * INPUT_FRAMES_PER_SECOND);
+	const Vector2 directions[] = { Vector2{ 0, -1 }, Vector2{ -1, 0 }, Vector2{ 0, 1 }, Vector2{ 1, 0 } };
+	pacer.start();
+	for (int f = 0; f <= frames; f++) {
+		if (f == frames) {
+			// drain whatever is left after the producer stopped
+			running = false;
+			producer.join();
+		}
+		double elapsed = pacer.wait();
+		auto frameEnd = std::chrono::steady_clock::now();
+		auto frameStart = frameEnd - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(elapsed));
+		queue.collect(frameStart, frameEnd, changes, &latency);
+		double previous = 0;
+		for (const DirectionChange& c : changes) {
+			if (c.offset < previous || c.offset > elapsed + 1e-9) {
+				outOfStep++;
+			}
+			previous = c.offset;
+			if (getLength(c.direction - directions[collected % 4]) != 0) {
+				outOfOrder++;
+			}
+			collected++;
+		}
+		m.update(elapsed, held, changes);
+		if (!changes.empty()) {
+			held = changes.back().direction;
+		}
+		latency.simulated(std::chrono::steady_clock::now());
+		// nothing to draw headless, the frame counts as presented once simulated
+		latency.captured();
+		latency.presented(std::chrono::steady_clock::now());
+	}
+	InputEvent rest;
+	while (queue.pop(rest)) {
+		collected++;
+	}
+
+	printf("%d presses, %d collected, %d dropped by a full queue, %d outside their step, %d out of order\n",
+		pushed.load(), collected, dropped.load(), outOfStep, outOfOrder);
+	printf("%-22s %8s %10s %10s %10s %10s\n", "latency", "samples", "mean ms", "p50 ms", "p99 ms", "max ms");
+	print("input to simulation", latency.getSimulationStats());
+	print("input to present", latency.getPresentStats());
+	if (collected != pushed || outOfStep > 0 || outOfOrder > 0) {
+		failures++;
+	}
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
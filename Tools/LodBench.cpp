@@ -0,0 +1,131 @@
+// Steps a large world with the player in the middle at full fidelity and with
+// LOD rings around the player. Full fidelity is a single level that steps every
+// body every frame, so both runs take their pairs from the grid and the
+// difference is what the rings save. Prints the average fraction of bodies on
+// each level, the pairs visited and integrations skipped, the frame time of
+// both runs and the saving, and the p99 and max distance a body is drawn moving
+// in one frame for both runs. Popping is how much further a body is drawn moving
+// than its velocity carries it in a frame, which stays at what collisions cause
+// at full fidelity and grows if bodies jump when they step or change rings.
+// Hysteresis is judged by the level changes per frame and how many of them go
+// back to the level left less than LOD_REVERSAL_FRAMES frames before.
+//
+//   LodBench [bodies] [frames]
+#include "Enemy.h"
+#include "Model.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#define LOD_WIDTH 2000
+#define LOD_HEIGHT 2000
+#define LOD_MIN_WIDTH_HEIGHT 8
+#define LOD_MAX_WIDTH_HEIGHT 24
+#define LOD_MAX_AXIS_VELOCITY 60
+#define LOD_MASS_WIDTH_HEIGHT_RATIO 10
+#define LOD_TIMESTEP 0.01
+
+struct Run {
+	double milliseconds = 0;
+	std::vector<double> levelFractions;
+	long long visitedPairs = 0;
+	long long skippedSteps = 0;
+	std::vector<float> moves;
+	std::vector<float> pops;
+	long long changes = 0;
+	long long reversals = 0;
+};
+
+static Run run(int bodies, int frames, bool lod) {
+	Model m(LOD_WIDTH, LOD_HEIGHT);
+	std::vector<std::unique_ptr<Entity>> entities;
+	std::mt19937 rng(21);
+	std::uniform_real_distribution<float> size(LOD_MIN_WIDTH_HEIGHT, LOD_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> velocity(-LOD_MAX_AXIS_VELOCITY, LOD_MAX_AXIS_VELOCITY);
+	std::uniform_real_distribution<float> unit(0, 1);
+	for (int i = 0; i < bodies; i++) {
+		float widthHeight = size(rng);
+		Vector2 pos{ unit(rng) * (LOD_WIDTH - widthHeight) + widthHeight / 2, unit(rng) * (LOD_HEIGHT - widthHeight) + widthHeight / 2 };
+		Collider c = Collider(pos, Vector2{ velocity(rng), velocity(rng) }, widthHeight, widthHeight * LOD_MASS_WIDTH_HEIGHT_RATIO);
+		c.setLayer(LAYER_ENEMY);
+		entities.emplace_back(new Enemy(c, "enemy"));
+		m.addEntity(entities.back().get());
+	}
+	// the player sits still in the middle, nothing collides with it
+	Collider hitbox = Collider(Vector2{ LOD_WIDTH / 2, LOD_HEIGHT / 2 }, Vector2(), LOD_MIN_WIDTH_HEIGHT, 1);
+	hitbox.setBodyType(BODY_KINEMATIC);
+	hitbox.setLayer(LAYER_PLAYER);
+	hitbox.setMask(0);
+	Player* p = new Player(hitbox, "Player");
+	p->setLogging(false);
+	entities.emplace_back(p);
+	m.addEntity(p);
+	m.setPlayer(p);
+	m.getLodSettings().enabled = true;
+	if (!lod) {
+		m.getLodSettings().levels = { LodLevel{ FLT_MAX, 1, false } };
+	}
+
+	Run r;
+	int n = m.getEntityCount();
+	std::vector<Vector2> drawn(n);
+	for (int i = 0; i < n; i++) {
+		drawn[i] = m.getDisplayPosition(i);
+	}
+	for (int f = 0; f < frames; f++) {
+		auto start = std::chrono::steady_clock::now();
+		m.update(LOD_TIMESTEP, Vector2());
+		r.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		const LodStats& stats = m.getLodStats();
+		r.levelFractions.resize(stats.bodies.size());
+		for (int l = 0; l < stats.bodies.size(); l++) {
+			r.levelFractions[l] += stats.getFraction(l) / frames;
+		}
+		r.visitedPairs += (long long)n * (n - 1) / 2 - stats.skippedPairs;
+		r.skippedSteps += stats.skippedSteps;
+		// the first frame places every body on its ring
+		if (f > 0) {
+			r.changes += stats.changes;
+			r.reversals += stats.reversals;
+		}
+		for (int i = 0; i < n; i++) {
+			Vector2 now = m.getDisplayPosition(i);
+			float move = getLength(now - drawn[i]);
+			r.moves.push_back(move);
+			r.pops.push_back(std::max(0.0f, move - getLength(m.getEntity(i)->getCollider()->getVelocity()) * (float)LOD_TIMESTEP));
+			drawn[i] = now;
+		}
+	}
+	std::sort(r.moves.begin(), r.moves.end());
+	std::sort(r.pops.begin(), r.pops.end());
+	return r;
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 2000;
+	int frames = argc > 2 ? atoi(argv[2]) : 200;
+
+	Run full = run(bodies, frames, false);
+	Run lod = run(bodies, frames, true);
+	LodSettings settings;
+	printf("%d bodies in %dx%d, %d frames\n", bodies, LOD_WIDTH, LOD_HEIGHT, frames);
+	for (int l = 0; l < lod.levelFractions.size(); l++) {
+		printf("level %d (radius %g, every %d frames%s): %.1f%% of bodies\n", l, settings.levels[l].radius,
+			settings.levels[l].interval, settings.levels[l].coarse ? ", coarse" : "", lod.levelFractions[l] * 100);
+	}
+	printf("pairs visited per frame: %lld at full fidelity, %lld with LOD\n", full.visitedPairs / frames, lod.visitedPairs / frames);
+	printf("integrations skipped per frame: %lld\n", lod.skippedSteps / frames);
+	printf("level changes per frame: %.2f, %lld of %lld back to the level left within %d frames\n",
+		frames > 1 ? (double)lod.changes / (frames - 1) : 0.0, lod.reversals, lod.changes, LOD_REVERSAL_FRAMES);
+	printf("%-6s %12s %14s %14s %14s %14s\n", "run", "ms/frame", "p99 move", "max move", "p99 pop", "max pop");
+	for (const Run* r : { &full, &lod }) {
+		printf("%-6s %12.3f %14.3f %14.3f %14.3f %14.3f\n", r == &full ? "full" : "lod", r->milliseconds / frames,
+			r->moves[r->moves.size() * 99 / 100], r->moves.back(), r->pops[r->pops.size() * 99 / 100], r->pops.back());
+	}
+	printf("frame cost saved: %.1f%%\n", (1 - lod.milliseconds / full.milliseconds) * 100);
+	return 0;
+}
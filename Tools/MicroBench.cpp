@@ -0,0 +1,317 @@
+// Microbenchmarks for the building blocks of a step: Vector2 arithmetic, the
+// circle narrow phase, collision response, velocity writes and integration,
+// and whole update() calls. The model cases run once on Model, whose physics
+// parameters are compile-time constants, and once as runtime_ on
+// BasicModel<RuntimePhysics> with the same values held as data. Inputs follow
+// the game's scene settings. Results go out as JSON for BenchCompare.
+#include "Enemy.h"
+#include "Model.h"
+#include "Vector2Batch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// elements per pass, small enough to stay in cache
+#define BENCH_INPUTS 4096
+#define BENCH_SAMPLES 7
+#define BENCH_SAMPLE_MS 20.0
+// scene settings from GameLoop.cpp
+#define BENCH_WIDTH 500
+#define BENCH_HEIGHT 500
+#define BENCH_MIN_WIDTH_HEIGHT 8
+#define BENCH_MAX_WIDTH_HEIGHT 40
+#define BENCH_MAX_AXIS_VELOCITY 60
+#define BENCH_MASS_WIDTH_HEIGHT_RATIO 10
+#define BENCH_TIMESTEP 0.01
+// update() scenes have the game's density in a world sixteen times its size
+#define BENCH_SCENE_BODIES 240
+#define BENCH_SCENE_WIDTH 2000
+#define BENCH_SCENE_HEIGHT 2000
+
+struct BenchResult {
+	std::string name;
+	double nsPerOp;
+	double minNsPerOp;
+	long long operations;
+};
+
+static volatile float sink;
+
+// Times body() over BENCH_SAMPLES samples of at least BENCH_SAMPLE_MS each, a
+// pass being inputs operations. reset() runs before every pass and is not timed.
+static BenchResult measure(const char* name, const std::function<void()>& reset, const std::function<float()>& body, int inputs) {
+	using clock = std::chrono::steady_clock;
+	reset();
+	sink = body();
+	std::vector<double> samples;
+	long long operations = 0;
+	for (int s = 0; s < BENCH_SAMPLES; s++) {
+		double elapsed = 0;
+		long long passes = 0;
+		while (elapsed < BENCH_SAMPLE_MS * 1e6) {
+			reset();
+			auto start = clock::now();
+			sink = body();
+			elapsed += std::chrono::duration<double, std::nano>(clock::now() - start).count();
+			passes++;
+		}
+		samples.push_back(elapsed / (passes * inputs));
+		operations += passes * inputs;
+	}
+	std::sort(samples.begin(), samples.end());
+	return BenchResult{ name, samples[samples.size() / 2], samples[0], operations };
+}
+
+static void nothing() {}
+
+static Collider randomCollider(std::mt19937& rng) {
+	std::uniform_real_distribution<float> size(BENCH_MIN_WIDTH_HEIGHT, BENCH_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> x(0, BENCH_WIDTH);
+	std::uniform_real_distribution<float> y(0, BENCH_HEIGHT);
+	std::uniform_real_distribution<float> v(-BENCH_MAX_AXIS_VELOCITY, BENCH_MAX_AXIS_VELOCITY);
+	float widthHeight = size(rng);
+	return Collider(Vector2{ x(rng), y(rng) }, Vector2{ v(rng), v(rng) }, widthHeight, widthHeight * BENCH_MASS_WIDTH_HEIGHT_RATIO);
+}
+
+// second body of a pair, placed at a random angle and at a distance that is a
+// random fraction (minGap..maxGap) of the two radii
+static Collider partner(std::mt19937& rng, const Collider& first, float minGap, float maxGap) {
+	std::uniform_real_distribution<float> angle(0, 6.2831853f);
+	std::uniform_real_distribution<float> gap(minGap, maxGap);
+	Collider second = randomCollider(rng);
+	float a = angle(rng);
+	float distance = gap(rng) * (first.getRadius() + second.getRadius());
+	second.setPosition(first.getPos() + Vector2{ std::cos(a), std::sin(a) } * distance);
+	return second;
+}
+
+// The same scene for every policy: a model of enemies whose colliders are put
+// back before every timed update
+template <typename Physics>
+class SceneBench {
+public:
+	SceneBench(const std::vector<Collider>& colliders) : _model(BENCH_SCENE_WIDTH, BENCH_SCENE_HEIGHT), _colliders(colliders) {
+		for (const Collider& c : _colliders) {
+			_entities.emplace_back(new Enemy(c, "enemy"));
+			_model.addEntity(_entities.back().get());
+		}
+	}
+	void reset() {
+		for (int i = 0; i < _colliders.size(); i++) {
+			*_entities[i]->editCollider() = _colliders[i];
+			_entities[i]->setActive(true);
+		}
+		_model.resync();
+	}
+	float update() {
+		_model.update(BENCH_TIMESTEP, Vector2());
+		return _entities.back()->getCollider()->getPos().X;
+	}
+private:
+	BasicModel<Physics> _model;
+	std::vector<Collider> _colliders;
+	std::vector<std::unique_ptr<Entity>> _entities;
+};
+
+int main(int argc, char* argv[]) {
+	const char* outPath = nullptr;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else {
+			fprintf(stderr, "usage: MicroBench [--out file] [--filter substring]\n");
+			return 1;
+		}
+	}
+
+	std::mt19937 rng(20);
+	std::uniform_real_distribution<float> position(0, BENCH_WIDTH);
+	std::uniform_real_distribution<float> velocity(-BENCH_MAX_AXIS_VELOCITY, BENCH_MAX_AXIS_VELOCITY);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	std::vector<Vector2> a(BENCH_INPUTS), b(BENCH_INPUTS), out(BENCH_INPUTS);
+	std::vector<float> f(BENCH_INPUTS);
+	std::vector<float> ax(BENCH_INPUTS), ay(BENCH_INPUTS), bx(BENCH_INPUTS), by(BENCH_INPUTS), lengths(BENCH_INPUTS);
+	for (int i = 0; i < BENCH_INPUTS; i++) {
+		a[i] = Vector2{ position(rng), position(rng) };
+		b[i] = Vector2{ velocity(rng), velocity(rng) };
+		if (b[i].X == 0 || b[i].Y == 0) {
+			b[i] = Vector2{ 1, 1 };
+		}
+		f[i] = scale(rng);
+		ax[i] = a[i].X;
+		ay[i] = a[i].Y;
+		bx[i] = b[i].X;
+		by[i] = b[i].Y;
+	}
+
+	// narrow phase pairs as the broad phase hands them over, about two in
+	// three overlapping; response pairs always overlap
+	std::vector<Collider> pairs, overlapping;
+	for (int i = 0; i < BENCH_INPUTS; i++) {
+		Collider first = randomCollider(rng);
+		pairs.push_back(first);
+		pairs.push_back(partner(rng, first, 0.0f, 1.5f));
+		first = randomCollider(rng);
+		overlapping.push_back(first);
+		overlapping.push_back(partner(rng, first, 0.2f, 1.0f));
+	}
+	std::vector<Collider> working = overlapping;
+	std::vector<Collider> bodies;
+	for (int i = 0; i < BENCH_INPUTS; i++) {
+		bodies.push_back(randomCollider(rng));
+	}
+	std::vector<Collider> movingBodies = bodies;
+	Model m(BENCH_WIDTH, BENCH_HEIGHT);
+	BasicModel<RuntimePhysics> runtime(BENCH_WIDTH, BENCH_HEIGHT);
+	std::vector<Collider> scene;
+	std::uniform_real_distribution<float> sceneX(0, BENCH_SCENE_WIDTH);
+	std::uniform_real_distribution<float> sceneY(0, BENCH_SCENE_HEIGHT);
+	for (int i = 0; i < BENCH_SCENE_BODIES; i++) {
+		Collider c = randomCollider(rng);
+		c.setPosition(Vector2{ sceneX(rng), sceneY(rng) });
+		c.setLayer(LAYER_ENEMY);
+		scene.push_back(c);
+	}
+	SceneBench<DefaultPhysics> defaultScene(scene);
+	SceneBench<RuntimePhysics> runtimeScene(scene);
+
+	struct Case {
+		const char* name;
+		std::function<void()> reset;
+		std::function<float()> body;
+		int inputs = BENCH_INPUTS;
+	};
+	std::vector<Case> cases = {
+		{ "vector2_add", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) out[i] = a[i] + b[i];
+			return out[BENCH_INPUTS - 1].X;
+		} },
+		{ "vector2_sub", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) out[i] = a[i] - b[i];
+			return out[BENCH_INPUTS - 1].X;
+		} },
+		{ "vector2_mul", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) out[i] = a[i] * b[i];
+			return out[BENCH_INPUTS - 1].X;
+		} },
+		{ "vector2_div", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) out[i] = a[i] / b[i];
+			return out[BENCH_INPUTS - 1].X;
+		} },
+		{ "vector2_scale", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) out[i] = a[i] * f[i];
+			return out[BENCH_INPUTS - 1].X;
+		} },
+		{ "vector2_add_assign", nothing, [&]() {
+			Vector2 sum = Vector2();
+			for (int i = 0; i < BENCH_INPUTS; i++) sum += b[i];
+			return sum.X;
+		} },
+		{ "vector2_dot", nothing, [&]() {
+			float sum = 0;
+			for (int i = 0; i < BENCH_INPUTS; i++) sum += dot(a[i], b[i]);
+			return sum;
+		} },
+		{ "vector2_getLength", nothing, [&]() {
+			float sum = 0;
+			for (int i = 0; i < BENCH_INPUTS; i++) sum += getLength(b[i]);
+			return sum;
+		} },
+		// the same work on 8-lane batches from struct-of-arrays input, still
+		// reported per vector
+		{ "vector2x8_add", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i += 8) {
+				Vector2x8 sum = Vector2x8::load(&ax[i], &ay[i]) + Vector2x8::load(&bx[i], &by[i]);
+				sum.store(&ax[i], &ay[i]);
+			}
+			return ax[BENCH_INPUTS - 1];
+		} },
+		{ "vector2x8_getLength", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i += 8) {
+				getLength(Vector2x8::load(&bx[i], &by[i])).store(&lengths[i]);
+			}
+			return lengths[BENCH_INPUTS - 1];
+		} },
+		{ "vector2x8_normalize", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i += 8) {
+				normalize(Vector2x8::load(&bx[i], &by[i])).store(&ax[i], &ay[i]);
+			}
+			return ax[BENCH_INPUTS - 1];
+		} },
+		{ "model_checkCircleCollision", nothing, [&]() {
+			int hits = 0;
+			for (int i = 0; i < BENCH_INPUTS; i++) {
+				const Collider& c1 = pairs[2 * i];
+				const Collider& c2 = pairs[2 * i + 1];
+				hits += m.checkCircleCollision(c1.getPos(), c1.getRadius(), c2.getPos(), c2.getRadius());
+			}
+			return (float)hits;
+		} },
+		{ "model_resolveCollision", [&]() { working = overlapping; }, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) m.resolveCollision(working[2 * i], working[2 * i + 1]);
+			return working[0].getVelocity().X;
+		} },
+		{ "runtime_resolveCollision", [&]() { working = overlapping; }, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) runtime.resolveCollision(working[2 * i], working[2 * i + 1]);
+			return working[0].getVelocity().X;
+		} },
+		// the speed cap the model applies on every velocity write
+		{ "model_setVelocity", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) m.setVelocity(bodies[i], b[i] * f[i] * 2.0f);
+			return bodies[BENCH_INPUTS - 1].getVelocity().X;
+		} },
+		{ "runtime_setVelocity", nothing, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) runtime.setVelocity(bodies[i], b[i] * f[i] * 2.0f);
+			return bodies[BENCH_INPUTS - 1].getVelocity().X;
+		} },
+		{ "model_physicsStep", [&]() { movingBodies = bodies; }, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) m.physicsStep(movingBodies[i], BENCH_TIMESTEP);
+			return movingBodies[BENCH_INPUTS - 1].getPos().X;
+		} },
+		{ "runtime_physicsStep", [&]() { movingBodies = bodies; }, [&]() {
+			for (int i = 0; i < BENCH_INPUTS; i++) runtime.physicsStep(movingBodies[i], BENCH_TIMESTEP);
+			return movingBodies[BENCH_INPUTS - 1].getPos().X;
+		} },
+		// a whole step, per body
+		{ "model_update", [&]() { defaultScene.reset(); }, [&]() { return defaultScene.update(); }, BENCH_SCENE_BODIES },
+		{ "runtime_update", [&]() { runtimeScene.reset(); }, [&]() { return runtimeScene.update(); }, BENCH_SCENE_BODIES },
+	};
+
+	std::vector<BenchResult> results;
+	for (const Case& c : cases) {
+		if (filter != nullptr && strstr(c.name, filter) == nullptr) {
+			continue;
+		}
+		results.push_back(measure(c.name, c.reset, c.body, c.inputs));
+		fprintf(stderr, "%-28s %8.3f ns/op\n", c.name, results.back().nsPerOp);
+	}
+
+	FILE* file = outPath != nullptr ? fopen(outPath, "w") : stdout;
+	if (file == nullptr) {
+		fprintf(stderr, "could not write %s\n", outPath);
+		return 1;
+	}
+	fprintf(file, "{\n  \"suite\": \"MicroBench\",\n  \"inputs\": %d,\n  \"benchmarks\": [\n", BENCH_INPUTS);
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		fprintf(file, "    { \"name\": \"%s\", \"ns_per_op\": %.4f, \"min_ns_per_op\": %.4f, \"operations\": %lld }%s\n",
+			r.name.c_str(), r.nsPerOp, r.minNsPerOp, r.operations, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	if (file != stdout) {
+		fclose(file);
+	}
+	return 0;
+}
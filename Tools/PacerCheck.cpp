@@ -0,0 +1,169 @@
+// Headless frame pacing: steps a model at a target frame rate with
+// FramePacer and with the old approach of sleeping for whatever is left of the
+// frame, taking turns every half second so both see the same load on the
+// machine, and prints p50/p99/max frame times and missed deadlines for both.
+// The sleeping loop has no deadlines, so a frame that ran longer than a period
+// plus the pacer's miss allowance counts as missed there. By default exits
+// with 1 only if the pacer does worse than the sleeping loop: a p99 more than
+// 10% over the sleeping loop's (or the period, if that is larger) or more than
+// 2% of frames missed beyond the sleeping loop's. --max-p99 and --max-missed
+// set absolute bounds instead, meant for an otherwise idle machine. With
+// --stats the paced run publishes live stats for StatsTail to read.
+//
+//   PacerCheck [--rate fps] [--seconds s] [--bodies n] [--max-p99 ms] [--max-missed fraction] [--stats]
+#include "Enemy.h"
+#include "FramePacer.h"
+#include "Model.h"
+#include "StatsSegment.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+
+#define PACER_WIDTH 500
+#define PACER_HEIGHT 500
+#define PACER_MIN_WIDTH_HEIGHT 8
+#define PACER_MAX_WIDTH_HEIGHT 40
+#define PACER_MAX_AXIS_VELOCITY 60
+#define PACER_MASS_WIDTH_HEIGHT_RATIO 10
+#define PACER_P99_FACTOR 1.1
+#define PACER_MAX_EXTRA_MISSED 0.02
+#define PACER_ROUND_SECONDS 0.5
+
+struct Scene {
+	Scene(int bodies) : model(PACER_WIDTH, PACER_HEIGHT) {
+		std::mt19937 rng(5);
+		std::uniform_real_distribution<float> size(PACER_MIN_WIDTH_HEIGHT, PACER_MAX_WIDTH_HEIGHT);
+		std::uniform_real_distribution<float> velocity(-PACER_MAX_AXIS_VELOCITY, PACER_MAX_AXIS_VELOCITY);
+		std::uniform_real_distribution<float> unit(0, 1);
+		for (int i = 0; i < bodies; i++) {
+			float widthHeight = size(rng);
+			Vector2 pos{ unit(rng) * (PACER_WIDTH - widthHeight) + widthHeight / 2, unit(rng) * (PACER_HEIGHT - widthHeight) + widthHeight / 2 };
+			Collider c = Collider(pos, Vector2{ velocity(rng), velocity(rng) }, widthHeight, widthHeight * PACER_MASS_WIDTH_HEIGHT_RATIO);
+			entities.emplace_back(new Enemy(c, "enemy"));
+			model.addEntity(entities.back().get());
+		}
+	}
+	Model model;
+	std::vector<std::unique_ptr<Enemy>> entities;
+};
+
+static void print(const char* name, const PacingStats& stats) {
+	printf("%-8s %8d %8d %10.3f %10.3f %10.3f %10.3f\n", name, stats.frames, stats.missed, stats.mean, stats.p50, stats.p99, stats.max);
+}
+
+int main(int argc, char* argv[]) {
+	double rate = 100;
+	double seconds = 5;
+	int bodies = 200;
+	double maxP99 = 0;
+	double maxMissed = -1;
+	bool publish = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--bodies") == 0 && i + 1 < argc) {
+			bodies = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--max-p99") == 0 && i + 1 < argc) {
+			maxP99 = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--max-missed") == 0 && i + 1 < argc) {
+			maxMissed = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--stats") == 0) {
+			publish = true;
+		}
+		else {
+			printf("usage: PacerCheck [--rate fps] [--seconds s] [--bodies n] [--max-p99 ms] [--max-missed fraction] [--stats]\n");
+			return 2;
+		}
+	}
+	if (rate <= 0) {
+		printf("rate must be positive\n");
+		return 2;
+	}
+	int frames = (int)(rate * seconds);
+	int roundFrames = std::max(1, (int)(rate * PACER_ROUND_SECONDS));
+	double periodMs = 1000 / rate;
+
+	Scene paced(bodies);
+	Scene slept(bodies);
+	FramePacer pacer(rate);
+	StatsSegment stats;
+	if (publish && !stats.create()) {
+		printf("Could not create the stats segment\n");
+		return EXIT_FAILURE;
+	}
+	PacingStats naive;
+	std::vector<double> times;
+	for (int done = 0; done < frames; done += roundFrames) {
+		int count = std::min(roundFrames, frames - done);
+		pacer.start();
+		for (int f = 0; f < count; f++) {
+			double elapsed = pacer.wait();
+			auto start = std::chrono::steady_clock::now();
+			paced.model.update(elapsed, Vector2());
+			if (publish) {
+				stats.recordModel(paced.model, elapsed);
+				stats.recordFrame(elapsed * 1000, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), pacer.getMissed());
+				stats.publish();
+			}
+		}
+
+		// sleep for the rest of the frame, as the game loop used to
+		auto previous = std::chrono::steady_clock::now();
+		for (int f = 0; f < count; f++) {
+			auto current = std::chrono::steady_clock::now();
+			double elapsed = std::chrono::duration<double>(current - previous).count();
+			previous = current;
+			if (f > 0) {
+				times.push_back(elapsed * 1000);
+			}
+			slept.model.update(elapsed, Vector2());
+			double busy = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - current).count();
+			if (busy < periodMs) {
+				std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(periodMs - busy));
+			}
+		}
+	}
+	stats.close();
+	std::sort(times.begin(), times.end());
+	naive.frames = (int)times.size();
+	for (double t : times) {
+		naive.mean += t / times.size();
+		// late by more than the pacer allows
+		naive.missed += t > periodMs + FRAME_PACER_MISS_MICROSECONDS / 1000.0 ? 1 : 0;
+	}
+	if (!times.empty()) {
+		naive.p50 = times[(times.size() - 1) / 2];
+		naive.p99 = times[(times.size() - 1) * 99 / 100];
+		naive.max = times.back();
+	}
+
+	printf("%d bodies at %g fps (%.3f ms) for %g s\n", bodies, rate, periodMs, seconds);
+	printf("%-8s %8s %8s %10s %10s %10s %10s\n", "pacing", "frames", "missed", "mean ms", "p50 ms", "p99 ms", "max ms");
+	PacingStats result = pacer.getStats();
+	print("pacer", result);
+	print("sleep", naive);
+	// without absolute bounds the sleeping loop on the same machine sets them
+	if (maxP99 <= 0) {
+		maxP99 = std::max(naive.p99, periodMs) * PACER_P99_FACTOR;
+	}
+	int allowedMissed = maxMissed >= 0 ? (int)(maxMissed * result.frames) : naive.missed + (int)(PACER_MAX_EXTRA_MISSED * result.frames);
+	printf("bounds: p99 %.3f ms, %d missed frames\n", maxP99, allowedMissed);
+	if (!(result.p99 <= maxP99) || result.missed > allowedMissed) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,190 @@
+// Fills a model with enemies and runs a frame's worth of each batched spatial
+// query against it: circles, boxes, k nearest and rays. Every tenth k nearest
+// query is asked from far outside the world. Checks a sample of every batch
+// against testing every body, then prints the time of a batch and the queries
+// per second. Exits with 1 if any query disagrees.
+//
+//   QueryBench [bodies] [queries]
+#include "Enemy.h"
+#include "Model.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#define QUERY_WIDTH 20000
+#define QUERY_HEIGHT 20000
+#define QUERY_MIN_WIDTH_HEIGHT 8
+#define QUERY_MAX_WIDTH_HEIGHT 40
+#define QUERY_MIN_RADIUS 20
+#define QUERY_MAX_RADIUS 100
+#define QUERY_MIN_BOX 20
+#define QUERY_MAX_BOX 200
+#define QUERY_NEAREST 8
+#define QUERY_RAY_LENGTH 500
+// how far from the world's center the outside nearest queries are asked
+#define QUERY_OUTSIDE_EVERY 10
+#define QUERY_OUTSIDE_DISTANCE 100000
+// queries of each batch checked against every body
+#define QUERY_CHECKED 500
+#define QUERY_PASSES 5
+#define QUERY_TOLERANCE 1e-3f
+
+static double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<int> sorted(const QueryResults& results, int query) {
+	std::vector<int> hits(results.begin(query), results.end(query));
+	std::sort(hits.begin(), hits.end());
+	return hits;
+}
+
+static float surfaceDistance(const Collider& c, Vector2 point) {
+	return getLength(c.getPos() - point) - c.getRadius();
+}
+
+// the same ray and circle test the grid makes, -1 for a miss
+static float rayDistance(const Ray& ray, const Collider& c) {
+	Vector2 oc = ray.origin - c.getPos();
+	float half = dot(oc, ray.direction);
+	float k = dot(oc, oc) - c.getRadius() * c.getRadius();
+	float disc = half * half - k;
+	if (disc < 0) {
+		return -1;
+	}
+	float t = k < 0 ? 0 : -half - std::sqrt(disc);
+	return t >= 0 && t < ray.maxDistance ? t : -1;
+}
+
+static void printRate(const char* name, double ms, int queries, int hits) {
+	printf("%-10s %12.3f %14.0f %12.1f\n", name, ms, queries / ms * 1000, (double)hits / queries);
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 100000;
+	int queries = argc > 2 ? atoi(argv[2]) : 10000;
+	std::mt19937 rng(30);
+	std::uniform_real_distribution<float> size(QUERY_MIN_WIDTH_HEIGHT, QUERY_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> x(0, QUERY_WIDTH);
+	std::uniform_real_distribution<float> y(0, QUERY_HEIGHT);
+	std::uniform_real_distribution<float> radius(QUERY_MIN_RADIUS, QUERY_MAX_RADIUS);
+	std::uniform_real_distribution<float> box(QUERY_MIN_BOX, QUERY_MAX_BOX);
+	std::uniform_real_distribution<float> angle(0, 6.2831853f);
+
+	Model m(QUERY_WIDTH, QUERY_HEIGHT);
+	std::vector<std::unique_ptr<Entity>> entities;
+	for (int i = 0; i < bodies; i++) {
+		float widthHeight = size(rng);
+		Collider c = Collider(Vector2{ x(rng), y(rng) }, Vector2(), widthHeight, widthHeight);
+		c.setLayer(LAYER_ENEMY);
+		entities.emplace_back(new Enemy(c, "enemy"));
+		m.addEntity(entities.back().get());
+	}
+
+	std::vector<CircleQuery> circles;
+	std::vector<AabbQuery> boxes;
+	std::vector<Vector2> points;
+	std::vector<Ray> rays;
+	for (int q = 0; q < queries; q++) {
+		circles.push_back(CircleQuery{ Vector2{ x(rng), y(rng) }, radius(rng) });
+		Vector2 min{ x(rng), y(rng) };
+		boxes.push_back(AabbQuery{ min, min + Vector2{ box(rng), box(rng) } });
+		if (q % QUERY_OUTSIDE_EVERY == 0) {
+			float a = angle(rng);
+			points.push_back(Vector2{ QUERY_WIDTH / 2.0f, QUERY_HEIGHT / 2.0f } + Vector2{ std::cos(a), std::sin(a) } * QUERY_OUTSIDE_DISTANCE);
+		}
+		else {
+			points.push_back(Vector2{ x(rng), y(rng) });
+		}
+		float a = angle(rng);
+		rays.push_back(Ray{ Vector2{ x(rng), y(rng) }, Vector2{ std::cos(a), std::sin(a) }, QUERY_RAY_LENGTH });
+	}
+
+	QueryResults circleHits, boxHits, nearest;
+	std::vector<RayHit> rayHits;
+	double circleMs = 0, boxMs = 0, nearestMs = 0, rayMs = 0;
+	for (int pass = 0; pass < QUERY_PASSES; pass++) {
+		auto start = std::chrono::steady_clock::now();
+		m.queryCircles(circles, circleHits);
+		circleMs += since(start);
+		start = std::chrono::steady_clock::now();
+		m.queryAabbs(boxes, boxHits);
+		boxMs += since(start);
+		start = std::chrono::steady_clock::now();
+		m.queryNearest(points, QUERY_NEAREST, nearest);
+		nearestMs += since(start);
+		start = std::chrono::steady_clock::now();
+		m.raycast(rays, rayHits);
+		rayMs += since(start);
+	}
+
+	int checked = std::min(queries, QUERY_CHECKED);
+	int wrong = 0;
+	int rayCount = 0;
+	for (int q = 0; q < checked; q++) {
+		std::vector<int> inCircle, inBox;
+		std::vector<float> distances;
+		float bestRay = -1;
+		for (int i = 0; i < bodies; i++) {
+			const Collider& c = *m.getEntity(i)->getCollider();
+			Vector2 d = c.getPos() - circles[q].center;
+			float reach = circles[q].radius + c.getRadius();
+			if (dot(d, d) < reach * reach) {
+				inCircle.push_back(i);
+			}
+			float cx = std::min(std::max(c.getPos().X, boxes[q].min.X), boxes[q].max.X);
+			float cy = std::min(std::max(c.getPos().Y, boxes[q].min.Y), boxes[q].max.Y);
+			Vector2 e = c.getPos() - Vector2{ cx, cy };
+			if (dot(e, e) < c.getRadius() * c.getRadius()) {
+				inBox.push_back(i);
+			}
+			distances.push_back(surfaceDistance(c, points[q]));
+			float t = rayDistance(rays[q], c);
+			if (t >= 0 && (bestRay < 0 || t < bestRay)) {
+				bestRay = t;
+			}
+		}
+		bool same = sorted(circleHits, q) == inCircle && sorted(boxHits, q) == inBox;
+
+		// ties may pick different bodies, so compare the distances, relative to
+		// their size for the queries from outside
+		std::partial_sort(distances.begin(), distances.begin() + std::min(QUERY_NEAREST, bodies), distances.end());
+		std::vector<float> found;
+		for (const int* i = nearest.begin(q); i != nearest.end(q); i++) {
+			found.push_back(surfaceDistance(*m.getEntity(*i)->getCollider(), points[q]));
+		}
+		std::sort(found.begin(), found.end());
+		same = same && found.size() == std::min(QUERY_NEAREST, bodies);
+		for (int k = 0; same && k < found.size(); k++) {
+			same = std::abs(found[k] - distances[k]) <= QUERY_TOLERANCE * std::max(1.0f, std::abs(distances[k]));
+		}
+
+		const RayHit& hit = rayHits[q];
+		same = same && (hit.index >= 0) == (bestRay >= 0);
+		if (hit.index >= 0 && bestRay >= 0) {
+			same = same && std::abs(hit.distance - bestRay) <= QUERY_TOLERANCE;
+		}
+		wrong += same ? 0 : 1;
+	}
+	for (const RayHit& hit : rayHits) {
+		rayCount += hit.index >= 0 ? 1 : 0;
+	}
+
+	printf("%d bodies in %dx%d, %d queries of each kind\n", bodies, QUERY_WIDTH, QUERY_HEIGHT, queries);
+	printf("%-10s %12s %14s %12s\n", "query", "ms/batch", "queries/s", "hits/query");
+	printRate("circle", circleMs / QUERY_PASSES, queries, (int)circleHits.indices.size());
+	printRate("aabb", boxMs / QUERY_PASSES, queries, (int)boxHits.indices.size());
+	printRate("nearest", nearestMs / QUERY_PASSES, queries, (int)nearest.indices.size());
+	printRate("ray", rayMs / QUERY_PASSES, queries, rayCount);
+	printf("%d of %d checked queries disagree with testing every body\n", wrong, checked);
+	if (wrong > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
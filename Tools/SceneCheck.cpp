@@ -0,0 +1,199 @@
+// Checks Philox against the published known answers, then generates a large
+// scene on one thread and on the pool and checks the bodies are the same bit
+// for bit, that a smaller scene of the same seed is the start of the larger
+// one and that sizes and positions are spread evenly. A denser scene with
+// overlap rejection and some level geometry is checked for bodies that touch
+// each other or the geometry. Prints the generation rate of each step and,
+// given a path, writes the scene there in the colliders.txt format. Exits with
+// 1 on any failed check.
+//
+//   SceneCheck [bodies] [scene.txt]
+#include "Model.h"
+#include "SceneGenerator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#define SCENE_SEED 0x5EED0050ull
+#define SCENE_WIDTH 100000
+#define SCENE_HEIGHT 100000
+// the rejection scene is this fraction of the bodies in a world this much smaller
+#define SCENE_DENSE_FRACTION 0.1
+#define SCENE_DENSE_WIDTH 20000
+#define SCENE_DENSE_HEIGHT 20000
+#define SCENE_DENSE_SEGMENTS 200
+#define SCENE_BINS 16
+// chi-square with 15 degrees of freedom at p = 0.001
+#define SCENE_CHI_SQUARE_LIMIT 37.7
+
+struct KnownAnswer {
+	uint32_t counter[4];
+	uint32_t key[2];
+	uint32_t expected[4];
+};
+
+// from the Random123 distribution's kat_vectors
+static const KnownAnswer knownAnswers[] = {
+	{ { 0, 0, 0, 0 }, { 0, 0 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+	{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+	{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+};
+
+static bool sameBodies(const std::vector<SceneBody>& a, const std::vector<SceneBody>& b, size_t count) {
+	if (a.size() < count || b.size() < count) {
+		return false;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (memcmp(&a[i], &b[i], sizeof(SceneBody)) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static double chiSquare(const std::vector<int>& bins, int total) {
+	double expected = (double)total / bins.size();
+	double sum = 0;
+	for (int count : bins) {
+		sum += (count - expected) * (count - expected) / expected;
+	}
+	return sum;
+}
+
+static void printRate(const char* name, const SceneStats& stats, int threads) {
+	printf("%-24s %10d %8d %12.1f %14.0f\n", name, stats.bodies, threads, stats.milliseconds, stats.getBodiesPerSecond());
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 2000000;
+	int failures = 0;
+
+	for (const KnownAnswer& k : knownAnswers) {
+		uint32_t out[4];
+		philox(k.counter, k.key, out);
+		if (memcmp(out, k.expected, sizeof(out)) != 0) {
+			printf("philox(%08x, %08x) = %08x %08x %08x %08x, expected %08x %08x %08x %08x\n", k.counter[0], k.key[0],
+				out[0], out[1], out[2], out[3], k.expected[0], k.expected[1], k.expected[2], k.expected[3]);
+			failures++;
+		}
+	}
+
+	ThreadPool single(0);
+	ThreadPool pool;
+	SceneGenerator serial(single);
+	SceneGenerator parallel(pool);
+	SceneSettings settings;
+	settings.seed = SCENE_SEED;
+	settings.bodies = bodies;
+	settings.width = SCENE_WIDTH;
+	settings.height = SCENE_HEIGHT;
+	settings.minAxisVelocity = -60;
+
+	printf("%-24s %10s %8s %12s %14s\n", "scene", "bodies", "threads", "ms", "bodies/s");
+	serial.generate(settings);
+	printRate("random", serial.getStats(), 1);
+	parallel.generate(settings);
+	printRate("random", parallel.getStats(), pool.getThreadCount() + 1);
+	if (!sameBodies(serial.getBodies(), parallel.getBodies(), bodies)) {
+		printf("the scene on %d threads differs from the one on one thread\n", pool.getThreadCount() + 1);
+		failures++;
+	}
+	SceneGenerator prefix(pool);
+	SceneSettings half = settings;
+	half.bodies = bodies / 2;
+	prefix.generate(half);
+	if (!sameBodies(prefix.getBodies(), parallel.getBodies(), half.bodies)) {
+		printf("a scene of %d bodies is not the start of one of %d\n", half.bodies, bodies);
+		failures++;
+	}
+
+	std::vector<int> sizeBins(SCENE_BINS, 0);
+	std::vector<int> xBins(SCENE_BINS, 0);
+	for (const SceneBody& b : parallel.getBodies()) {
+		float sizeUnit = (b.size - settings.minSize) / (settings.maxSize - settings.minSize);
+		float xUnit = (b.pos.X - b.size / 2) / (settings.width - b.size);
+		sizeBins[std::min((int)(sizeUnit * SCENE_BINS), SCENE_BINS - 1)]++;
+		xBins[std::min((int)(xUnit * SCENE_BINS), SCENE_BINS - 1)]++;
+	}
+	double sizeChi = chiSquare(sizeBins, bodies);
+	double xChi = chiSquare(xBins, bodies);
+	printf("chi-square over %d bins: sizes %.1f, x %.1f (limit %.1f)\n", SCENE_BINS, sizeChi, xChi, SCENE_CHI_SQUARE_LIMIT);
+	if (sizeChi > SCENE_CHI_SQUARE_LIMIT || xChi > SCENE_CHI_SQUARE_LIMIT) {
+		failures++;
+	}
+
+	// a dense scene around level geometry, drawn again where bodies would overlap
+	std::vector<GeometryShape> shapes;
+	for (int i = 0; i < SCENE_DENSE_SEGMENTS; i++) {
+		SceneBody b = SceneGenerator::makeBody(settings, i, SCENE_MAX_ATTEMPTS);
+		Vector2 a{ b.pos.X / SCENE_WIDTH * SCENE_DENSE_WIDTH, b.pos.Y / SCENE_HEIGHT * SCENE_DENSE_HEIGHT };
+		shapes.push_back(GeometryShape{ GEOMETRY_SEGMENT, a, a + b.vel * 2, 0 });
+	}
+	StaticGeometry geometry(shapes);
+	SceneSettings dense = settings;
+	dense.bodies = (int)(bodies * SCENE_DENSE_FRACTION);
+	dense.width = SCENE_DENSE_WIDTH;
+	dense.height = SCENE_DENSE_HEIGHT;
+	dense.rejectOverlaps = true;
+	dense.geometry = &geometry;
+	serial.generate(dense);
+	printRate("rejecting overlaps", serial.getStats(), 1);
+	parallel.generate(dense);
+	printRate("rejecting overlaps", parallel.getStats(), pool.getThreadCount() + 1);
+	const SceneStats& stats = parallel.getStats();
+	printf("%d draws redrawn, %d bodies left out after %d rounds\n", stats.rejected, stats.dropped, stats.rounds);
+	if (serial.getBodies().size() != parallel.getBodies().size() || !sameBodies(serial.getBodies(), parallel.getBodies(), parallel.getBodies().size())) {
+		printf("the rejecting scene on %d threads differs from the one on one thread\n", pool.getThreadCount() + 1);
+		failures++;
+	}
+	SpatialGrid grid(dense.maxSize);
+	const std::vector<SceneBody>& placed = parallel.getBodies();
+	for (int i = 0; i < placed.size(); i++) {
+		grid.insert(i, placed[i].pos, placed[i].size / 2);
+	}
+	int touching = 0;
+	int onGeometry = 0;
+	std::vector<int> hits;
+	for (int i = 0; i < placed.size(); i++) {
+		hits.clear();
+		grid.queryCircle(placed[i].pos, placed[i].size / 2, hits);
+		touching += hits.size() > 1 ? 1 : 0;
+		onGeometry += geometry.overlaps(placed[i].pos, placed[i].size / 2) ? 1 : 0;
+	}
+	printf("%d bodies touch another body, %d touch the geometry\n", touching, onGeometry);
+	if (touching > 0 || onGeometry > 0) {
+		failures++;
+	}
+
+	Model m(SCENE_DENSE_WIDTH, SCENE_DENSE_HEIGHT);
+	auto start = std::chrono::steady_clock::now();
+	std::vector<Entity*> entities = parallel.addTo(m);
+	std::chrono::duration<double, std::milli> added = std::chrono::steady_clock::now() - start;
+	printf("added %d enemies to a model in %.1f ms\n", m.getEntityCount(), added.count());
+	for (Entity* e : entities) {
+		delete e;
+	}
+
+	if (argc > 2) {
+		start = std::chrono::steady_clock::now();
+		try {
+			parallel.writeFile(argv[2]);
+		}
+		catch (const char* error) {
+			printf("%s\n", error);
+			return EXIT_FAILURE;
+		}
+		std::chrono::duration<double, std::milli> written = std::chrono::steady_clock::now() - start;
+		printf("wrote %s in %.1f ms\n", argv[2], written.count());
+	}
+
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
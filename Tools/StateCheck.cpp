@@ -0,0 +1,152 @@
+// Steps a scene and streams it over loopback with StatePublisher to several
+// StateObservers in the same process: some from the start, one that joins half
+// way and one that stops reading for a while and has to catch up. After every
+// frame each reading observer has to hold the same frame as the publisher with
+// every position and velocity within half a quantization step. Prints the
+// bytes per frame per 1k bodies for keyframes and deltas next to the raw
+// float state, and exits with 1 on any mismatch.
+//
+//   StateCheck [bodies] [frames] [observers]
+#include "Enemy.h"
+#include "Model.h"
+#include "StateStream.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#define STATE_WIDTH 2000
+#define STATE_HEIGHT 2000
+#define STATE_MIN_WIDTH_HEIGHT 8
+#define STATE_MAX_WIDTH_HEIGHT 24
+#define STATE_MAX_AXIS_VELOCITY 60
+#define STATE_MASS_WIDTH_HEIGHT_RATIO 10
+#define STATE_TIMESTEP 0.01
+#define STATE_PAUSE_FRAMES 50
+#define STATE_RECEIVE_MILLISECONDS 1000
+
+// Reads until the observer holds the publisher's frame, false if it never does
+static bool catchUp(StateObserver& o, uint32_t frame) {
+	while (o.getFrame() != frame) {
+		if (!o.receive(STATE_RECEIVE_MILLISECONDS)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int compare(const StateObserver& o, const std::vector<Entity*>& entities) {
+	if (o.getPositions().size() != entities.size()) {
+		return (int)entities.size();
+	}
+	float tolerance = 0.5f / STATE_STREAM_SCALE + 1e-3f;
+	int wrong = 0;
+	for (int i = 0; i < entities.size(); i++) {
+		const Collider& c = *entities[i]->getCollider();
+		Vector2 p = o.getPositions()[i] - c.getPos();
+		Vector2 v = o.getVelocities()[i] - c.getVelocity();
+		if (std::abs(p.X) > tolerance || std::abs(p.Y) > tolerance || std::abs(v.X) > tolerance || std::abs(v.Y) > tolerance) {
+			wrong++;
+		}
+	}
+	return wrong;
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 1000;
+	int frames = argc > 2 ? atoi(argv[2]) : 300;
+	int observers = argc > 3 ? atoi(argv[3]) : 4;
+
+	Model m(STATE_WIDTH, STATE_HEIGHT);
+	std::vector<std::unique_ptr<Entity>> entities;
+	std::mt19937 rng(23);
+	std::uniform_real_distribution<float> size(STATE_MIN_WIDTH_HEIGHT, STATE_MAX_WIDTH_HEIGHT);
+	std::uniform_real_distribution<float> velocity(-STATE_MAX_AXIS_VELOCITY, STATE_MAX_AXIS_VELOCITY);
+	std::uniform_real_distribution<float> unit(0, 1);
+	for (int i = 0; i < bodies; i++) {
+		float widthHeight = size(rng);
+		Vector2 pos{ unit(rng) * (STATE_WIDTH - widthHeight) + widthHeight / 2, unit(rng) * (STATE_HEIGHT - widthHeight) + widthHeight / 2 };
+		Collider c = Collider(pos, Vector2{ velocity(rng), velocity(rng) }, widthHeight, widthHeight * STATE_MASS_WIDTH_HEIGHT_RATIO);
+		c.setLayer(LAYER_ENEMY);
+		entities.emplace_back(new Enemy(c, "enemy"));
+		m.addEntity(entities.back().get());
+	}
+
+	StatePublisher publisher;
+	if (!publisher.open(0)) {
+		printf("Could not open the publisher socket\n");
+		return EXIT_FAILURE;
+	}
+	// the last two are the late joiner and the one that pauses
+	std::vector<std::unique_ptr<StateObserver>> clients;
+	for (int i = 0; i < observers + 2; i++) {
+		clients.emplace_back(new StateObserver());
+		if (i != observers && !clients.back()->connect(publisher.getPort())) {
+			printf("Could not connect observer %d\n", i);
+			return EXIT_FAILURE;
+		}
+	}
+	StateObserver& late = *clients[observers];
+	StateObserver& paused = *clients[observers + 1];
+	int joinFrame = frames / 2;
+	int pauseFrom = frames / 4;
+
+	int failures = 0;
+	long long keyframeBytes = 0;
+	long long deltaBytes = 0;
+	int keyframes = 0;
+	int deltas = 0;
+	for (int f = 0; f < frames; f++) {
+		if (f == joinFrame) {
+			late.connect(publisher.getPort());
+		}
+		m.update(STATE_TIMESTEP, Vector2());
+		std::vector<Entity*> state = m.getEntities();
+		publisher.publish(state);
+		const PublishStats& stats = publisher.getStats();
+		keyframeBytes += stats.keyframeBytes;
+		deltaBytes += stats.deltaBytes;
+		keyframes += stats.keyframes;
+		deltas += stats.deltas;
+		for (int i = 0; i < clients.size(); i++) {
+			StateObserver& o = *clients[i];
+			bool reading = (&o != &late || f >= joinFrame) && (&o != &paused || f < pauseFrom || f >= pauseFrom + STATE_PAUSE_FRAMES);
+			if (!reading) {
+				continue;
+			}
+			if (!catchUp(o, publisher.getFrame())) {
+				printf("frame %d: observer %d stuck at frame %u of %u\n", f, i, o.getFrame(), publisher.getFrame());
+				failures++;
+				continue;
+			}
+			int wrong = compare(o, state);
+			if (wrong > 0) {
+				printf("frame %d: observer %d has %d bodies off by more than half a step\n", f, i, wrong);
+				failures++;
+			}
+		}
+	}
+
+	double perThousand = 1000.0 / bodies;
+	printf("%d bodies, %d frames, %d observers plus one joining at frame %d and one pausing %d frames\n",
+		bodies, frames, observers, joinFrame, STATE_PAUSE_FRAMES);
+	printf("%-9s %8s %22s\n", "encoding", "sent", "bytes/frame/1k bodies");
+	printf("%-9s %8s %22.0f\n", "raw", "-", (double)(4 * sizeof(float)) * 1000);
+	if (keyframes > 0) {
+		printf("%-9s %8d %22.0f\n", "keyframe", keyframes, (double)keyframeBytes / keyframes * perThousand);
+	}
+	if (deltas > 0) {
+		printf("%-9s %8d %22.0f\n", "delta", deltas, (double)deltaBytes / deltas * perThousand);
+	}
+	for (int i = 0; i < clients.size(); i++) {
+		const ObserveStats& s = clients[i]->getStats();
+		printf("observer %d: %d frames, %d incomplete, %d lost baselines, %lld bytes\n", i, s.frames, s.incomplete, s.lostBaselines, s.bytes);
+	}
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
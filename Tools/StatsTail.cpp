@@ -0,0 +1,75 @@
+// Reads the live stats a running game (or PacerCheck --stats) publishes in
+// shared memory and prints them, once or every interval. Tailing stops when
+// no new frame has been published for a few seconds.
+//
+//   StatsTail [--tail] [--interval ms] [--name segment]
+#include "StatsSegment.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#define STATS_TAIL_IDLE_SECONDS 5
+
+static void printHeader() {
+	printf("%10s %10s %9s %9s %9s %9s %7s %8s %12s %10s %8s %7s\n", "frame", "seconds", "frame ms", "work ms", "p50 ms", "p99 ms",
+		"missed", "bodies", "contacts/s", "contacts", "walls", "health");
+}
+
+static void printStats(const LiveStats& s) {
+	printf("%10llu %10.2f %9.3f %9.3f %9.3f %9.3f %7d %8d %12.0f %10llu %8llu %3d/%-3d\n", (unsigned long long)s.frame, s.seconds,
+		s.frameMilliseconds, s.workMilliseconds, s.getPercentile(0.5), s.getPercentile(0.99), s.missedDeadlines, s.bodies,
+		s.contactsPerSecond, (unsigned long long)s.totalContacts, (unsigned long long)s.totalWallHits, s.playerHealth, s.playerMaxHealth);
+}
+
+int main(int argc, char* argv[]) {
+	bool tail = false;
+	int interval = 1000;
+	const char* name = STATS_SEGMENT_NAME;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--tail") == 0) {
+			tail = true;
+		}
+		else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+			interval = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+			name = argv[++i];
+		}
+		else {
+			printf("usage: StatsTail [--tail] [--interval ms] [--name segment]\n");
+			return 2;
+		}
+	}
+
+	StatsReader reader;
+	if (!reader.open(name)) {
+		printf("Could not open stats segment %s\n", name);
+		return EXIT_FAILURE;
+	}
+	LiveStats stats;
+	if (!reader.read(stats)) {
+		printf("Could not read a consistent copy of %s\n", name);
+		return EXIT_FAILURE;
+	}
+	printHeader();
+	printStats(stats);
+	if (!tail) {
+		return 0;
+	}
+	uint64_t last = stats.frame;
+	auto heard = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - heard < std::chrono::seconds(STATS_TAIL_IDLE_SECONDS)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+		if (!reader.read(stats) || stats.frame == last) {
+			continue;
+		}
+		last = stats.frame;
+		heard = std::chrono::steady_clock::now();
+		printStats(stats);
+		fflush(stdout);
+	}
+	printf("no new frames for %d s\n", STATS_TAIL_IDLE_SECONDS);
+	return 0;
+}
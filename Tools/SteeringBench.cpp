@@ -0,0 +1,89 @@
+// Times one SteeringSystem pass over a crowd of agents seeking a target, on
+// the calling thread alone and on a pool sized to the machine, and prints the
+// time per pass, the time per 100k agents and the neighbors visited. Checks
+// that both give the same accelerations bit for bit and that none is past the
+// acceleration cap. Exits with 1 if not.
+//
+//   SteeringBench [agents] [passes]
+#include "Steering.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#define STEERING_WIDTH 10000
+#define STEERING_HEIGHT 10000
+#define STEERING_MAX_AXIS_VELOCITY 60
+#define STEERING_MIN_WIDTH_HEIGHT 8
+#define STEERING_MAX_WIDTH_HEIGHT 24
+// one in this many bodies is not an agent but still counts as a neighbor
+#define STEERING_OTHER_EVERY 10
+#define STEERING_TOLERANCE 1e-3f
+
+static double run(SteeringSystem& steering, const std::vector<int>& agents, const std::vector<char>& isAgent,
+	const std::vector<Vector2>& positions, const std::vector<Vector2>& velocities, const SpatialGrid& grid,
+	std::vector<Vector2>& accelerations, ThreadPool* pool, int passes) {
+	double best = 0;
+	for (int pass = 0; pass < passes; pass++) {
+		auto start = std::chrono::steady_clock::now();
+		steering.compute(agents, isAgent, positions, velocities, grid, Vector2{ STEERING_WIDTH / 2.0f, STEERING_HEIGHT / 2.0f }, accelerations, pool);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		best = pass == 0 ? ms : std::min(best, ms);
+	}
+	return best;
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 100000;
+	int passes = argc > 2 ? atoi(argv[2]) : 5;
+	std::mt19937 rng(31);
+	std::uniform_real_distribution<float> x(0, STEERING_WIDTH);
+	std::uniform_real_distribution<float> y(0, STEERING_HEIGHT);
+	std::uniform_real_distribution<float> velocity(-STEERING_MAX_AXIS_VELOCITY, STEERING_MAX_AXIS_VELOCITY);
+	std::uniform_real_distribution<float> size(STEERING_MIN_WIDTH_HEIGHT, STEERING_MAX_WIDTH_HEIGHT);
+
+	std::vector<Vector2> positions(bodies), velocities(bodies);
+	std::vector<char> isAgent(bodies);
+	std::vector<int> agents;
+	SpatialGrid grid;
+	for (int i = 0; i < bodies; i++) {
+		positions[i] = Vector2{ x(rng), y(rng) };
+		velocities[i] = Vector2{ velocity(rng), velocity(rng) };
+		isAgent[i] = i % STEERING_OTHER_EVERY != 0;
+		if (isAgent[i]) {
+			agents.push_back(i);
+		}
+		grid.insert(i, positions[i], size(rng) / 2);
+	}
+
+	ThreadPool single(0);
+	ThreadPool pool;
+	SteeringSystem steering;
+	std::vector<Vector2> serial, parallel;
+	double serialMs = run(steering, agents, isAgent, positions, velocities, grid, serial, &single, passes);
+	SteeringStats serialStats = steering.getStats();
+	double parallelMs = run(steering, agents, isAgent, positions, velocities, grid, parallel, &pool, passes);
+	SteeringStats parallelStats = steering.getStats();
+
+	int different = 0;
+	int overCap = 0;
+	float cap = steering.getSettings().maxAcceleration * (1 + STEERING_TOLERANCE);
+	for (int a = 0; a < agents.size(); a++) {
+		different += memcmp(&serial[a], &parallel[a], sizeof(Vector2)) != 0 ? 1 : 0;
+		overCap += !(getLength(parallel[a]) <= cap) ? 1 : 0;
+	}
+
+	printf("%d agents among %d bodies in %dx%d, best of %d passes\n", (int)agents.size(), bodies, STEERING_WIDTH, STEERING_HEIGHT, passes);
+	printf("%-10s %8s %12s %14s %14s\n", "run", "threads", "ms/pass", "ms/100k", "neighbors");
+	printf("%-10s %8d %12.2f %14.2f %14d\n", "serial", 1, serialMs, serialMs * 100000 / agents.size(), serialStats.neighborsVisited);
+	printf("%-10s %8d %12.2f %14.2f %14d\n", "pool", pool.getThreadCount() + 1, parallelMs, parallelMs * 100000 / agents.size(), parallelStats.neighborsVisited);
+	printf("%d accelerations differ between the runs, %d are past the cap\n", different, overCap);
+	if (different > 0 || overCap > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
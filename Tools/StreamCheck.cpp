@@ -0,0 +1,120 @@
+// Streams a large world through a model with WorldStore while the player flies
+// across it. Prints resident tiles, bodies in memory, I/O bytes and load
+// stalls as it goes. At the end everything is written back and the tile files
+// are read again: every body has to be on disk exactly once, in the tile its
+// center is in. Exits with 1 if not.
+//
+//   StreamCheck [bodies] [frames] [directory]
+#include "WorldStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#define STREAM_WIDTH 8192
+#define STREAM_HEIGHT 8192
+#define STREAM_MIN_WIDTH_HEIGHT 8
+#define STREAM_MAX_WIDTH_HEIGHT 24
+#define STREAM_MAX_AXIS_VELOCITY 60
+#define STREAM_MASS_WIDTH_HEIGHT_RATIO 10
+#define STREAM_TIMESTEP 0.01
+#define STREAM_PLAYER_SPEED 1500
+#define STREAM_REPORT_EVERY 100
+
+static void report(int frame, const StreamStats& stats, int entities) {
+	printf("%6d %9d %9d %9d %12lld %12lld %7d %10.2f %9d\n", frame, stats.residentTiles, stats.pendingLoads, entities,
+		stats.bytesRead, stats.bytesWritten, stats.stalls, stats.stallMilliseconds, stats.handedOver);
+}
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 20000;
+	int frames = argc > 2 ? atoi(argv[2]) : 600;
+	std::filesystem::path directory = argc > 3 ? std::filesystem::path(argv[3]) : std::filesystem::temp_directory_path() / "circlephysics_stream";
+	std::filesystem::remove_all(directory);
+
+	RuntimePhysics physics;
+	BasicModel<RuntimePhysics> m(STREAM_WIDTH, STREAM_HEIGHT, physics);
+	// the player flies diagonally and bounces off the walls, nothing hits it
+	Collider hitbox = Collider(Vector2{ 100, 100 }, Vector2{ STREAM_PLAYER_SPEED, STREAM_PLAYER_SPEED * 0.6f }, STREAM_MIN_WIDTH_HEIGHT, 1);
+	hitbox.setBodyType(BODY_KINEMATIC);
+	hitbox.setLayer(LAYER_PLAYER);
+	hitbox.setMask(0);
+	Player player(hitbox, "Player");
+	player.setLogging(false);
+	m.addEntity(&player);
+	m.setPlayer(&player);
+
+	int peakEntities = 0;
+	StreamStats stats;
+	{
+		WorldStore<RuntimePhysics> store(m, directory.string());
+		std::mt19937 rng(17);
+		std::uniform_real_distribution<float> size(STREAM_MIN_WIDTH_HEIGHT, STREAM_MAX_WIDTH_HEIGHT);
+		std::uniform_real_distribution<float> velocity(-STREAM_MAX_AXIS_VELOCITY, STREAM_MAX_AXIS_VELOCITY);
+		std::uniform_real_distribution<float> unit(0, 1);
+		std::vector<TileBody> world;
+		for (int i = 0; i < bodies; i++) {
+			float widthHeight = size(rng);
+			TileBody b = TileBody();
+			b.x = unit(rng) * (STREAM_WIDTH - widthHeight) + widthHeight / 2;
+			b.y = unit(rng) * (STREAM_HEIGHT - widthHeight) + widthHeight / 2;
+			b.vx = velocity(rng);
+			b.vy = velocity(rng);
+			b.size = widthHeight;
+			b.mass = widthHeight * STREAM_MASS_WIDTH_HEIGHT_RATIO;
+			b.layer = LAYER_ENEMY;
+			b.mask = 0xFFFFFFFFu;
+			b.color = 0x808080;
+			world.push_back(b);
+		}
+		store.addBodies(world);
+
+		printf("%d bodies in %dx%d, tiles of %g\n", bodies, STREAM_WIDTH, STREAM_HEIGHT, store.getSettings().tileSize);
+		printf("%6s %9s %9s %9s %12s %12s %7s %10s %9s\n", "frame", "resident", "loading", "in model", "bytes read", "bytes written", "stalls", "stall ms", "handed");
+		for (int f = 0; f < frames; f++) {
+			store.update(player.getCollider()->getPos());
+			m.update(STREAM_TIMESTEP, Vector2());
+			peakEntities = std::max(peakEntities, m.getEntityCount());
+			if (f % STREAM_REPORT_EVERY == 0) {
+				report(f, store.getStats(), m.getEntityCount());
+			}
+		}
+		store.flush();
+		stats = store.getStats();
+		report(frames, stats, m.getEntityCount());
+	}
+	printf("peak %d bodies in memory, %.1f%% of the world\n", peakEntities, 100.0 * peakEntities / bodies);
+
+	// every body back on disk once, in the tile its center is in
+	int found = 0;
+	int misplaced = 0;
+	float tileSize = StreamSettings().tileSize;
+	for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+		int x = 0;
+		int y = 0;
+		if (sscanf(entry.path().filename().string().c_str(), "tile_%d_%d.bin", &x, &y) != 2) {
+			continue;
+		}
+		std::ifstream in{ entry.path(), std::ios::in | std::ios::binary };
+		uint32_t header[2];
+		in.read((char*)header, sizeof(header));
+		TileBody b;
+		while (in.read((char*)&b, sizeof(b))) {
+			found++;
+			if ((int)std::floor(b.x / tileSize) != x || (int)std::floor(b.y / tileSize) != y) {
+				misplaced++;
+			}
+		}
+	}
+	printf("%d of %d bodies on disk, %d in the wrong tile\n", found, bodies, misplaced);
+	std::filesystem::remove_all(directory);
+	if (found != bodies || misplaced > 0 || m.getEntityCount() != 1) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,74 @@
+// Steps a scene of fast bodies at a 30 Hz frame with multirate substepping and
+// prints, for every frame, how many bodies took each power of two of substeps
+// (SubstepStats::histogram), the contacts found by the main pair pass and by
+// the substeps, and the kinetic energy. Exits with 1 if no body was ever
+// substepped.
+//
+//   SubstepTrace [bodies] [frames] [seed]
+#include "Enemy.h"
+#include "Model.h"
+#include "SceneGenerator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#define TRACE_WIDTH 500
+#define TRACE_HEIGHT 500
+#define TRACE_SPEED 180
+#define TRACE_TIMESTEP (1.0 / 30)
+
+int main(int argc, char* argv[]) {
+	int bodies = argc > 1 ? atoi(argv[1]) : 60;
+	int frames = argc > 2 ? atoi(argv[2]) : 60;
+	unsigned int seed = argc > 3 ? (unsigned int)atoi(argv[3]) : 1;
+	SceneSettings scene;
+	scene.seed = seed;
+	scene.bodies = bodies;
+	scene.width = TRACE_WIDTH;
+	scene.height = TRACE_HEIGHT;
+	scene.minAxisVelocity = -TRACE_SPEED;
+	scene.maxAxisVelocity = TRACE_SPEED;
+
+	RuntimePhysics physics;
+	physics.substepping = true;
+	std::vector<std::unique_ptr<Enemy>> entities;
+	BasicModel<RuntimePhysics> m(TRACE_WIDTH, TRACE_HEIGHT, physics);
+	NameId name = NamePool::intern("enemy");
+	for (int i = 0; i < bodies; i++) {
+		SceneBody b = SceneGenerator::makeBody(scene, i);
+		Collider c = Collider(b.pos, b.vel, b.size, b.mass);
+		c.setLayer(LAYER_ENEMY);
+		entities.push_back(std::make_unique<Enemy>(c, name));
+		m.addEntity(entities.back().get());
+	}
+
+	printf("%d bodies up to %d per axis, %d frames of %.4f s, up to %d substeps\n", bodies, TRACE_SPEED, frames, TRACE_TIMESTEP, physics.maxSubsteps);
+	printf("%-6s", "frame");
+	for (int b = 1; b <= physics.maxSubsteps; b *= 2) {
+		printf(" %5s%d", "x", b);
+	}
+	printf(" %10s %10s %12s\n", "main", "substep", "energy");
+	long long substepped = 0;
+	for (int f = 0; f < frames; f++) {
+		m.update(TRACE_TIMESTEP, Vector2());
+		const SubstepStats& stats = m.getSubstepStats();
+		double energy = 0;
+		for (const std::unique_ptr<Enemy>& e : entities) {
+			const Collider& c = *e->getCollider();
+			energy += 0.5 * c.getMass() * dot(c.getVelocity(), c.getVelocity());
+		}
+		printf("%-6d", f);
+		for (int count : stats.histogram) {
+			printf(" %6d", count);
+		}
+		printf(" %10d %10d %12.0f\n", m.getPairStats().contacts - stats.contacts, stats.contacts, energy);
+		substepped += stats.fastBodies;
+	}
+	if (substepped == 0) {
+		printf("no body was substepped\nFAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}
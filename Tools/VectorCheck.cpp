@@ -0,0 +1,132 @@
+// Checks every Vector2Batch operation lane by lane against the scalar Vector2
+// code, for 4, 8 and 16 lanes, and prints which backend was compiled in.
+#include "Vector2Batch.h"
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#define CHECK_VECTORS 4096
+// relative error allowed per lane, a few ulps for fused scalar multiply-adds
+#define CHECK_TOLERANCE 1e-6f
+
+static int failures = 0;
+
+// magnitude is what the error is measured against, |scalar| unless the result
+// comes from terms that can cancel
+static void expect(const char* what, int lanes, int index, float batch, float scalar, float magnitude = -1) {
+	bool same = batch == scalar || (std::isnan(batch) && std::isnan(scalar));
+	float scale = std::max(magnitude >= 0 ? magnitude : std::abs(scalar), 1e-30f);
+	if (!same && !(std::abs(batch - scalar) <= CHECK_TOLERANCE * scale)) {
+		if (failures < 20) {
+			printf("FAIL %s x%d at %d: batch %.9g scalar %.9g\n", what, lanes, index, batch, scalar);
+		}
+		failures++;
+	}
+}
+
+template <int N>
+static void check(const std::vector<Vector2>& a, const std::vector<Vector2>& b, const std::vector<float>& f) {
+	typedef Vector2Batch<N> Batch;
+	typedef std::function<Batch(const Batch&, const Batch&, const FloatBatch<N>&, float)> BatchOp;
+	typedef std::function<Vector2(Vector2, Vector2, float, float)> ScalarOp;
+	struct Case {
+		const char* name;
+		BatchOp batch;
+		ScalarOp scalar;
+	};
+	std::vector<Case> cases = {
+		{ "add", [](const Batch& x, const Batch& y, const FloatBatch<N>&, float) { return x + y; }, [](Vector2 x, Vector2 y, float, float) { return x + y; } },
+		{ "sub", [](const Batch& x, const Batch& y, const FloatBatch<N>&, float) { return x - y; }, [](Vector2 x, Vector2 y, float, float) { return x - y; } },
+		{ "mul", [](const Batch& x, const Batch& y, const FloatBatch<N>&, float) { return x * y; }, [](Vector2 x, Vector2 y, float, float) { return x * y; } },
+		{ "div", [](const Batch& x, const Batch& y, const FloatBatch<N>&, float) { return x / y; }, [](Vector2 x, Vector2 y, float, float) { return x / y; } },
+		{ "add float", [](const Batch& x, const Batch&, const FloatBatch<N>&, float s) { return x + s; }, [](Vector2 x, Vector2, float, float s) { return x + s; } },
+		{ "sub float", [](const Batch& x, const Batch&, const FloatBatch<N>&, float s) { return x - s; }, [](Vector2 x, Vector2, float, float s) { return x - s; } },
+		{ "mul float", [](const Batch& x, const Batch&, const FloatBatch<N>&, float s) { return x * s; }, [](Vector2 x, Vector2, float, float s) { return x * s; } },
+		{ "div float", [](const Batch& x, const Batch&, const FloatBatch<N>&, float s) { return x / s; }, [](Vector2 x, Vector2, float, float s) { return x / s; } },
+		{ "mul lanes", [](const Batch& x, const Batch&, const FloatBatch<N>& l, float) { return x * l; }, [](Vector2 x, Vector2, float l, float) { return x * l; } },
+		{ "div lanes", [](const Batch& x, const Batch&, const FloatBatch<N>& l, float) { return x / l; }, [](Vector2 x, Vector2, float l, float) { return x / l; } },
+		{ "add assign", [](const Batch& x, const Batch& y, const FloatBatch<N>&, float) { Batch r = x; r += y; return r; }, [](Vector2 x, Vector2 y, float, float) { Vector2 r = x; r += y; return r; } },
+		{ "sub assign", [](const Batch& x, const Batch& y, const FloatBatch<N>&, float) { Batch r = x; r -= y; return r; }, [](Vector2 x, Vector2 y, float, float) { Vector2 r = x; r -= y; return r; } },
+		{ "mul assign", [](const Batch& x, const Batch&, const FloatBatch<N>&, float s) { Batch r = x; r *= s; return r; }, [](Vector2 x, Vector2, float, float s) { Vector2 r = x; r *= s; return r; } },
+		{ "div assign", [](const Batch& x, const Batch& y, const FloatBatch<N>&, float) { Batch r = x; r /= y; return r; }, [](Vector2 x, Vector2 y, float, float) { Vector2 r = x; r /= y; return r; } },
+		{ "normalize", [](const Batch& x, const Batch&, const FloatBatch<N>&, float) { return normalize(x); }, [](Vector2 x, Vector2, float, float) { return x / getLength(x); } },
+	};
+
+	const float s = 1.75f;
+	for (int i = 0; i + N <= (int)a.size(); i += N) {
+		Batch x = Batch::load(&a[i]);
+		Batch y = Batch::load(&b[i]);
+		FloatBatch<N> lanes = FloatBatch<N>::load(&f[i]);
+		for (const Case& c : cases) {
+			Vector2 out[N];
+			c.batch(x, y, lanes, s).store(out);
+			for (int l = 0; l < N; l++) {
+				Vector2 expected = c.scalar(a[i + l], b[i + l], f[i + l], s);
+				expect(c.name, N, i + l, out[l].X, expected.X);
+				expect(c.name, N, i + l, out[l].Y, expected.Y);
+			}
+		}
+		float lengths[N], dots[N];
+		getLength(x).store(lengths);
+		dot(x, y).store(dots);
+		for (int l = 0; l < N; l++) {
+			expect("getLength", N, i + l, lengths[l], getLength(a[i + l]));
+			Vector2 terms = a[i + l] * b[i + l];
+			expect("dot", N, i + l, dots[l], dot(a[i + l], b[i + l]), std::abs(terms.X) + std::abs(terms.Y));
+			expect("get", N, i + l, x.get(l).X, a[i + l].X);
+		}
+	}
+
+	// the struct-of-arrays path and broadcast
+	std::vector<float> xs(a.size()), ys(a.size());
+	for (int i = 0; i < (int)a.size(); i++) {
+		xs[i] = a[i].X;
+		ys[i] = a[i].Y;
+	}
+	Batch soa = Batch::load(&xs[0], &ys[0]);
+	Batch one = Batch::broadcast(b[0]);
+	for (int l = 0; l < N; l++) {
+		expect("load soa", N, l, soa.get(l).Y, a[l].Y);
+		expect("broadcast", N, l, one.get(l).X, b[0].X);
+	}
+}
+
+int main() {
+#if defined(VECTOR2_BATCH_AVX512)
+	const char* backend = "SSE + AVX + AVX-512";
+#elif defined(VECTOR2_BATCH_AVX)
+	const char* backend = "SSE + AVX";
+#elif defined(VECTOR2_BATCH_SSE)
+	const char* backend = "SSE";
+#else
+	const char* backend = "scalar";
+#endif
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> value(-1000, 1000);
+	std::uniform_real_distribution<float> scale(0.1f, 10);
+	std::vector<Vector2> a(CHECK_VECTORS), b(CHECK_VECTORS);
+	std::vector<float> f(CHECK_VECTORS);
+	for (int i = 0; i < CHECK_VECTORS; i++) {
+		a[i] = Vector2{ value(rng), value(rng) };
+		b[i] = Vector2{ value(rng), value(rng) };
+		f[i] = scale(rng);
+	}
+	// edge cases: zero vectors (NaN on normalize), tiny and huge components
+	a[0] = Vector2();
+	a[1] = Vector2{ 1e-20f, -1e-20f };
+	a[2] = Vector2{ 3e18f, 4e18f };
+	b[3] = Vector2{ -0.0f, 0.0f };
+
+	check<4>(a, b, f);
+	check<8>(a, b, f);
+	check<16>(a, b, f);
+	printf("backend %s, %d vectors, %d mismatches\n", backend, CHECK_VECTORS, failures);
+	if (failures > 0) {
+		printf("FAIL\n");
+		return EXIT_FAILURE;
+	}
+	printf("PASS\n");
+	return 0;
+}